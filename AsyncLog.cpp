@@ -0,0 +1,106 @@
+#include "ControllerInput.h"
+#include <cstdarg>
+
+// ========== Async Log Implementation ==========
+
+void LogRing::write(LogLevel level, const char* format, ...) {
+    uint32_t index = head.load(std::memory_order_relaxed);
+    if (index - tail.load(std::memory_order_acquire) >= CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    // Format in place - the slot is ours until head is published
+    Record& record = records[index & (CAPACITY - 1)];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(record.text, RECORD_CHARS, format, args);
+    va_end(args);
+    if (length < 0) length = 0;
+    if (length >= RECORD_CHARS) length = RECORD_CHARS - 1;
+    record.level = level;
+    record.length = length;
+    head.store(index + 1, std::memory_order_release);
+}
+
+bool LogRing::read(Record& record) {
+    uint32_t index = tail.load(std::memory_order_relaxed);
+    if (index == head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const Record& slot = records[index & (CAPACITY - 1)];
+    record.level = slot.level;
+    record.length = slot.length;
+    memcpy(record.text, slot.text, slot.length + 1);
+    tail.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+void AsyncLog::start(const std::string& filePath) {
+    if (running) return;
+    if (!filePath.empty() && fopen_s(&file, filePath.c_str(), "a") != 0) {
+        file = nullptr;
+        std::cerr << "[ERROR] Failed to open log file: " << filePath << std::endl;
+    }
+    running = true;
+    drainThread = std::thread(&AsyncLog::drainLoop, this);
+}
+
+void AsyncLog::stop() {
+    if (!running) return;
+    running = false;
+    if (drainThread.joinable()) {
+        drainThread.join();
+    }
+    drainOnce();  // Whatever the producers wrote after the last pass
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+void AsyncLog::drainLoop() {
+    // Producers never signal - a short sleep between passes keeps them syscall-free
+    while (running) {
+        if (!drainOnce()) {
+            Sleep(DRAIN_INTERVAL_MS);
+        }
+    }
+}
+
+bool AsyncLog::drainOnce() {
+    LogRing::Record record;
+    bool wrote = false;
+    LogRing* rings[] = { &poll, &overlay };
+    for (LogRing* ring : rings) {
+        while (ring->read(record)) {
+            writeLine(record.level, record.text, record.length);
+            wrote = true;
+        }
+        uint32_t dropped = ring->takeDropped();
+        if (dropped) {
+            char text[64];
+            int length = sprintf_s(text, "(%u log records dropped - ring full)", dropped);
+            writeLine(LogLevel::Warning, text, length);
+            wrote = true;
+        }
+    }
+    if (wrote) {
+        fflush(stdout);
+        if (file) fflush(file);
+    }
+    return wrote;
+}
+
+void AsyncLog::writeLine(LogLevel level, const char* text, int length) {
+    static const char* const prefixes[] = { "", "", "[WARN] ", "[ERROR] " };
+    const char* prefix = prefixes[(int)level];
+    fputs(prefix, stdout);
+    fwrite(text, 1, length, stdout);
+    fputc('\n', stdout);
+    if (file) {
+        fputs(prefix, file);
+        fwrite(text, 1, length, file);
+        fputc('\n', file);
+    }
+}
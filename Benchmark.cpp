@@ -0,0 +1,170 @@
+#include "ControllerInput.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// ========== Touch Pipeline Microbenchmarks ==========
+// Built only into ControllerBench.exe (build.bat bench), which links this file in
+// place of main.cpp. Every function is timed in isolation on a fully set up
+// ControllerMapper: touch injection goes through the replay no-op path and the
+// overlay is drawn into a memory DC instead of the window.
+
+// Counts every C++ heap allocation in the process - replacing the global operator
+// new is only done here, never in ControllerInput.exe. WinRT objects allocated
+// inside system DLLs are not seen.
+static std::atomic<uint64_t> g_allocationCount{ 0 };
+
+void* operator new(size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// Results are written here so the optimizer can't drop the timed calls
+static volatile LONGLONG g_benchSink = 0;
+
+static const int BENCH_PATH_POINTS = 1024;  // Stick positions the benchmarks cycle through
+
+// Warms up, then runs body(i) for i = 0..iterations-1 and prints ns and heap
+// allocations per call
+template <typename Body>
+static void runBenchmark(const char* name, int iterations, Body body) {
+    for (int i = 0; i < iterations / 10; i++) {
+        body(i);
+    }
+
+    uint64_t allocationsBefore = g_allocationCount.load(std::memory_order_relaxed);
+    LONGLONG start = qpcNow();
+    for (int i = 0; i < iterations; i++) {
+        body(i);
+    }
+    LONGLONG elapsed = qpcNow() - start;
+    uint64_t allocations = g_allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+    double nsPerCall = elapsed * 1000000000.0 / qpcFrequency() / iterations;
+    printf("  %-28s %10d calls %10.1f ns/call %8.3f allocs/call\n",
+           name, iterations, nsPerCall, (double)allocations / iterations);
+}
+
+void ControllerMapper::runBenchmarks() {
+    // Same setup as a replay session: real monitor topology and overlay, no injector
+    replaying = true;
+    currentMode = InputMode::Touch;
+    if (!replayPath.empty() && !loadRecording()) {
+        return;
+    }
+    currentMode = InputMode::Touch;  // Whatever the recording's mode, the touch path is measured
+    detectMonitorFromCursor(true);
+    createOverlay();
+    if (!overlayHwnd || !inputInjectorInitialized) {
+        logError("Benchmark setup failed - no overlay or touch pipeline");
+        return;
+    }
+
+    // One lap around the stick's outer edge with some radius variation
+    double pathX[BENCH_PATH_POINTS], pathY[BENCH_PATH_POINTS];
+    for (int i = 0; i < BENCH_PATH_POINTS; i++) {
+        double angle = 2.0 * PI * i / BENCH_PATH_POINTS;
+        double radius = 0.6 + 0.4 * ((i * 7) % 11) / 10.0;
+        pathX[i] = radius * sin(angle);
+        pathY[i] = radius * cos(angle);
+    }
+    auto pathIndex = [](int i) { return i & (BENCH_PATH_POINTS - 1); };
+
+    printf("\nTouch pipeline benchmarks (%s)\n", replayPath.empty() ? "synthetic input" : replayPath.c_str());
+
+    runBenchmark("getTouchCoordinates", 2000000, [&](int i) {
+        LONG x, y;
+        getTouchCoordinates(pathX[pathIndex(i)], pathY[pathIndex(i)], x, y);
+        g_benchSink += x + y;
+    });
+
+    runBenchmark("createTouchInfo", 1000000, [&](int i) {
+        InjectedInputTouchInfo info = createTouchInfo(i & 1, pathX[pathIndex(i)], pathY[pathIndex(i)], false, false);
+        g_benchSink += info.PointerInfo().PixelLocation.PositionX;
+    });
+
+    runBenchmark("calculateLockedPosition", 2000000, [&](int i) {
+        // Held direction, locked to one of its neighbours
+        int held = i & 7;
+        int locked = (held + (((i >> 3) & 1) ? 1 : 7)) & 7;
+        double lockedX, lockedY;
+        calculateLockedPosition(held, locked, pathX[pathIndex(i)], pathY[pathIndex(i)], lockedX, lockedY);
+        g_benchSink += (LONGLONG)(lockedX * 1000.0 + lockedY * 1000.0);
+    });
+
+    runBenchmark("checkPointerLock", 2000000, [&](int i) {
+        double x = pathX[pathIndex(i)], y = pathY[pathIndex(i)];
+        int lockedDirection = -1;
+        bool locked = checkPointerLock(i & 7, getStickDirection(x, y), x, y, lockedDirection);
+        g_benchSink += locked + lockedDirection;
+    });
+
+    // Down, eight moves, up - flushed like the end of a sample, so each call is a whole palm frame
+    runBenchmark("sendPalmTouch + flush", 200000, [&](int i) {
+        int phase = i % 10;
+        sendPalmTouch(pathX[pathIndex(i)] * 0.5, pathY[pathIndex(i)] * 0.5, 10, 11, phase == 0, phase == 9);
+        flushTouchFrame();
+    });
+
+    // Whole touch frames as the polling thread runs them, from the recording if one was given
+    ControllerSample sample = {};
+    ControllerSlot* slot = &controllers[0];
+    int frameCount = replaySamples.empty() ? 200000 : (int)replaySamples.size();
+    runBenchmark("processSample (touch frame)", frameCount, [&](int i) {
+        if (!replaySamples.empty()) {
+            slot = &controllers[sampleFromRecorded(replaySamples[i % replaySamples.size()], sample)];
+        } else {
+            // Both touches held, a lock on L2 now and then and a palm on L3 every second lap
+            sample.leftX = pathX[pathIndex(i)];
+            sample.leftY = pathY[pathIndex(i)];
+            sample.rightX = -pathX[pathIndex(i + 300)];
+            sample.rightY = pathY[pathIndex(i + 300)];
+            sample.l1 = sample.r1 = true;
+            sample.l2 = (i & 2047) >= 1536;
+            sample.l3 = (i & 4095) < 256;
+        }
+        sample.timestamp = qpcNow();
+        processSample(*slot, sample);
+    });
+
+    // Draw the state those frames left behind, full client area each time
+    paintSnapshot = pollOverlay;
+    RECT client;
+    GetClientRect(overlayHwnd, &client);
+    DibSurface target;
+    if (target.ensure(client.right, client.bottom)) {
+        runBenchmark("drawOverlay (memory DC)", 2000, [&](int) {
+            drawOverlay(target.dc, client, nullptr);
+        });
+    } else {
+        logError("Could not create the memory DC for drawOverlay");
+    }
+
+    printf("\nAllocation counts cover C++ operator new only.\n");
+}
+
+int main(int argc, char* argv[]) {
+    // ControllerBench.exe [recording.cimr] - a recording replaces the synthetic touch frames
+    MapperSettings settings;
+    settings.mode = InputMode::Touch;
+    settings.overlayBackend = OverlayBackend::ColorKeyGdi;  // drawOverlay is the WM_PAINT path
+    if (argc > 1) {
+        settings.replayPath = argv[1];
+    }
+
+    ControllerMapper mapper(settings);
+    mapper.runBenchmarks();
+    return 0;
+}
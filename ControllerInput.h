@@ -11,7 +11,25 @@
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <memory>
 #include <conio.h>
+#include <mmsystem.h>
+#include <avrt.h>
+#include <setupapi.h>
+#include <hidsdi.h>
+#include <d3d11.h>
+#include <dxgi1_3.h>
+#include <d2d1_1.h>
+#include <dwrite.h>
+#include <dcomp.h>
+#include <dwmapi.h>
 
 // C++/WinRT includes for UWP InputInjector (Touch mode)
 #include <winrt/Windows.Foundation.h>
@@ -23,6 +41,16 @@
 #pragma comment(lib, "xinput.lib")
 #pragma comment(lib, "gdi32.lib")
 #pragma comment(lib, "msimg32.lib")
+#pragma comment(lib, "winmm.lib")      // timeBeginPeriod for the polling thread
+#pragma comment(lib, "avrt.lib")       // MMCSS thread registration
+#pragma comment(lib, "hid.lib")        // DualShock 4 HID reports
+#pragma comment(lib, "setupapi.lib")   // HID device enumeration
+#pragma comment(lib, "d3d11.lib")      // GPU overlay
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d2d1.lib")
+#pragma comment(lib, "dwrite.lib")
+#pragma comment(lib, "dcomp.lib")
+#pragma comment(lib, "dwmapi.lib")
 #pragma comment(lib, "windowsapp.lib")  // For UWP InputInjector
 
 using namespace winrt;
@@ -33,8 +61,9 @@ using namespace Windows::UI::Input::Preview::Injection;
 // ============================================
 
 enum class ControllerType {
-    XInput,       // Xbox controllers (Xbox 360, One, Series)
-    DirectInput   // Generic DirectInput controllers
+    XInput,        // Xbox controllers (Xbox 360, One, Series)
+    DirectInput,   // Generic DirectInput controllers
+    DualShock4Hid  // DualShock 4 read directly from its HID input reports
 };
 
 enum class InputMode {
@@ -43,13 +72,724 @@ enum class InputMode {
     Keyboard    // Number keys 1-8 based on stick direction
 };
 
+// How the 9 contacts of an L3/R3 palm go down and up
+enum class PalmInjectionMode {
+    Atomic,      // All contacts in one pointer frame
+    Staggered,   // One contact per frame, fixed microsecond spin between them
+    Serialized   // One contact per frame with Sleep(0) between them (legacy behavior)
+};
+
+// How the overlay window is composed
+enum class OverlayBackend {
+    LayeredAlpha,  // Premultiplied-ARGB DIB pushed with UpdateLayeredWindowIndirect (real fades)
+    ColorKeyGdi,   // WM_PAINT into a black-keyed layered window (legacy)
+    GpuComposition // Direct2D on a DirectComposition swap chain, presented on vblank
+};
+
+// Transition queued for one touch contact in the current injection frame
+enum class TouchPhase {
+    Down,
+    Update,
+    Up
+};
+
+// Controllers polled together, each with its own overlay ring and block of touch IDs
+constexpr int MAX_CONTROLLERS = 4;
+constexpr int TOUCHES_PER_CONTROLLER = 20;  // Controller n injects touch IDs 20n..20n+19
+constexpr int MAX_TOUCH_IDS = MAX_CONTROLLERS * TOUCHES_PER_CONTROLLER;
+
+struct TouchFrameEntry {
+    bool pending = false;
+    TouchPhase phase = TouchPhase::Update;
+    double x = 0.0, y = 0.0;  // Stick coordinates
+};
+
+// Stick conditioning between the raw read and the mode handlers. The defaults leave
+// the sticks as the controller reports them
+struct StickConditioning {
+    double radialDeadzone = 0.0;  // Stick radius that still reads as centred
+    double axialDeadzone = 0.0;   // Per-axis deadzone, for sticks that drift along one axis
+    double antiDeadzone = 0.0;    // Output radius just past the deadzone (cancels a game's own deadzone)
+    double outerDeadzone = 0.0;   // Radius that already reads as full deflection, 0 = no clamp
+    double curve = 1.0;           // Response exponent over the live range (>1 = finer near the centre)
+    int triggerThreshold = 128;   // XInput analog trigger value above which L2/R2 count as pressed
+};
+
+// DirectInput button numbers read as L1, R1, L2, R2, L3, R3 (defaults fit DS4-style pads)
+struct DirectInputButtonMap {
+    BYTE l1 = 4, r1 = 5, l2 = 6, r2 = 7, l3 = 10, r3 = 11;
+};
+
+// Keyboard mode layout - what each stick sector presses while its bumper is held. A
+// layout file is compiled into these once at load; the input path only indexes them.
+enum class SectorActionType : uint8_t {
+    None,         // Sector does nothing
+    Key,          // Keyboard key
+    MouseButton   // Mouse button, held like a key
+};
+
+struct SectorAction {
+    SectorActionType type = SectorActionType::None;
+    WORD virtualKey = 0;    // Key: VK code; MouseButton: VK_LBUTTON/VK_RBUTTON/VK_MBUTTON
+    WORD scanCode = 0;      // Key: looked up when the layout is compiled
+    DWORD downFlags = 0;    // MouseButton: MOUSEEVENTF_*DOWN
+    DWORD upFlags = 0;      // MouseButton: MOUSEEVENTF_*UP
+    char label[12] = {};    // Debug panel name
+};
+
+struct SectorLayout {
+    SectorAction left[8];   // L1 + left stick, by direction
+    SectorAction right[8];  // R1 + right stick, by direction
+};
+
 struct ControllerInfo {
     ControllerType type;
     std::string name;
     DWORD index;  // Used for XInput controllers
     GUID guid;    // Used for DirectInput controllers
+    std::string devicePath;  // Used for DualShock 4 HID controllers
+};
+
+struct MapperSettings {
+    InputMode mode = InputMode::Touch;
+    int pollRateHz = 1000;  // Controller polling/injection rate (250, 500 or 1000 Hz)
+    bool bufferedDirectInput = true;  // Event-driven buffered reads for DirectInput controllers
+    PalmInjectionMode palmMode = PalmInjectionMode::Atomic;
+    int palmStaggerUs = 250;          // Gap between palm contacts in Staggered mode
+    int predictionMs = 0;             // Touch mode slide look-ahead, 0 = off (--predict)
+    int touchUpsampleHz = 0;          // Touch mode update rate between controller reports, 0 = off (--upsample)
+    int idleMs = 2000;                // Neutral input this long drops to the idle poll rate, 0 = never (--idle)
+    StickConditioning conditioning;   // Deadzones/response curve (--deadzone, --curve, ...)
+    DirectInputButtonMap diButtons;   // DirectInput buttons behind L1-R3 (--di-buttons)
+    std::string layoutPath;           // Keyboard mode layout file, empty = 1-8 on both sticks (--layout)
+    std::vector<ControllerInfo> profileControllers;  // Opened directly instead of the controller menu
+    std::string profilePath;          // Save the session setup here once the menus picked the controllers
+    OverlayBackend overlayBackend = OverlayBackend::LayeredAlpha;
+    int debugRefreshHz = 20;          // Debug panel text refresh rate (text changes are rarely readable faster)
+    std::string recordPath;           // Record every processed sample to this file (--record)
+    std::string replayPath;           // Feed a recording instead of a controller, no injection (--replay)
+    bool replayFullSpeed = false;     // Replay as fast as possible instead of at the recorded timing
+    std::string logPath;              // Also append polling/overlay thread log lines to this file (--log)
+};
+
+// One controller read, normalized to the same ranges for every controller type
+struct ControllerSample {
+    bool l1, r1, l2, r2, l3, r3;
+    double leftX, leftY;    // Left stick (-1.0 to 1.0)
+    double rightX, rightY;  // Right stick (-1.0 to 1.0)
+    LONGLONG timestamp;     // QPC time the input was read (monotonic per controller)
+};
+
+// Recording file layout (InputReplay.cpp): header, then sampleCount samples
+#pragma pack(push, 1)
+struct RecordingHeader {
+    char magic[4];         // "CIMR"
+    uint16_t version;
+    uint8_t mode;          // InputMode the session was recorded in
+    uint8_t reserved;
+    uint32_t sampleCount;
+};
+
+struct RecordedSample {
+    uint64_t timeUs;       // Since the first recorded sample
+    float leftX, leftY, rightX, rightY;
+    uint8_t buttons;       // Bits 0-5: L1, R1, L2, R2, L3, R3; bits 6-7: controller index
+};
+
+// Profile file layout (Profile.cpp): header, then controllerCount controllers
+struct ProfileHeader {
+    char magic[4];         // "CIMP"
+    uint16_t version;
+    uint8_t mode;          // InputMode
+    uint8_t palmMode;      // PalmInjectionMode
+    uint8_t overlayBackend;
+    uint8_t controllerCount;
+    uint8_t bufferedDirectInput;
+    uint8_t diButtons[6];  // DirectInputButtonMap, L1 to R3
+    uint8_t reserved;
+    int32_t pollRateHz;
+    int32_t palmStaggerUs;
+    int32_t predictionMs;
+    int32_t touchUpsampleHz;
+    int32_t idleMs;
+    double radialDeadzone, axialDeadzone, antiDeadzone, outerDeadzone, curve;
+    int32_t triggerThreshold;
+    char layoutPath[MAX_PATH];  // Keyboard mode layout file, empty = default
+};
+
+struct ProfileController {
+    uint8_t type;          // ControllerType
+    uint8_t xInputIndex;
+    GUID guid;             // DirectInput instance GUID
+    char devicePath[MAX_PATH];  // DualShock 4 HID path
+    char name[64];
+};
+#pragma pack(pop)
+
+// Everything the renderer needs for one controller's ring, fully derived on the polling
+// thread (alphas, directions, deadzone) so painting never recomputes it. Plain data,
+// laid out without internal padding, so it goes through a SeqLock and compares with memcmp.
+struct RingSnapshot {
+    double leftX = 0.0, leftY = 0.0, rightX = 0.0, rightY = 0.0;
+    double leftLockedX = 0.0, leftLockedY = 0.0, rightLockedX = 0.0, rightLockedY = 0.0;
+    double l3CenterX = 0.0, l3CenterY = 0.0, r3CenterX = 0.0, r3CenterY = 0.0;
+    double touchX[TOUCHES_PER_CONTROLLER] = {};  // Indexed by touch ID - touchIdBase
+    double touchY[TOUCHES_PER_CONTROLLER] = {};
+    int leftAlpha = 0, rightAlpha = 0;
+    int leftLockedAlpha = 0, rightLockedAlpha = 0;
+    int l3Alpha = 0, r3Alpha = 0;
+    int leftDirection = -1, rightDirection = -1;        // 0-7, -1 = centred
+    int touchIdBase = 0;                                // First touch ID of this controller (labels)
+    bool leftStickMoved = false, rightStickMoved = false;  // Past the direction-indicator deadzone
+    bool leftTouchActive = false, rightTouchActive = false;
+    bool l3TouchActive = false, r3TouchActive = false;
+    bool touchActive[TOUCHES_PER_CONTROLLER] = {};
+    bool reserved[2] = {};                              // Explicit tail padding
+};
+
+// One frame of the whole overlay: a ring per controller, side by side
+struct OverlaySnapshot {
+    RingSnapshot rings[MAX_CONTROLLERS];
+    int ringCount = 1;
+    int reserved = 0;
+    LONGLONG sampleTicks = 0;  // Timestamp of the controller sample this state came from (not compared)
+    
+    // True when both would paint the same frame
+    bool sameContent(const OverlaySnapshot& other) const {
+        return std::memcmp(this, &other, offsetof(OverlaySnapshot, sampleTicks)) == 0;
+    }
+};
+
+// Fixed-capacity text the debug panel is formatted into - never allocates
+struct DebugTextBuffer {
+    static constexpr int CAPACITY = 4096;
+    char text[CAPACITY] = {};
+    int length = 0;
+    
+    void clear() { length = 0; text[0] = '\0'; }
+    void append(const char* str);
+    void appendf(const char* format, ...);
+    bool sameAs(const DebugTextBuffer& other) const {
+        return length == other.length && std::memcmp(text, other.text, length) == 0;
+    }
+};
+
+// One axis of the stick -> injector-pixel mapping, precomputed from the monitor layout.
+// Reproduces InputInjector's "opposite monitor" routing without touching Win32 per touch.
+struct TouchAxisTransform {
+    LONG base = 0;       // Coordinate of the stick centre before mapping
+    LONG offset = 0;     // Added last (target monitor origin or routing offset)
+    double scale = 1.0;  // Current -> other monitor size ratio (mapped only)
+    LONG clampMax = 0;   // Mapped result is clamped to [0, clampMax]
+    bool mapped = false; // Scale and clamp into the other monitor's space
+    
+    LONG apply(LONG stickPixels) const {
+        LONG value = base + stickPixels;
+        if (mapped) {
+            value = (LONG)(value * scale);
+            if (value < 0) value = 0;
+            if (value > clampMax) value = clampMax;
+        }
+        return value + offset;
+    }
+};
+
+// Monitor layout, per-monitor display caps and overlay placement, rebuilt only on
+// display changes or overlay moves
+struct MonitorTopology {
+    static constexpr int MAX_MONITORS = 16;
+    struct Monitor {
+        HMONITOR handle;
+        LONG left, top, width, height;
+        bool isPrimary;
+        int dpiX, dpiY;      // Display DC LOGPIXELSX/Y (96 if unavailable)
+        int refreshRate;     // Display DC VREFRESH (60 if unavailable)
+        CHAR device[CCHDEVICENAME];  // e.g. \\.\DISPLAY1
+    };
+    Monitor monitors[MAX_MONITORS] = {};  // In EnumDisplayMonitors order
+    int monitorCount = 0;
+    int currentIndex = -1;  // Monitor the overlay is on
+    int otherIndex = -1;    // First monitor that isn't the current one
+    LONG overlayCenterX = 0, overlayCenterY = 0;  // Overlay centre in virtual screen coordinates
+    LONG ringOffsetX[MAX_CONTROLLERS] = {};       // Each controller's ring centre relative to overlayCenterX
+    LONG virtualLeft = 0, virtualTop = 0;          // Virtual screen, for absolute SendInput moves
+    LONG virtualWidth = 1, virtualHeight = 1;
+    int stickRadius = 0;
+    TouchAxisTransform touchXTransform, touchYTransform;
+};
+
+// Constant-velocity extrapolator for one stick. The velocity is the least-squares
+// slope over the recent samples, so one noisy read barely moves the prediction.
+class StickPredictor {
+public:
+    static constexpr int HISTORY = 8;            // Samples kept (8ms at 1000Hz, 32ms at 250Hz)
+    static constexpr double WINDOW_MS = 16.0;    // Older samples no longer describe the motion
+    static constexpr double MAX_GAP_MS = 50.0;   // A longer pause starts the history over
+    static constexpr double MAX_OFFSET = 0.35;   // Cap on the extrapolated distance (stick units)
+    
+    void add(double x, double y, LONGLONG ticks);
+    void predict(double lookaheadMs, double& x, double& y) const;  // In: latest sample, out: predicted
+    void reset() { count = 0; }
+
+private:
+    double xs[HISTORY] = {};
+    double ys[HISTORY] = {};
+    LONGLONG times[HISTORY] = {};
+    int next = 0;   // Slot the next sample goes into
+    int count = 0;  // Valid samples
+};
+
+// Stick conditioning compiled into lookup tables once, before polling starts. The axis
+// tables map every raw value of a backend to its normalized, axially deadzoned value in
+// 16-bit fixed point; the radial table maps the squared stick radius to a scale factor.
+// Conditioning a stick is one load per axis plus one for the radius - no sqrt or pow.
+class StickConditioner {
+public:
+    static constexpr double FIXED_ONE = 32767.0;        // Axis table value of full deflection
+    static constexpr int RADIAL_TABLE_SIZE = 4096;      // Entries over squared radius 0..MAX_RADIUS_SQUARED
+    static constexpr double MAX_RADIUS_SQUARED = 2.0;   // Both axes at full deflection
+    
+    void build(const StickConditioning& settings);
+    const StickConditioning& settings() const { return config; }
+    bool isIdentity() const { return !axialActive && !radialActive && config.triggerThreshold == 128; }
+    
+    // Normalized -1.0 to 1.0, positive right/up for XInput. DirectInput and DS4 Y axes
+    // point down, so callers negate those
+    double xInputAxis(SHORT raw) const { return xInputTable[raw + 32768] / FIXED_ONE; }
+    double directInputAxis(LONG raw) const { return directInputTable[raw < 0 ? 0 : (raw > 65535 ? 65535 : raw)] / FIXED_ONE; }
+    double ds4Axis(BYTE raw) const { return ds4Table[raw] / FIXED_ONE; }
+    bool triggerPressed(BYTE value) const { return value > config.triggerThreshold; }
+    
+    // Radial deadzone, anti-deadzone, outer clamp and curve on one stick's normalized axes
+    void applyRadial(double& x, double& y) const {
+        if (!radialActive) return;
+        int index = (int)((x * x + y * y) * ((RADIAL_TABLE_SIZE - 1) / MAX_RADIUS_SQUARED) + 0.5);
+        if (index >= RADIAL_TABLE_SIZE) index = RADIAL_TABLE_SIZE - 1;
+        x *= radialScale[index];
+        y *= radialScale[index];
+    }
+
+private:
+    double conditionRadius(double radius) const;
+    
+    StickConditioning config;
+    bool axialActive = false;
+    bool radialActive = false;               // Anything radial to apply - skipped entirely otherwise
+    std::vector<int16_t> xInputTable;        // Indexed by sThumb + 32768
+    std::vector<int16_t> directInputTable;   // Indexed by lX/lY/lZ/lRz (default 0-65535 range)
+    int16_t ds4Table[256] = {};
+    std::vector<float> radialScale;          // Output radius / input radius
+};
+
+// One connected controller: its input backend and its touch mapping state. All of
+// them live in one array on the mapper and are polled by the same thread.
+struct ControllerSlot {
+    int index = 0;                           // Position in ControllerMapper::controllers (= overlay ring)
+    int touchIdBase = 0;                     // index * TOUCHES_PER_CONTROLLER
+    ControllerType type = ControllerType::XInput;
+    ControllerInfo source = {};              // What was opened - written to the profile
+    
+    // XInput
+    DWORD xInputIndex = 0;
+    
+    // DirectInput - buffered: edges are read from the device buffer on event
+    // notification so presses shorter than a poll period still arrive, in order
+    LPDIRECTINPUTDEVICE8 joystick = nullptr;
+    bool diBuffered = false;                 // Buffer + event notification active for joystick
+    HANDLE diEvent = nullptr;                // Signalled by DirectInput when new data is buffered
+    DIJOYSTATE2 diBufferedState = {};        // Running device state rebuilt from buffered events
+    DWORD diBufferOverflows = 0;             // Times the buffer overflowed and state was resynced
+    
+    // DualShock 4 HID: one overlapped ReadFile always outstanding, completion signals ds4ReadEvent
+    HANDLE ds4Handle = nullptr;              // HID device handle (nullptr when not in use)
+    HANDLE ds4ReadEvent = nullptr;           // Overlapped read completion event
+    OVERLAPPED ds4Overlapped = {};
+    std::vector<BYTE> ds4Report;             // Input report buffer (InputReportByteLength)
+    bool ds4ReadPending = false;             // A ReadFile is in flight
+    ControllerSample ds4LastSample = {};     // Last parsed report, re-sent on idle poll deadlines
+    int ds4LastCounter = -1;                 // Report counter (0-63) of the previous report
+    LONGLONG ds4LastReportTicks = 0;         // QPC time of the previous report
+    double ds4ReportIntervalMs = 0.0;        // Smoothed time between reports
+    double ds4ReportLatencyUs = 0.0;         // Smoothed report arrival -> handler finished
+    double ds4MaxReportLatencyUs = 0.0;      // Worst report arrival -> handler finished
+    
+    // Touch mode state - touch IDs are touchIdBase + 0..19
+    bool leftTouchActive = false;
+    bool rightTouchActive = false;
+    int currentLHeldDirection = -1;          // Direction held when L1 is pressed
+    int currentRHeldDirection = -1;          // Direction held when R1 is pressed
+    double currentLHeldX = 0.0, currentLHeldY = 0.0;  // Position when the left direction was captured
+    double currentRHeldX = 0.0, currentRHeldY = 0.0;  // Position when the right direction was captured
+    bool leftPointerLocked = false;          // Left touch locked to a direction (L2)
+    bool rightPointerLocked = false;         // Right touch locked to a direction (R2)
+    int leftLockedDirection = -1;
+    int rightLockedDirection = -1;
+    bool l3TouchActive = false;              // L3 palm pattern held
+    bool r3TouchActive = false;              // R3 palm pattern held
+    StickPredictor leftPredictor;            // Slide look-ahead (predictionMs > 0)
+    StickPredictor rightPredictor;
+    
+    // Touch upsampling (touchUpsampleHz > 0): each new report starts a segment from the
+    // last position handed to the touch handler to the report, walked over one report interval
+    ControllerSample upsampleLastSample = {};  // Latest sample as read - a repeat of it is a tick
+    bool upsampleValid = false;              // upsampleLastSample holds a real sample
+    LONGLONG upsampleSegmentStart = 0;       // When the current segment started (its report's time)
+    double upsampleIntervalMs = 4.0;         // Smoothed time between reports = segment length
+    double upsampleFrom[4] = {};             // Left X/Y, right X/Y at the segment start
+    double upsampleTo[4] = {};               // ... and at its end
+    double upsampleCurrent[4] = {};          // Last interpolated position
+    
+    // Previous button states, for edge detection in every mode
+    bool prevL1 = false, prevR1 = false;
+    bool prevL2 = false, prevR2 = false;
+    bool prevL3 = false, prevR3 = false;
+};
+
+// ============================================
+// TIMING
+// ============================================
+
+// QueryPerformanceCounter helpers - all timestamps in this program are QPC ticks
+inline LONGLONG qpcNow() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+inline LONGLONG qpcFrequency() {
+    static const LONGLONG frequency = [] {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        return freq.QuadPart;
+    }();
+    return frequency;
+}
+
+struct LatencyStats {
+    uint32_t count = 0;  // Samples in the window
+    double p50Us = 0.0, p99Us = 0.0, maxUs = 0.0;
+};
+
+// Rolling window of the most recent latencies. Lock-free: one writer thread records,
+// any thread can read stats (a sample being overwritten just lands in either window).
+class LatencyRecorder {
+public:
+    static constexpr uint32_t CAPACITY = 1024;  // ~1s of samples at 1000Hz
+    
+    void record(LONGLONG fromTicks, LONGLONG toTicks) {
+        float microseconds = (float)((toTicks - fromTicks) * 1000000.0 / qpcFrequency());
+        uint32_t index = writeCount.load(std::memory_order_relaxed);
+        samples[index % CAPACITY].store(microseconds, std::memory_order_relaxed);
+        writeCount.store(index + 1, std::memory_order_release);
+    }
+    LatencyStats getStats() const;
+    uint32_t copyRecent(float* out, uint32_t maxCount) const;  // Newest maxCount samples, oldest first
+
+private:
+    std::atomic<float> samples[CAPACITY] = {};
+    std::atomic<uint32_t> writeCount{0};
+};
+
+struct PerfCounterValues {
+    uint64_t loopWakes = 0, samples = 0, injectCalls = 0, injectContacts = 0;
+    uint64_t droppedReports = 0, bufferOverflows = 0, coalescedEdges = 0;
+};
+
+// Running event counts behind the performance HUD. Only the polling thread writes
+// them; the HUD differences two reads for its per-second rates.
+struct PerfCounters {
+    std::atomic<uint64_t> loopWakes{0};        // pollDeviceLoop iterations (deadlines and input wake-ups)
+    std::atomic<uint64_t> samples{0};          // processSample calls
+    std::atomic<uint64_t> injectCalls{0};      // InjectTouchInput calls (replay counts the ones it skips)
+    std::atomic<uint64_t> injectContacts{0};   // Contacts in those calls
+    std::atomic<uint64_t> droppedReports{0};   // DS4 reports missing from the report counter
+    std::atomic<uint64_t> bufferOverflows{0};  // DirectInput buffer overflows (edges lost)
+    std::atomic<uint64_t> coalescedEdges{0};   // Button edges dispatched in one sample with another
+    
+    void add(std::atomic<uint64_t>& counter, uint64_t count = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+    PerfCounterValues read() const {
+        PerfCounterValues values;
+        values.loopWakes = loopWakes.load(std::memory_order_relaxed);
+        values.samples = samples.load(std::memory_order_relaxed);
+        values.injectCalls = injectCalls.load(std::memory_order_relaxed);
+        values.injectContacts = injectContacts.load(std::memory_order_relaxed);
+        values.droppedReports = droppedReports.load(std::memory_order_relaxed);
+        values.bufferOverflows = bufferOverflows.load(std::memory_order_relaxed);
+        values.coalescedEdges = coalescedEdges.load(std::memory_order_relaxed);
+        return values;
+    }
+};
+
+// Busy-waits for a sub-millisecond delay without giving up the time slice
+inline void spinWaitMicroseconds(int microseconds) {
+    LONGLONG deadline = qpcNow() + (LONGLONG)microseconds * qpcFrequency() / 1000000;
+    while (qpcNow() < deadline) {
+        YieldProcessor();
+    }
+}
+
+// Paces a loop to an absolute deadline on a high-resolution waitable timer.
+// Deadlines advance by exactly one period, so time spent in the loop body doesn't drift the rate.
+class FramePacer {
+public:
+    FramePacer();
+    ~FramePacer();
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+    
+    void setRate(double hz);
+    void reset();
+    void wait();
+    bool waitOrEvents(const HANDLE* events, int count);  // Returns true if woken early by one of up to MAX_CONTROLLERS events (deadline not consumed)
+    
+    double getTargetPeriodMs() const;
+    double getAchievedPeriodMs() const { return achievedPeriodMs; }  // Smoothed measured period
+    double getLastPeriodMs() const { return lastPeriodMs; }
+    bool isHighResolution() const { return highResolution; }
+
+private:
+    HANDLE timer;
+    bool highResolution;
+    std::atomic<double> periodTicks;  // Exact period in QPC ticks (no integer rounding) - read by the HUD
+    double nextDeadline;  // Absolute QPC deadline of the next frame
+    LONGLONG lastWakeTicks;
+    std::atomic<double> lastPeriodMs;
+    std::atomic<double> achievedPeriodMs;
 };
 
+// ============================================
+// LOGGING
+// ============================================
+
+enum class LogLevel {
+    Debug,    // Per-press diagnostics (monitor routing dumps, touch enables)
+    Info,
+    Warning,
+    Error
+};
+
+// Records below this level are compiled out of every MAPPER_LOG call site - the
+// arguments aren't even evaluated. Release builds (/DNDEBUG) drop Debug.
+#ifndef MAPPER_MIN_LOG_LEVEL
+#ifdef NDEBUG
+#define MAPPER_MIN_LOG_LEVEL 1
+#else
+#define MAPPER_MIN_LOG_LEVEL 0
+#endif
+#endif
+
+constexpr bool logLevelEnabled(LogLevel level) { return (int)level >= MAPPER_MIN_LOG_LEVEL; }
+
+#define MAPPER_LOG(ring, level, ...) \
+    do { if (logLevelEnabled(level)) (ring).write(level, __VA_ARGS__); } while (0)
+
+// Lock-free single-producer/single-consumer ring of preformatted log lines. The
+// producer formats straight into a slot and never blocks: a full ring drops the
+// record and counts it. Slots are allocated once at construction.
+class LogRing {
+public:
+    static constexpr uint32_t CAPACITY = 1024;  // Records, power of two
+    static constexpr int RECORD_CHARS = 184;    // Longer lines are truncated
+    
+    struct Record {
+        LogLevel level;
+        int length;
+        char text[RECORD_CHARS];
+    };
+    
+    LogRing() : records(new Record[CAPACITY]) {}
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+    
+    void write(LogLevel level, const char* format, ...);  // Producer thread only
+    bool read(Record& record);                            // Consumer thread only
+    uint32_t takeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<Record[]> records;
+    alignas(64) std::atomic<uint32_t> head{0};  // Next slot the producer fills
+    alignas(64) std::atomic<uint32_t> tail{0};  // Next slot the consumer drains
+    std::atomic<uint32_t> dropped{0};
+};
+
+// Background thread that drains the rings to the console and optionally a file, so
+// neither the polling nor the overlay thread ever waits on conhost
+class AsyncLog {
+public:
+    LogRing poll;     // Written by the polling thread only
+    LogRing overlay;  // Written by the main (overlay) thread only
+    
+    AsyncLog() = default;
+    ~AsyncLog() { stop(); }
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+    
+    void start(const std::string& filePath);  // Empty path = console only
+    void stop();                              // Drains everything still queued
+
+private:
+    static constexpr int DRAIN_INTERVAL_MS = 10;
+    
+    void drainLoop();
+    bool drainOnce();
+    void writeLine(LogLevel level, const char* text, int length);
+    
+    std::thread drainThread;
+    std::atomic<bool> running{false};
+    FILE* file = nullptr;
+};
+
+// ============================================
+// SYNCHRONIZATION
+// ============================================
+
+// Single-writer sequence lock for small trivially-copyable state. Readers never block
+// the writer; they retry if a write happened during their copy.
+template <typename T>
+class SeqLock {
+public:
+    void write(const T& value) {
+        unsigned seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);  // Odd = write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        data = value;
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+    
+    // Copies the latest value and returns the version it came from
+    unsigned read(T& out) const {
+        for (;;) {
+            unsigned before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                YieldProcessor();
+                continue;
+            }
+            out = data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return before;
+            }
+        }
+    }
+    
+    unsigned version() const { return sequence.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<unsigned> sequence{0};
+    T data{};
+};
+
+// ============================================
+// DIRECTION GEOMETRY
+// ============================================
+
+// Everything the touch path needs about the 8 direction sectors, built at compile
+// time. Sector d spans [d*45°, d*45° + 45°) clockwise from up; its arc centre is at
+// the middle of that span on the unit circle.
+constexpr double SIN_22_5 = 0.38268343236508977;
+constexpr double COS_22_5 = 0.92387953251128676;
+constexpr double SQRT_HALF = 0.70710678118654752;
+
+constexpr double DIRECTION_CENTER_X[8] = {  SIN_22_5,  COS_22_5,  COS_22_5,  SIN_22_5,
+                                           -SIN_22_5, -COS_22_5, -COS_22_5, -SIN_22_5 };
+constexpr double DIRECTION_CENTER_Y[8] = {  COS_22_5,  SIN_22_5, -SIN_22_5, -COS_22_5,
+                                           -COS_22_5, -SIN_22_5,  SIN_22_5,  COS_22_5 };
+
+// Sector boundaries on the unit circle - sector d runs from boundary d to d + 1
+constexpr double DIRECTION_BOUNDARY_X[8] = { 0.0,  SQRT_HALF,  1.0,  SQRT_HALF,  0.0, -SQRT_HALF, -1.0, -SQRT_HALF };
+constexpr double DIRECTION_BOUNDARY_Y[8] = { 1.0,  SQRT_HALF,  0.0, -SQRT_HALF, -1.0, -SQRT_HALF,  0.0,  SQRT_HALF };
+
+// Unit offsets of the 8 palm contacts around the centre (0°, 45°, ... 315° counter-clockwise from +x)
+constexpr double PALM_OFFSET_X[8] = { 1.0,  SQRT_HALF,  0.0, -SQRT_HALF, -1.0, -SQRT_HALF,  0.0,  SQRT_HALF };
+constexpr double PALM_OFFSET_Y[8] = { 0.0,  SQRT_HALF,  1.0,  SQRT_HALF,  0.0, -SQRT_HALF, -1.0, -SQRT_HALF };
+
+// Straight path between two arc centres, as used by the pointer lock
+struct DirectionPath {
+    double unitX = 0.0, unitY = 0.0;  // Unit vector from held centre to locked centre
+    double length = 0.0;              // Distance between the centres
+};
+
+constexpr double constexprSqrt(double value) {
+    if (value <= 0.0) return 0.0;
+    double guess = value > 1.0 ? value : 1.0;
+    for (int i = 0; i < 32; i++) {
+        guess = 0.5 * (guess + value / guess);  // Newton's method - converges well within 32 steps for these inputs
+    }
+    return guess;
+}
+
+struct DirectionPathTable {
+    DirectionPath paths[8][8];  // [heldDirection][lockedDirection]
+};
+
+constexpr DirectionPathTable buildDirectionPathTable() {
+    DirectionPathTable table = {};
+    for (int held = 0; held < 8; held++) {
+        for (int locked = 0; locked < 8; locked++) {
+            double dx = DIRECTION_CENTER_X[locked] - DIRECTION_CENTER_X[held];
+            double dy = DIRECTION_CENTER_Y[locked] - DIRECTION_CENTER_Y[held];
+            double length = constexprSqrt(dx * dx + dy * dy);
+            DirectionPath& path = table.paths[held][locked];
+            path.length = length;
+            path.unitX = (length > 0.0) ? dx / length : 0.0;
+            path.unitY = (length > 0.0) ? dy / length : 0.0;
+        }
+    }
+    return table;
+}
+
+constexpr DirectionPathTable DIRECTION_PATHS = buildDirectionPathTable();
+
+// ============================================
+// RENDERING
+// ============================================
+
+// 32-bit top-down DIB selected into its own memory DC
+struct DibSurface {
+    HDC dc = nullptr;
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ oldBitmap = nullptr;
+    uint32_t* bits = nullptr;  // 0xAARRGGBB, width * height
+    int width = 0, height = 0;
+    
+    DibSurface() = default;
+    ~DibSurface() { release(); }
+    DibSurface(const DibSurface&) = delete;
+    DibSurface& operator=(const DibSurface&) = delete;
+    
+    bool ensure(int newWidth, int newHeight);  // (Re)creates on size change; contents undefined after
+    void release();
+};
+
+// Pens, brushes and fonts for the overlay, created on first use and kept until
+// destruction. The overlay only uses a handful of colors and widths, so the cache
+// stays small. Used from the overlay (main) thread only.
+class GdiCache {
+public:
+    GdiCache() = default;
+    ~GdiCache();
+    GdiCache(const GdiCache&) = delete;
+    GdiCache& operator=(const GdiCache&) = delete;
+    
+    HPEN getPen(COLORREF color, int width);
+    HBRUSH getBrush(COLORREF color);
+    HFONT getFont(int height, int weight, DWORD quality = CLEARTYPE_QUALITY);  // Consolas
+    
+private:
+    std::unordered_map<unsigned long long, HPEN> pens;  // Key: width << 32 | color
+    std::unordered_map<COLORREF, HBRUSH> brushes;
+    std::unordered_map<unsigned long long, HFONT> fonts;  // Key: weight << 32 | quality << 24 | height
+};
+
+// Upper bound on overlay elements that get their own dirty rectangle: per ring the
+// ring, 2 stick indicators, 2 locked pointers, touches 0-1, 2 palms; plus debug text
+constexpr int MAX_OVERLAY_DIRTY_RECTS = 1 + 9 * MAX_CONTROLLERS;
+
+// Poll periods shown in the performance HUD graph - a quarter second at 1000Hz
+constexpr int PERF_GRAPH_POINTS = 240;
+
 // ============================================
 // MAIN CONTROLLER CLASS
 // ============================================
@@ -58,26 +798,109 @@ class ControllerMapper {
 private:
     // ========== GUI Components ==========
     LPDIRECTINPUT8 di;
-    LPDIRECTINPUTDEVICE8 joystick;
     HWND hwnd;              // Main window (hidden)
     HWND overlayHwnd;       // Full-screen transparent overlay
-    std::string debugText;  // Debug info displayed on overlay
-    POINT lastMousePos;      // Last mouse position for detecting movement
-    bool showDebugInfo;     // Toggle debug panel visibility
+    
+    // ========== Overlay Renderer ==========
+    // Everything below is owned by the overlay (main) thread
+    OverlayBackend overlayBackend;
+    GdiCache gdiCache;
+    DibSurface backBuffer;              // Overlay client area (premultiplied ARGB in LayeredAlpha)
+    DibSurface maskBuffer;              // LayeredAlpha only: element alpha drawn as gray
+    bool overlayMaskPass;               // Drawing the alpha pass - overlayColor() returns gray
+    HRGN paintRegion;                   // Area being redrawn (update region in ColorKeyGdi)
+    HRGN scratchRegion;                 // Temporary for building paintRegion
+    std::vector<BYTE> regionDataBuffer; // GetRegionData output, grown as needed
+    
+    // GpuComposition backend (GpuOverlay.cpp)
+    ID3D11Device* gpuDevice;
+    IDXGISwapChain2* gpuSwapChain;
+    HANDLE gpuFrameWaitable;            // Signaled when the swap chain can take the next frame
+    bool gpuFramePresented;             // Presented since the last waitForOverlayFrame()
+    bool gpuFrameDirty;                 // Render once at the end of this run() loop iteration
+    int gpuRecoveryAttempts;            // Failed device re-creations since the device was lost
+    IDCompositionDevice* dcompDevice;
+    IDCompositionTarget* dcompTarget;
+    IDCompositionVisual* dcompVisual;
+    ID2D1Factory1* d2dFactory;
+    ID2D1DeviceContext* d2dContext;
+    ID2D1Bitmap1* d2dTarget;            // Swap chain back buffer
+    ID2D1SolidColorBrush* d2dBrush;     // Recolored for each element
+    ID2D1PathGeometry* gpuArcs[8];      // One per direction sector, built for gpuArcRadius
+    int gpuArcRadius, gpuArcCenterX, gpuArcCenterY;
+    IDWriteFactory* dwriteFactory;
+    IDWriteTextFormat* debugTextFormat;
+    IDWriteTextFormat* touchIdTextFormat;
+    std::wstring gpuTextBuffer;         // Debug text converted for DirectWrite, reused
+    int gpuWidth, gpuHeight;            // Swap chain size
+    OverlaySnapshot paintSnapshot;      // Snapshot the pending invalidation was computed from
+    RECT overlayDirtyRects[MAX_OVERLAY_DIRTY_RECTS];  // Element bounds of paintSnapshot
+    int overlayDirtyRectCount;
+    RECT debugTextRect;                 // Bounds of the debug panel in paintSnapshot
+    std::atomic<bool> showDebugInfo;  // Toggle debug panel visibility
+    
+    // ========== Polling Thread ==========
+    // Controller polling and input injection run on their own thread so overlay
+    // repaints on the main thread can never delay a touch
+    std::thread pollThread;
+    std::atomic<bool> pollThreadRunning;
+    int pollRateHz;                          // Polling/injection rate (independent of refresh rate)
+    FramePacer pollPacer;                    // Paces the polling thread to pollRateHz
+    
+    // Idle detection - after idleMs of centred sticks and no buttons on every controller the
+    // poll deadline slows down; event-driven controllers still wake the thread on new input
+    int idleMs;                              // 0 = always poll at the full rate
+    std::atomic<bool> pollIdle;              // Running at the idle rate (shown by the HUD)
+    LONGLONG lastActiveTicks;                // Last non-neutral sample on any controller
+    
+    // Log lines from the polling and overlay threads - queued, written by a background thread
+    AsyncLog asyncLog;
+    
+    // Input recording and replay - replay feeds the polling thread from a file and
+    // turns every injection into a no-op
+    std::string recordPath;                  // Recording is written here on shutdown (empty = off)
+    std::vector<RecordedSample> recordedSamples;
+    LONGLONG recordStartTicks;
+    std::string replayPath;
+    std::vector<RecordedSample> replaySamples;
+    bool replaying;
+    bool replayFullSpeed;
+    std::atomic<bool> replayFinished;        // Set by the polling thread at the end of the recording
+    LONGLONG lastDebugUpdateTicks;           // Last debug text rebuild (rate-limited to debugRefreshHz)
+    int debugRefreshHz;
+    DebugTextBuffer debugTextBuilder;        // Polling thread's formatting buffer
+    DebugTextBuffer publishedDebugText;      // Last text handed to the overlay thread
+    
+    // Overlay state handed from the polling thread to the overlay thread - a new
+    // SeqLock version is the only "needs repaint" signal
+    OverlaySnapshot pollOverlay;             // Built by updateOverlay() each sample
+    OverlaySnapshot publishedOverlay;        // Last state written to overlayState
+    SeqLock<OverlaySnapshot> overlayState;
+    unsigned paintStateVersion;              // overlayState version paintSnapshot came from
+    
+    // Debug panel text - variable length, so it travels separately from the POD snapshot
+    std::mutex debugTextMutex;
+    std::string sharedDebugText;             // Guarded by debugTextMutex
+    std::atomic<unsigned> debugTextVersion;  // Bumped each time sharedDebugText changes
+    std::string paintDebugText;              // Main thread's copy
+    unsigned paintDebugTextVersion;
+    DebugTextBuffer paintTextBuffer;         // Main thread: panel text plus latency rows, rebuilt per paint
     
     // ========== Controller State ==========
-    bool hasXInputController;
-    DWORD xInputControllerIndex;
-    XINPUT_STATE xInputState;
+    // Every selected controller, polled in order by the one polling thread
+    ControllerSlot controllers[MAX_CONTROLLERS];
+    int controllerCount;                     // Slots in use (always at least 1)
+    bool useBufferedDirectInput;             // Try buffered mode when opening DirectInput devices
+    DirectInputButtonMap diButtonMap;
+    bool diMappedButtons[128];               // Buttons in diButtonMap - their edges are dispatched at once
+    std::vector<ControllerInfo> profileControllers;  // From the profile - opened without the menus
+    std::string profilePath;                 // Written once the menus picked the controllers
     
     // ========== Overlay Visualization ==========
-    double overlayLeftX, overlayLeftY;      // Left stick (-1.0 to 1.0)
-    double overlayRightX, overlayRightY;    // Right stick (-1.0 to 1.0)
-    double overlayLeftAngle, overlayRightAngle;  // Angles in degrees
-    int overlayLeftAlpha, overlayRightAlpha;     // Fade alpha (0-255)
     int overlayPosX, overlayPosY;           // Overlay screen position
     int overlayStickRadius;                 // Circle radius in pixels
-    int updateIntervalMs;                   // Dynamic based on refresh rate
+    std::atomic<int> refreshRateHz;         // Detected refresh rate of the overlay's monitor
+    FramePacer overlayPacer;                // Paces the overlay loop to refreshRateHz
     
     // Monitor information (detected from console window)
     int monitorLeft, monitorTop;           // Monitor position in virtual screen
@@ -90,91 +913,129 @@ private:
     // Real-time monitor detection - cache monitor bounds for quick checking
     int monitorRight, monitorBottom;  // Cached monitor bounds for quick boundary checks
     
-    // Locked pointer visualization
-    double overlayLeftLockedX, overlayLeftLockedY;    // Left locked position
-    double overlayRightLockedX, overlayRightLockedY;  // Right locked position
-    int overlayLeftLockedAlpha, overlayRightLockedAlpha; // Locked pointer alpha
-    
-    // L3/R3 5-touch X pattern visualization
-    double overlayL3CenterX, overlayL3CenterY;      // L3 center position
-    double overlayR3CenterX, overlayR3CenterY;      // R3 center position
-    int overlayL3Alpha, overlayR3Alpha;             // L3/R3 pattern alpha
-    
-    // Track previous overlay values to prevent unnecessary redraws
-    double prevOverlayLeftX, prevOverlayLeftY, prevOverlayRightX, prevOverlayRightY;
-    double prevOverlayLeftAngle, prevOverlayRightAngle;
-    int prevOverlayLeftAlpha, prevOverlayRightAlpha;
-    int prevOverlayLeftLockedAlpha, prevOverlayRightLockedAlpha;
-    double prevOverlayLeftLockedX, prevOverlayLeftLockedY;
-    double prevOverlayRightLockedX, prevOverlayRightLockedY;
-    double prevOverlayL3CenterX, prevOverlayL3CenterY;
-    double prevOverlayR3CenterX, prevOverlayR3CenterY;
-    int prevOverlayL3Alpha, prevOverlayR3Alpha;
+    // Monitor topology cache - built on the main thread, read lock-free by the polling thread
+    MonitorTopology monitorTopology;           // Main thread's copy
+    SeqLock<MonitorTopology> sharedTopology;   // Published copy
+    MonitorTopology pollTopology;              // Polling thread's copy
+    unsigned pollTopologyVersion;              // sharedTopology version pollTopology came from
     
     // ========== Input Mode State ==========
-    InputMode currentMode;  // Current operating mode (Touch/Mouse/Keyboard)
+    InputMode currentMode;  // Current operating mode (Touch/Mouse/Keyboard) - polling thread's once it runs
+    std::atomic<int> requestedMode;  // Mode switch for the polling thread to apply (-1 = none)
     
-    // Touch mode state (UWP InputInjector)
-    bool leftTouchActive;
-    bool rightTouchActive;
+    // Touch mode state (UWP InputInjector) - per-controller state is in ControllerSlot
     InputInjector inputInjector;
     bool inputInjectorInitialized;
     
-    // Touch mode section tracking
-    int currentLHeldDirection;  // Direction held when L1 is pressed
-    int currentRHeldDirection;  // Direction held when R1 is pressed
-    double currentLHeldX;       // X position when left direction was captured
-    double currentLHeldY;       // Y position when left direction was captured
-    double currentRHeldX;       // X position when right direction was captured
-    double currentRHeldY;       // Y position when right direction was captured
-    
-    // Touch mode pointer locking (trigger-based: L2/R2)
-    bool leftPointerLocked;     // Whether left touch is locked to a direction
-    bool rightPointerLocked;    // Whether right touch is locked to a direction
-    int leftLockedDirection;    // Direction the left touch is locked to
-    int rightLockedDirection;   // Direction the right touch is locked to
-    bool prevL2;  // Previous L2 (left trigger) button state
-    bool prevR2;  // Previous R2 (right trigger) button state
-    bool prevL3;  // Previous L3 (left stick press) button state
-    bool prevR3;  // Previous R3 (right stick press) button state
-    
-    // L3/R3 5-touch X pattern state
-    bool l3TouchActive;  // Whether L3 5-touch pattern is active
-    bool r3TouchActive;  // Whether R3 5-touch pattern is active
-    
-    // All 20 touch tracking (0-19) for debug overlay
-    bool touchActive[20];  // Whether each touch is active
-    double touchX[20];     // X position of each touch (stick coordinates)
-    double touchY[20];     // Y position of each touch (stick coordinates)
+    // Every touch ID of every controller, for the debug overlay
+    bool touchActive[MAX_TOUCH_IDS];  // Whether each touch is active
+    double touchX[MAX_TOUCH_IDS];     // X position of each touch (stick coordinates)
+    double touchY[MAX_TOUCH_IDS];     // Y position of each touch (stick coordinates)
+    
+    // Touch frame builder - every down/update/up of a sample is gathered here and
+    // submitted as one InjectTouchInput call, so the game sees all contacts in one pointer frame
+    TouchFrameEntry touchFrame[MAX_TOUCH_IDS];  // Pending transition per touch ID
+    bool touchFramePending;                     // Any entry pending
+    bool injectedTouchActive[MAX_TOUCH_IDS];    // Contact currently down as far as the injector knows
+    double injectedTouchX[MAX_TOUCH_IDS];       // Last injected position (stick coordinates)
+    double injectedTouchY[MAX_TOUCH_IDS];
+    std::vector<InjectedInputTouchInfo> touchFrameBuffer;  // Reused for every frame
+    
+    // One preconstructed contact record per touch ID, updated in place every frame
+    std::vector<InjectedInputTouchInfo> touchInfoPool;     // Filled in initializeTouchInjection
+    int touchInfoPoolRadius[MAX_TOUCH_IDS];                // Contact radius currently set on each record
+    
+    // ========== Latency Instrumentation ==========
+    // All measured from the controller sample's timestamp (read return / buffer drain time)
+    LONGLONG currentSampleTicks;              // Sample being processed (polling thread)
+    LatencyRecorder sampleToHandlerLatency;   // -> mode handler entry
+    LatencyRecorder sampleToInjectLatency;    // -> InjectTouchInput returned
+    LatencyRecorder sampleToPaintLatency;     // -> overlay WM_PAINT finished (overlay thread)
+    LONGLONG paintingSampleTicks;             // Sample of the snapshot drawOverlay just drew
+    LONGLONG lastPaintedSampleTicks;          // Last sample counted in sampleToPaintLatency
+    
+    // Performance HUD (PerfHud.cpp) - the second Ctrl+Shift+~ state, drawn top-right by
+    // every overlay backend. Refreshed on the overlay thread at PERF_HUD_REFRESH_HZ
+    std::atomic<bool> showPerfHud;
+    PerfCounters perfCounters;                // Polling thread
+    LatencyRecorder pollPeriodRecorder;       // Polling thread: time between poll deadlines
+    LatencyRecorder overlayPaintTime;         // Overlay thread: one paint, start to finish
+    DebugTextBuffer perfHudText;              // Overlay thread from here: content of the last refresh
+    float perfHudPeriods[PERF_GRAPH_POINTS];  // Latest poll periods (us), oldest first
+    uint32_t perfHudPeriodCount;
+    double perfHudTargetUs;                   // Poll period the graph is centred on
+    RECT perfHudRect;                         // Where the last refresh was drawn
+    LONGLONG perfHudRefreshTicks;             // 0 = first refresh only takes the baseline
+    PerfCounterValues perfHudBaseline;        // Counters at the last refresh
+    
+    // Palm (L3/R3) down/up injection
+    PalmInjectionMode palmInjectionMode;
+    int palmStaggerUs;
+    double lastPalmSpreadUs;               // First contact submitted -> last contact down, last palm
+    
+    // Slide prediction - touches lead the stick by this much, except on locked paths
+    int predictionMs;
+    
+    // Touch upsampling - interpolated touch updates between reports at this rate
+    int touchUpsampleHz;
+    
+    // Deadzones/response curve, applied by every backend as it reads a sample
+    StickConditioner stickConditioner;
     
     // Mouse mode state
     bool mouseButtonPressed;
     bool alternateFrame;  // For dual-stick alternating mode
     
-    // Keyboard mode state (number keys 1-8)
-    std::string currentLeftKey;
-    std::string currentRightKey;
+    // Keyboard mode state - the compiled layout and the sector each stick holds down
+    std::string layoutPath;
+    SectorLayout keyboardLayout;
+    int currentLeftSector;   // Index into keyboardLayout.left, -1 = nothing held
+    int currentRightSector;  // Index into keyboardLayout.right, -1 = nothing held
     
-    // Shared button tracking
-    bool prevL1;  // Previous L1 (left shoulder) button state
-    bool prevR1;  // Previous R1 (right shoulder) button state
+    // Keyboard/mouse frame builder - every key and mouse event of a sample is gathered
+    // here and submitted as one SendInput call, so both hands change keys atomically
+    INPUT inputFrame[8];  // At most 2 releases + 2 presses, or button + move
+    int inputFrameCount;
     
     // ========== Constants ==========
     static constexpr double PI = 3.14159265359;
     static constexpr int WINDOW_WIDTH = 480;
     static constexpr int WINDOW_HEIGHT = 640;
-    static constexpr int SELECTION_SLEEP_MS = 4;  // For controller selection menu
-    static constexpr double STICK_MAX_VALUE = 32767.0;
-    static constexpr double STICK_NORMALIZE_FACTOR = 32767.5;
+    static constexpr int MIN_POLL_RATE_HZ = 60;
+    static constexpr int MAX_POLL_RATE_HZ = 1000;
+    static constexpr int MAX_PREDICTION_MS = 30;  // Beyond this the extrapolation overshoots every turn
+    static constexpr int MAX_UPSAMPLE_HZ = 2000;
+    static constexpr double MAX_UPSAMPLE_INTERVAL_MS = 20.0;  // Longer gaps are the stick resting, not the report rate
+    static constexpr size_t MAX_RECORDED_SAMPLES = 1 << 22;  // ~70 minutes at 1000Hz (128MB), reserved up front
+    static constexpr double IDLE_EVENT_RATE_HZ = 10.0;   // Idle deadline when every controller signals its input
+    static constexpr double IDLE_STICK_RADIUS = 0.05;    // Stick radius that still counts as centred for idling
+    static constexpr double DIRECTION_INDICATOR_DISTANCE = 0.1;  // Conditioned radius that shows the direction arc
+    static constexpr DWORD DI_BUFFER_SIZE = 128;  // Buffered DirectInput events per device
+    static constexpr USHORT DS4_VENDOR_ID = 0x054C;       // Sony
+    static constexpr USHORT DS4_PRODUCT_IDS[] = { 0x05C4, 0x09CC, 0x0BA0 };  // DS4 v1, DS4 v2, USB wireless adapter
     static constexpr int DIRECTION_SECTORS = 8;  // 8 directional keys
     static constexpr double DEGREES_PER_SECTOR = 45.0;  // 360° / 8 = 45°
     static constexpr int OVERLAY_STICK_INDICATOR_RADIUS = 16;  // Pixel radius for stick indicators
     static constexpr int OVERLAY_LOCKED_INDICATOR_RADIUS = 14;  // Pixel radius for locked indicators (smaller)
+    static constexpr int DEFAULT_CONTACT_RADIUS = 15;  // 30x30px touch contact
     static constexpr int X_PATTERN_RADIUS_PIXELS = 125;  // Pixel radius for 5-touch X pattern (center to corner distance)
+    
+    // Debug panel layout (Consolas 20px bold)
+    static constexpr int DEBUG_TEXT_X = 30;
+    static constexpr int DEBUG_TEXT_LINE_HEIGHT = 24;
+    static constexpr int DEBUG_TEXT_BOTTOM_MARGIN = 120;
+    static constexpr int DEBUG_TEXT_CHAR_WIDTH = 12;     // Slightly over the glyph advance
+    static constexpr int LATENCY_STATS_LINES = 5;        // Lines appendLatencyStats() adds
+    static constexpr int LATENCY_STATS_CHARS = 48;       // Widest of those lines, with headroom
+    static constexpr int GPU_RECOVERY_ATTEMPTS = 60;     // ~1s of overlay frames before falling back to GDI
+    static constexpr int PERF_HUD_REFRESH_HZ = 10;
+    static constexpr int PERF_HUD_TOP = 30;
+    static constexpr int PERF_GRAPH_HEIGHT = 80;         // Poll period graph: target +-100% top to bottom
+    static constexpr int PERF_GRAPH_STEP = 2;            // Pixels per graphed period
 
 public:
     // ========== Constructor & Initialization ==========
-    ControllerMapper(InputMode mode = InputMode::Touch);
+    ControllerMapper(const MapperSettings& settings = MapperSettings());
     bool initialize();
     ~ControllerMapper();
     
@@ -183,28 +1044,102 @@ public:
     
     // ========== Cleanup (Release All Inputs) ==========
     void cleanup();
+    
+    // ========== Benchmarks (Benchmark.cpp, ControllerBench.exe only) ==========
+    void runBenchmarks();
+    
+    // ========== Session Profile (Profile.cpp) ==========
+    static std::string defaultProfilePath();  // ControllerInput.profile next to the executable
+    static bool loadProfile(const std::string& path, MapperSettings& settings);
 
 private:
     // ========== GUI Creation ==========
     void createGUI();
-    void createOverlay();
+    void createOverlay(bool fromOverlayLoop = false);  // true: re-created by run(), log through asyncLog
     void detectMonitorFromCursor(bool verbose = false);
     POINT checkMonitorChange();
     void updateRefreshRate();
     void updateOverlayPosition();
+    void rebuildMonitorTopology();
     
     // ========== Controller Initialization ==========
     void initializeControllers();
     std::vector<ControllerInfo> listAllControllers();
     void displayControllerMenu(const std::vector<ControllerInfo>& controllers);
     int getControllerSelection(int maxControllers);
-    bool initializeDirectInputWithDevice(const GUID& deviceGuid);
+    bool openController(ControllerSlot& slot, const ControllerInfo& info);
+    void selectAdditionalControllers(const std::vector<ControllerInfo>& available, std::vector<bool>& taken);
+    bool openProfileControllers();
+    bool saveProfile();
+    bool initializeDirectInputWithDevice(ControllerSlot& slot, const GUID& deviceGuid);
+    void releaseController(ControllerSlot& slot);
+    
+    // ========== DualShock 4 HID ==========
+    void listDualShock4Controllers(std::vector<ControllerInfo>& controllers);
+    bool initializeDualShock4(ControllerSlot& slot, const std::string& devicePath);
+    void closeDualShock4(ControllerSlot& slot);
+    bool readDualShock4Reports(ControllerSlot& slot, bool deadlineReached);
+    bool parseDualShock4Report(const BYTE* report, DWORD length, ControllerSample& sample, int& reportCounter);
+    
+    // ========== Polling Thread ==========
+    void startPollThread();
+    void stopPollThread();
+    void pollLoop();
+    void pollDeviceLoop();
+    bool pollController(ControllerSlot& slot, ControllerSample& sample);
+    bool drainDirectInputBuffer(ControllerSlot& slot, bool deadlineReached);
+    bool pollSlot(ControllerSlot& slot, bool deadlineReached);
+    void sampleFromDirectInputState(const DIJOYSTATE2& state, ControllerSample& sample);
+    void processSample(ControllerSlot& slot, const ControllerSample& sample);
+    double pollDeadlineRateHz() const;
+    bool isNeutralSample(const ControllerSample& sample) const;
+    void leavePollIdle();
+    
+    // ========== Mode Switching ==========
+    void requestModeSwitch(InputMode mode);  // Main thread
+    void applyModeSwitch();                  // Polling thread, between samples
+    
+    // ========== Input Recording & Replay ==========
+    bool initializeReplay();
+    bool loadRecording();
+    bool saveRecording();
+    void recordSample(int controllerIndex, const ControllerSample& sample);
+    int sampleFromRecorded(const RecordedSample& record, ControllerSample& sample);  // Returns the controller index
+    void replayRecording();
     
     // ========== Overlay Rendering ==========
-    void updateOverlay(double leftX, double leftY, double rightX, double rightY, double leftAngle, double rightAngle);
-    void drawOverlay(HDC hdc);
+    void updateOverlay(const ControllerSlot& slot, double leftX, double leftY, double rightX, double rightY, int leftDirection, int rightDirection);
+    void drawOverlay(HDC windowDC, const RECT& paintRect, HRGN paintRgn);
     
 private:
+    // Back buffer and dirty-rectangle tracking (OverlayRenderer.cpp)
+    void invalidateOverlayChanges();
+    void invalidateDebugText();
+    void redrawOverlay();  // Entire client area, either backend
+    void renderLayeredOverlay(HRGN dirtyRegion);
+    void premultiplyRegion(HRGN region);
+    void drawOverlayScene(HDC hdc, const RECT& client, const RECT& clearRect);
+    void drawOverlayRing(HDC hdc, const RingSnapshot& ring, int centerX, int centerY);
+    void getRingCenter(int ring, int ringCount, const RECT& client, int& centerX, int& centerY) const;
+    void waitForOverlayFrame();  // Vblank after a GPU present, otherwise the refresh-rate pacer
+    
+    // Direct2D/DirectComposition backend (GpuOverlay.cpp)
+    bool initializeGpuOverlay(bool fromOverlayLoop = false);
+    void releaseGpuOverlay();
+    bool resizeGpuOverlay(int width, int height);
+    void rebuildGpuArcs(int centerX, int centerY);
+    void renderGpuOverlay();
+    void recoverGpuOverlay();
+    void renderGpuRing(const RingSnapshot& ring, float centerX, float centerY);
+    void drawGpuTouchCircle(float x, float y, float radius, int touchId, COLORREF color);
+    void setGpuBrush(COLORREF color, int alpha);
+    COLORREF overlayColor(COLORREF color, int alpha) const {
+        return overlayMaskPass ? RGB(alpha, alpha, alpha) : color;
+    }
+    int collectOverlayElementRects(const OverlaySnapshot& snapshot, const RECT& client, RECT* rects);
+    RECT getDebugTextRect(const RECT& client, const char* text, int length, int extraLines, int minLineChars);
+    
+
     // Helper functions for overlay updates
     int calculateAlpha(double distance, bool touchActive, bool pointerLocked);
     void updateTouchPointerPosition(bool touchActive, bool pointerLocked, int heldDirection, int lockedDirection, 
@@ -214,9 +1149,21 @@ private:
     void drawTouchPointIndicatorAtOverlayPos(HDC hdc, int overlayX, int overlayY, COLORREF color);
     void drawTouchPointIndicator(HDC hdc, LONG screenX, LONG screenY, COLORREF color);
     void drawLockedPointer(HDC hdc, int centerX, int centerY, double stickX, double stickY, COLORREF color, int alpha);
-    void drawPalmTouchPattern(HDC hdc, int centerX, int centerY, double centerStickX, double centerStickY, COLORREF color, int alpha);
-    void drawAllTouches(HDC hdc, int centerX, int centerY);
+    void drawPalmTouchPattern(HDC hdc, const RingSnapshot& ring, int centerX, int centerY, double centerStickX, double centerStickY, COLORREF color, int alpha);
+    void drawAllTouches(HDC hdc, const RingSnapshot& ring, int centerX, int centerY);
     void drawDebugText(HDC hdc, RECT rect);
+    void drawTextLines(HDC hdc, int x, int y, const char* text, int length);
+    void appendLatencyStats(DebugTextBuffer& out);
+    const DebugTextBuffer& formatPaintDebugText();
+    void recordPaintLatency(LONGLONG paintStartTicks);
+    
+    // Performance HUD (PerfHud.cpp)
+    void refreshPerfHud();
+    void invalidatePerfHud(const RECT& previous);
+    RECT getPerfHudRect(const RECT& client);
+    void drawPerfHud(HDC hdc, const RECT& client);
+    void renderGpuPerfHud(const RECT& client);
+    void getPerfGraphPoint(const RECT& hud, uint32_t index, float& x, float& y) const;
     
     // Helper functions for overlay rendering
     void convertStickToOverlayCoords(double stickX, double stickY, int centerX, int centerY, int& overlayX, int& overlayY);
@@ -225,13 +1172,16 @@ private:
     // ========== Utility Functions ==========
     double calculateAngle(double x, double y);
     int getDirection(double angle);
+    int getStickDirection(double x, double y);
     void calculateLockedPosition(int heldDirection, int lockedDirection, double currentX, double currentY, double& lockedX, double& lockedY);
-    bool checkPointerLock(int heldDirection, int currentDirection, double currentAngle, int& lockedDirection);
+    bool checkPointerLock(int heldDirection, int currentDirection, double currentX, double currentY, int& lockedDirection);
     void getDirectionArcCenter(int direction, double& centerX, double& centerY);
     void getAdjacentDirections(int direction, int& leftAdjacent, int& rightAdjacent);
-    void updateDebugInfo(double lAngle, double rAngle, int lDirection, int rDirection, DIJOYSTATE2* state = nullptr);
-    void logError(const std::string& message);
-    void logInfo(const std::string& message);
+    void updateDebugInfo(const ControllerSlot& slot, double lAngle, double rAngle, int lDirection, int rDirection);
+    void appendTouchScreenPos(DebugTextBuffer& out, int touchId, double stickX, double stickY);
+    void appendPalmTouches(DebugTextBuffer& out, const char* label, int centerId, int firstCorner, int lastCorner, bool palmActive);
+    static void logError(const std::string& message);
+    static void logInfo(const std::string& message);
     
     // ========== Window Procedures ==========
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -239,28 +1189,45 @@ private:
     
     // ========== Mode-Specific Handlers (forward declarations) ==========
     // These are implemented in separate files
-    void handleTouchControl(bool l1, bool r1, bool l2, bool r2, bool l3, bool r3, double leftX, double leftY, double rightX, double rightY);
-    void handleMouseControl(bool l1, bool r1, double leftX, double leftY, double rightX, double rightY);
-    void handleKeyboardControl(bool l1, bool r1, double leftX, double leftY, double rightX, double rightY);
+    void handleTouchControl(ControllerSlot& slot, bool l1, bool r1, bool l2, bool r2, bool l3, bool r3, double leftX, double leftY, double rightX, double rightY);
+    void handleMouseControl(ControllerSlot& slot, bool l1, bool r1, double leftX, double leftY, double rightX, double rightY);
+    void handleKeyboardControl(ControllerSlot& slot, bool l1, bool r1, double leftX, double leftY, double rightX, double rightY);
+    
+    // processSample dispatches through MODE_HANDLERS[currentMode] - one entry per InputMode
+    using ModeHandler = void (ControllerMapper::*)(ControllerSlot& slot, const ControllerSample& sample);
+    static const ModeHandler MODE_HANDLERS[3];
+    void processTouchSample(ControllerSlot& slot, const ControllerSample& sample);
+    void processMouseSample(ControllerSlot& slot, const ControllerSample& sample);
+    void processKeyboardSample(ControllerSlot& slot, const ControllerSample& sample);
     
     // ========== Touch Mode Methods (forward declarations) ==========
     // These are implemented in TouchMode.cpp
     void initializeTouchInjection();
-    void getTouchCoordinates(double stickX, double stickY, LONG& touchX, LONG& touchY);
+    void getTouchCoordinates(double stickX, double stickY, LONG& touchX, LONG& touchY, int ring = 0);
     void pixelToHimetric(LONG pixelX, LONG pixelY, LONG& himetricX, LONG& himetricY);
     InjectedInputTouchInfo createTouchInfo(int touchId, double stickX, double stickY, bool isDown, bool isUp);
     InjectedInputTouchInfo createTouchInfo(int touchId, double stickX, double stickY, bool isDown, bool isUp, int contactRadius);
     void sendMultipleTouches(const std::vector<InjectedInputTouchInfo>& touches);
+    void queueTouch(int touchId, double stickX, double stickY, TouchPhase phase);
+    void flushTouchFrame();
     void sendPalmTouch(double centerX, double centerY, int centerTouchId, int cornerStartId, bool isDown, bool isUp);
     void sendTouch(int touchId, double stickX, double stickY, bool isDown, bool isUp);
-    void sendBothTouchesIfActive(double leftX, double leftY, double rightX, double rightY,
+    void predictTouchPositions(ControllerSlot& slot, const ControllerSample& sample,
+                               double& leftX, double& leftY, double& rightX, double& rightY);
+    void upsampleTouchPositions(ControllerSlot& slot, const ControllerSample& sample,
+                                double& leftX, double& leftY, double& rightX, double& rightY);
+    void sendBothTouchesIfActive(const ControllerSlot& slot, double leftX, double leftY, double rightX, double rightY,
                                  double leftLockedX, double leftLockedY, bool leftLocked,
                                  double rightLockedX, double rightLockedY, bool rightLocked);
     void handleTouchMovementUpdate(int touchId, bool& touchActive, bool bumperPressed, bool stickPressPressed,
                                   int& heldDirection, bool& pointerLocked, int& lockedDirection,
-                                  double currentX, double currentY, double angle, int direction,
+                                  double currentX, double currentY, int direction,
                                   bool otherTouchActive);
     
+    // Shared by mouse and keyboard mode
+    void queueInput(const INPUT& input);
+    void flushInputFrame();
+    
     // ========== Mouse Mode Methods (forward declarations) ==========
     // These are implemented in MouseMode.cpp
     void moveMouseToCenter();
@@ -269,9 +1236,11 @@ private:
     
     // ========== Keyboard Mode Methods (forward declarations) ==========
     // These are implemented in KeyboardMode.cpp
-    int getKeyCode(const std::string& key);
-    void simulateKeyPress(int keyCode, bool isDown);
-    void sendKeyPress(const std::string& key, bool isDown);
+    static SectorLayout defaultSectorLayout();
+    static bool compileSectorLayout(const std::string& path, SectorLayout& layout);
+    static bool parseSectorAction(const std::string& name, SectorAction& action);
+    void sendSectorAction(const SectorAction& action, bool isDown);
+    static bool sameSectorAction(const SectorAction& a, const SectorAction& b);
     
     // ========== Static Variables for Debug ==========
     static inline bool g_anyButtonPressed = false;
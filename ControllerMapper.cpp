@@ -2,63 +2,116 @@
 
 // ========== Constructor & Initialization ==========
 
-ControllerMapper::ControllerMapper(InputMode mode) : di(nullptr), joystick(nullptr), hwnd(nullptr), overlayHwnd(nullptr),
-                    hasXInputController(false), xInputControllerIndex(0),
-                    overlayLeftX(0.0), overlayLeftY(0.0), overlayRightX(0.0), overlayRightY(0.0),
-                    overlayLeftAngle(-1.0), overlayRightAngle(-1.0), overlayStickRadius(150),
-                    overlayLeftAlpha(0), overlayRightAlpha(0), updateIntervalMs(16),
-                    overlayLeftLockedX(0.0), overlayLeftLockedY(0.0), overlayRightLockedX(0.0), overlayRightLockedY(0.0),
-                    overlayLeftLockedAlpha(0), overlayRightLockedAlpha(0),
-                    overlayL3CenterX(0.0), overlayL3CenterY(0.0),
-                    overlayR3CenterX(0.0), overlayR3CenterY(0.0),
-                    overlayL3Alpha(0), overlayR3Alpha(0),
-                    prevOverlayLeftX(-999.0), prevOverlayLeftY(-999.0), prevOverlayRightX(-999.0), prevOverlayRightY(-999.0),
-                    prevOverlayLeftAngle(-999.0), prevOverlayRightAngle(-999.0),
-                    prevOverlayLeftAlpha(-1), prevOverlayRightAlpha(-1),
-                    prevOverlayLeftLockedAlpha(-1), prevOverlayRightLockedAlpha(-1),
-                    prevOverlayLeftLockedX(-999.0), prevOverlayLeftLockedY(-999.0),
-                    prevOverlayRightLockedX(-999.0), prevOverlayRightLockedY(-999.0),
-                    prevOverlayL3CenterX(-999.0), prevOverlayL3CenterY(-999.0),
-                    prevOverlayR3CenterX(-999.0), prevOverlayR3CenterY(-999.0),
-                    prevOverlayL3Alpha(-1), prevOverlayR3Alpha(-1),
-                    currentMode(mode), leftTouchActive(false), rightTouchActive(false), 
-                    prevL1(false), prevR1(false),
+ControllerMapper::ControllerMapper(const MapperSettings& settings) : di(nullptr), hwnd(nullptr), overlayHwnd(nullptr),
+                    controllerCount(1), useBufferedDirectInput(settings.bufferedDirectInput),
+                    diButtonMap(settings.diButtons), diMappedButtons{},
+                    profileControllers(settings.profileControllers), profilePath(settings.profilePath),
+                    overlayStickRadius(150), refreshRateHz(60),
+                    currentMode(settings.mode), requestedMode(-1),
                     overlayPosX(0), overlayPosY(0), inputInjector(nullptr), inputInjectorInitialized(false),
-                    currentLHeldDirection(-1), currentRHeldDirection(-1),
-                    leftPointerLocked(false), rightPointerLocked(false),
-                    leftLockedDirection(-1), rightLockedDirection(-1),
-                    prevL2(false), prevR2(false),
-                    prevL3(false), prevR3(false),
-                    l3TouchActive(false), r3TouchActive(false),
-                    touchActive{false, false, false, false, false, false, false, false, false, false},
-                    touchX{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
-                    touchY{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
-                    mouseButtonPressed(false), alternateFrame(false), currentLeftKey(""), currentRightKey(""),
-                    debugText(""), showDebugInfo(true), lastMousePos({-1, -1}) {
+                    touchActive{}, touchX{}, touchY{},
+                    mouseButtonPressed(false), alternateFrame(false), layoutPath(settings.layoutPath), currentLeftSector(-1), currentRightSector(-1), inputFrame{}, inputFrameCount(0),
+                    showDebugInfo(true),
+                    overlayBackend(settings.overlayBackend), overlayMaskPass(false), paintRegion(nullptr), scratchRegion(nullptr),
+                    overlayDirtyRectCount(0), debugTextRect{},
+                    gpuDevice(nullptr), gpuSwapChain(nullptr), gpuFrameWaitable(nullptr), gpuFramePresented(false), gpuFrameDirty(false), gpuRecoveryAttempts(0),
+                    dcompDevice(nullptr), dcompTarget(nullptr), dcompVisual(nullptr),
+                    d2dFactory(nullptr), d2dContext(nullptr), d2dTarget(nullptr), d2dBrush(nullptr), gpuArcs{},
+                    gpuArcRadius(0), gpuArcCenterX(0), gpuArcCenterY(0),
+                    dwriteFactory(nullptr), debugTextFormat(nullptr), touchIdTextFormat(nullptr), gpuWidth(0), gpuHeight(0),
+                    pollThreadRunning(false), pollRateHz(settings.pollRateHz),
+                    idleMs(settings.idleMs), pollIdle(false), lastActiveTicks(0),
+                    recordPath(settings.recordPath), recordStartTicks(0), replayPath(settings.replayPath),
+                    replaying(!settings.replayPath.empty()), replayFullSpeed(settings.replayFullSpeed), replayFinished(false), lastDebugUpdateTicks(0), debugRefreshHz(settings.debugRefreshHz),
+                    paintStateVersion(0), debugTextVersion(0), paintDebugTextVersion(0),
+                    pollTopologyVersion(~0u),
+                    touchFramePending(false), injectedTouchActive{}, injectedTouchX{}, injectedTouchY{},
+                    palmInjectionMode(settings.palmMode), palmStaggerUs(settings.palmStaggerUs), lastPalmSpreadUs(0.0),
+                    predictionMs(settings.predictionMs), touchUpsampleHz(settings.touchUpsampleHz),
+                    touchInfoPoolRadius{},
+                    currentSampleTicks(0), paintingSampleTicks(0), lastPaintedSampleTicks(0),
+                    showPerfHud(false), perfHudPeriods{}, perfHudPeriodCount(0), perfHudTargetUs(0.0), perfHudRect{}, perfHudRefreshTicks(0) {
+    // Worst case is every contact of every controller in one frame - never reallocate on the injection path
+    touchFrameBuffer.reserve(MAX_TOUCH_IDS);
+    
+    for (int i = 0; i < MAX_CONTROLLERS; i++) {
+        controllers[i].index = i;
+        controllers[i].touchIdBase = i * TOUCHES_PER_CONTROLLER;
+        pollOverlay.rings[i].touchIdBase = controllers[i].touchIdBase;
+    }
+    
+    // The whole recording buffer up front - recordSample stops when it is full
+    if (!recordPath.empty()) {
+        recordedSamples.reserve(MAX_RECORDED_SAMPLES);
+    }
+    
+    // Keep the polling rate within what Sleep()/the controller can actually deliver
+    if (pollRateHz < MIN_POLL_RATE_HZ) pollRateHz = MIN_POLL_RATE_HZ;
+    if (pollRateHz > MAX_POLL_RATE_HZ) pollRateHz = MAX_POLL_RATE_HZ;
+    if (predictionMs < 0) predictionMs = 0;
+    if (predictionMs > MAX_PREDICTION_MS) predictionMs = MAX_PREDICTION_MS;
+    if (touchUpsampleHz < 0) touchUpsampleHz = 0;
+    if (touchUpsampleHz > MAX_UPSAMPLE_HZ) touchUpsampleHz = MAX_UPSAMPLE_HZ;
+    if (idleMs < 0) idleMs = 0;
+    stickConditioner.build(settings.conditioning);
+    
+    // Buffered DirectInput dispatches an edge on any of these immediately
+    const BYTE mappedButtons[] = { diButtonMap.l1, diButtonMap.r1, diButtonMap.l2, diButtonMap.r2, diButtonMap.l3, diButtonMap.r3 };
+    for (BYTE button : mappedButtons) {
+        if (button < 128) {
+            diMappedButtons[button] = true;
+        }
+    }
+    if (debugRefreshHz < 1) debugRefreshHz = 1;
+    
+    // Keyboard mode layout is compiled once - no names or MapVirtualKey on the input path
+    keyboardLayout = defaultSectorLayout();
+    if (!layoutPath.empty() && !compileSectorLayout(layoutPath, keyboardLayout)) {
+        logError("Using the default 1-8 keyboard layout");
+    }
+    
     // Don't initialize controllers or create GUI in constructor
     // This will be done in the main loop
     
     // Initialize WinRT
     init_apartment();
+    
+    // Polling/overlay thread messages go through the async log from here on
+    asyncLog.start(settings.logPath);
 }
 
 bool ControllerMapper::initialize() {
-    initializeControllers();
+    if (replaying) {
+        if (!initializeReplay()) {
+            return false;
+        }
+    } else {
+        initializeControllers();
+    }
     createGUI();
     return (hwnd != nullptr);
 }
 
 ControllerMapper::~ControllerMapper() {
-    if (joystick) {
-        joystick->Unacquire();
-        joystick->Release();
+    stopPollThread();
+    saveRecording();
+    asyncLog.stop();  // Polling thread is gone - flush what it logged
+    for (ControllerSlot& slot : controllers) {
+        releaseController(slot);
     }
     if (di) {
         di->Release();
     }
+    releaseGpuOverlay();
     if (overlayHwnd) {
         DestroyWindow(overlayHwnd);
     }
+    if (paintRegion) {
+        DeleteObject(paintRegion);
+    }
+    if (scratchRegion) {
+        DeleteObject(scratchRegion);
+    }
     if (hwnd) {
         DestroyWindow(hwnd);
     }
@@ -142,38 +195,23 @@ void ControllerMapper::detectMonitorFromCursor(bool verbose) {
         primaryMonitorTop = cachedPrimaryTop;
     }
     
-    // Enumerate all monitors to find which one contains the cursor
-    struct MonitorEnumData {
-        POINT point;
-        HMONITOR foundMonitor;
-        bool found;
-    };
-    
-    MonitorEnumData enumData = { {cursorPos.x, cursorPos.y}, nullptr, false };
-    
-    struct MonitorEnumHelper {
-        static BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
-            MonitorEnumData* data = reinterpret_cast<MonitorEnumData*>(dwData);
-            MONITORINFOEX infoEx = {};
-            infoEx.cbSize = sizeof(MONITORINFOEX);
-            
-            if (GetMonitorInfo(hMonitor, (MONITORINFO*)&infoEx)) {
-                if (data->point.x >= infoEx.rcMonitor.left && data->point.x < infoEx.rcMonitor.right &&
-                    data->point.y >= infoEx.rcMonitor.top && data->point.y < infoEx.rcMonitor.bottom) {
-                    data->foundMonitor = hMonitor;
-                    data->found = true;
-                    return FALSE; // Stop enumeration
-                }
-            }
-            return TRUE; // Continue enumeration
+    // Find which cached monitor contains the cursor (no enumeration on the hot path)
+    if (monitorTopology.monitorCount == 0) {
+        rebuildMonitorTopology();
+    }
+    HMONITOR foundMonitor = nullptr;
+    for (int i = 0; i < monitorTopology.monitorCount; i++) {
+        const MonitorTopology::Monitor& m = monitorTopology.monitors[i];
+        if (cursorPos.x >= m.left && cursorPos.x < m.left + m.width &&
+            cursorPos.y >= m.top && cursorPos.y < m.top + m.height) {
+            foundMonitor = m.handle;
+            break;
         }
-    };
-    
-    EnumDisplayMonitors(nullptr, nullptr, MonitorEnumHelper::MonitorEnumProc, (LPARAM)&enumData);
+    }
     
-    if (enumData.found) {
+    if (foundMonitor) {
         // Check if monitor changed
-        HMONITOR newMonitorHandle = enumData.foundMonitor;
+        HMONITOR newMonitorHandle = foundMonitor;
         bool monitorChanged = (monitorHandle != newMonitorHandle);
         
         // Only proceed if monitor handle actually changed
@@ -194,6 +232,10 @@ void ControllerMapper::detectMonitorFromCursor(bool verbose) {
                     std::cout << "Monitor changed! New monitor: " << newMonitorWidth << "x" << newMonitorHeight 
                               << " at (" << newMonitorLeft << ", " << newMonitorTop << ")" << std::endl;
                     std::cout << "Monitor name: " << monitorInfoEx.szDevice << std::endl;
+                } else {
+                    // Overlay-thread check (checkMonitorChange, WM_DISPLAYCHANGE)
+                    MAPPER_LOG(asyncLog.overlay, LogLevel::Info, "Monitor changed! New monitor: %dx%d at (%d, %d), %s",
+                               newMonitorWidth, newMonitorHeight, newMonitorLeft, newMonitorTop, monitorInfoEx.szDevice);
                 }
                 
                 // Update monitor handle and info
@@ -248,33 +290,27 @@ POINT ControllerMapper::checkMonitorChange() {
 }
 
 void ControllerMapper::updateRefreshRate() {
-    // Get screen refresh rate from the detected monitor
-    MONITORINFOEX monitorInfoEx = {};
-    monitorInfoEx.cbSize = sizeof(MONITORINFOEX);
+    // Get screen refresh rate of the detected monitor from the topology cache
+    // (rebuilt on WM_DISPLAYCHANGE, so mode changes are picked up)
     int refreshRate = 60; // Default fallback
-    
-    if (GetMonitorInfo(monitorHandle, (MONITORINFO*)&monitorInfoEx)) {
-        HDC monitorDC = CreateDC(TEXT("DISPLAY"), monitorInfoEx.szDevice, nullptr, nullptr);
-        if (monitorDC) {
-            refreshRate = GetDeviceCaps(monitorDC, VREFRESH);
-            DeleteDC(monitorDC);
+    for (int i = 0; i < monitorTopology.monitorCount; i++) {
+        if (monitorTopology.monitors[i].handle == monitorHandle) {
+            refreshRate = monitorTopology.monitors[i].refreshRate;
+            break;
         }
     }
     
-    // Calculate update interval based on refresh rate
-    int newUpdateIntervalMs;
-    if (refreshRate > 1) {
-        newUpdateIntervalMs = 1000 / refreshRate;
-    } else {
-        // Fallback to 60Hz if detection fails
-        newUpdateIntervalMs = 16;
+    // Fallback to 60Hz if detection fails
+    if (refreshRate <= 1) {
+        refreshRate = 60;
     }
     
     // Only update if refresh rate actually changed
-    if (updateIntervalMs != newUpdateIntervalMs) {
-        updateIntervalMs = newUpdateIntervalMs;
-        std::cout << "Monitor refresh rate changed to: " << refreshRate << "Hz" << std::endl;
-        std::cout << "Update interval changed to: " << updateIntervalMs << "ms" << std::endl;
+    if (refreshRateHz != refreshRate) {
+        refreshRateHz = refreshRate;
+        overlayPacer.setRate(refreshRate);
+        MAPPER_LOG(asyncLog.overlay, LogLevel::Info, "Monitor refresh rate changed to: %dHz", refreshRate);
+        MAPPER_LOG(asyncLog.overlay, LogLevel::Info, "Overlay frame period changed to: %gms", overlayPacer.getTargetPeriodMs());
     }
 }
 
@@ -325,10 +361,140 @@ void ControllerMapper::updateOverlayPosition() {
     // Don't force immediate redraw - let Windows handle it naturally to reduce flicker
     // The window will redraw on next paint cycle
     
-    std::cout << "Overlay repositioned to: (" << overlayPosX << ", " << overlayPosY << ")" << std::endl;
+    MAPPER_LOG(asyncLog.overlay, LogLevel::Info, "Overlay repositioned to: (%d, %d)", overlayPosX, overlayPosY);
 }
 
-void ControllerMapper::createOverlay() {
+void ControllerMapper::rebuildMonitorTopology() {
+    // Runs on the main thread on display changes and overlay moves - everything the
+    // touch path used to query per touch is captured here once
+    MonitorTopology topology;
+    
+    struct MonitorEnumHelper {
+        static BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
+            MonitorTopology* topology = reinterpret_cast<MonitorTopology*>(dwData);
+            if (topology->monitorCount >= MonitorTopology::MAX_MONITORS) {
+                return FALSE;
+            }
+            
+            MONITORINFOEX monitorInfo = {};
+            monitorInfo.cbSize = sizeof(MONITORINFOEX);
+            if (GetMonitorInfo(hMonitor, (MONITORINFO*)&monitorInfo)) {
+                MonitorTopology::Monitor& m = topology->monitors[topology->monitorCount++];
+                m.handle = hMonitor;
+                m.left = monitorInfo.rcMonitor.left;
+                m.top = monitorInfo.rcMonitor.top;
+                m.width = monitorInfo.rcMonitor.right - monitorInfo.rcMonitor.left;
+                m.height = monitorInfo.rcMonitor.bottom - monitorInfo.rcMonitor.top;
+                m.isPrimary = (monitorInfo.dwFlags & MONITORINFOF_PRIMARY) != 0;
+                strcpy_s(m.device, monitorInfo.szDevice);
+                
+                // DPI and refresh rate need a display DC - query them here once instead of per use
+                m.dpiX = 96;
+                m.dpiY = 96;
+                m.refreshRate = 60;
+                HDC monitorDC = CreateDC(TEXT("DISPLAY"), monitorInfo.szDevice, nullptr, nullptr);
+                if (monitorDC) {
+                    m.dpiX = GetDeviceCaps(monitorDC, LOGPIXELSX);
+                    m.dpiY = GetDeviceCaps(monitorDC, LOGPIXELSY);
+                    m.refreshRate = GetDeviceCaps(monitorDC, VREFRESH);
+                    DeleteDC(monitorDC);
+                }
+                if (m.dpiX <= 0) m.dpiX = 96;
+                if (m.dpiY <= 0) m.dpiY = 96;
+            }
+            return TRUE; // Continue enumeration
+        }
+    };
+    EnumDisplayMonitors(nullptr, nullptr, MonitorEnumHelper::MonitorEnumProc, (LPARAM)&topology);
+    
+    // Overlay centre in virtual screen space, from the actual window rect
+    RECT overlayRect = {};
+    HMONITOR overlayMonitor = nullptr;
+    if (overlayHwnd && GetWindowRect(overlayHwnd, &overlayRect)) {
+        overlayMonitor = MonitorFromWindow(overlayHwnd, MONITOR_DEFAULTTONEAREST);
+    }
+    topology.overlayCenterX = overlayRect.left + (overlayRect.right - overlayRect.left) / 2;
+    topology.overlayCenterY = overlayRect.top + (overlayRect.bottom - overlayRect.top) / 2;
+    topology.stickRadius = overlayStickRadius;
+    RECT overlayClient = { 0, 0, overlayRect.right - overlayRect.left, overlayRect.bottom - overlayRect.top };
+    for (int ring = 0; ring < controllerCount; ring++) {
+        int ringCenterX, ringCenterY;
+        getRingCenter(ring, controllerCount, overlayClient, ringCenterX, ringCenterY);
+        topology.ringOffsetX[ring] = ringCenterX - overlayClient.right / 2;
+    }
+    topology.virtualLeft = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    topology.virtualTop = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    topology.virtualWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    topology.virtualHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+    if (topology.virtualWidth < 1) topology.virtualWidth = 1;
+    if (topology.virtualHeight < 1) topology.virtualHeight = 1;
+    
+    int primaryIndex = -1;
+    int secondaryIndex = -1;
+    for (int i = 0; i < topology.monitorCount; i++) {
+        if (topology.currentIndex < 0 && topology.monitors[i].handle == overlayMonitor) {
+            topology.currentIndex = i;
+        }
+        if (topology.monitors[i].isPrimary) {
+            primaryIndex = i;
+        } else {
+            secondaryIndex = i;
+        }
+    }
+    for (int i = 0; i < topology.monitorCount && topology.currentIndex >= 0; i++) {
+        if (i != topology.currentIndex) {
+            topology.otherIndex = i;
+            break;
+        }
+    }
+    
+    // Default: virtual coordinates work as-is (single monitor, primary left/above)
+    topology.touchXTransform.base = topology.overlayCenterX;
+    topology.touchYTransform.base = topology.overlayCenterY;
+    
+    if (topology.currentIndex >= 0 && topology.otherIndex >= 0 && primaryIndex >= 0 && secondaryIndex >= 0) {
+        const MonitorTopology::Monitor& current = topology.monitors[topology.currentIndex];
+        const MonitorTopology::Monitor& other = topology.monitors[topology.otherIndex];
+        const MonitorTopology::Monitor& primary = topology.monitors[primaryIndex];
+        const MonitorTopology::Monitor& secondary = topology.monitors[secondaryIndex];
+        
+        // InputInjector's "opposite monitor" routing behavior:
+        // - When primary is RIGHT of secondary: coordinates on primary route to secondary (wrong)
+        // - When primary is BELOW secondary: coordinates may route wrong
+        // - Primary LEFT/ABOVE: virtual coordinates work correctly
+        bool primaryIsRight = (primary.left > secondary.left);
+        bool primaryIsBelow = (primary.top > secondary.top);
+        
+        if (primaryIsRight && current.isPrimary) {
+            // Send coordinate past current monitor (relativeX + width) that InputInjector will route back
+            topology.touchXTransform.base = topology.overlayCenterX - current.left;
+            topology.touchXTransform.offset = current.width;
+        } else if (primaryIsRight) {
+            // Equivalent position on the other monitor (InputInjector routes back to current)
+            topology.touchXTransform.base = topology.overlayCenterX - current.left;
+            topology.touchXTransform.mapped = true;
+            topology.touchXTransform.scale = (other.width == current.width) ? 1.0 : ((double)other.width / current.width);
+            topology.touchXTransform.clampMax = other.width - 1;
+            topology.touchXTransform.offset = other.left;
+        }
+        
+        if (primaryIsBelow && current.isPrimary) {
+            topology.touchYTransform.base = topology.overlayCenterY - current.top;
+            topology.touchYTransform.offset = current.height;
+        } else if (primaryIsBelow) {
+            topology.touchYTransform.base = topology.overlayCenterY - current.top;
+            topology.touchYTransform.mapped = true;
+            topology.touchYTransform.scale = (other.height == current.height) ? 1.0 : ((double)other.height / current.height);
+            topology.touchYTransform.clampMax = other.height - 1;
+            topology.touchYTransform.offset = other.top;
+        }
+    }
+    
+    monitorTopology = topology;
+    sharedTopology.write(topology);
+}
+
+void ControllerMapper::createOverlay(bool fromOverlayLoop) {
     // Register overlay window class
     WNDCLASSEXA overlayWc = {};
     overlayWc.cbSize = sizeof(WNDCLASSEXA);
@@ -354,6 +520,10 @@ void ControllerMapper::createOverlay() {
     // Use height as reference since width is now full-screen
     overlayStickRadius = (int)(overlayHeight * 0.45); // 45% of height (90% of half = radius)
     
+    // Several controllers share the width - each ring also has to fit its own column
+    int columnRadius = (int)(overlayWidth * 0.45 / controllerCount);
+    if (columnRadius < overlayStickRadius) overlayStickRadius = columnRadius;
+    
     // Get screen refresh rate from the detected monitor (using helper function)
     updateRefreshRate();
     
@@ -365,12 +535,23 @@ void ControllerMapper::createOverlay() {
     overlayPosX = posX;
     overlayPosY = posY;
     
-    std::cout << "Overlay positioned at: (" << overlayPosX << ", " << overlayPosY << ")" << std::endl;
-    std::cout << "Overlay center will be at: (" << overlayPosX + overlayWidth / 2 << ", " << overlayPosY + overlayHeight / 2 << ")" << std::endl;
+    if (!fromOverlayLoop) {
+        std::cout << "Overlay positioned at: (" << overlayPosX << ", " << overlayPosY << ")" << std::endl;
+        std::cout << "Overlay center will be at: (" << overlayPosX + overlayWidth / 2 << ", " << overlayPosY + overlayHeight / 2 << ")" << std::endl;
+    } else {
+        // Re-created from the overlay loop after the GPU overlay gave up (recoverGpuOverlay)
+        MAPPER_LOG(asyncLog.overlay, LogLevel::Info, "Overlay re-created at: (%d, %d)", overlayPosX, overlayPosY);
+    }
     
     // Create transparent overlay window (always on top, click-through, no activation)
+    // The GPU backend composes a swap chain instead of a redirection bitmap; it stays
+    // layered only so WS_EX_TRANSPARENT keeps it click-through
+    DWORD exStyle = WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE;
+    if (overlayBackend == OverlayBackend::GpuComposition) {
+        exStyle |= WS_EX_NOREDIRECTIONBITMAP;
+    }
     overlayHwnd = CreateWindowExA(
-        WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE,
+        exStyle,
         "StickOverlay",
         "Stick Position Overlay",
         WS_POPUP,
@@ -380,16 +561,48 @@ void ControllerMapper::createOverlay() {
     );
 
     if (!overlayHwnd) {
-        logError("Failed to create overlay window!");
+        if (fromOverlayLoop) {
+            MAPPER_LOG(asyncLog.overlay, LogLevel::Error, "Failed to create overlay window!");
+        } else {
+            logError("Failed to create overlay window!");
+        }
         return;
     }
 
-    // Set transparency - make black (RGB(0,0,0)) completely transparent
-    // This way only the drawn graphics are visible, not the background
-    SetLayeredWindowAttributes(overlayHwnd, RGB(0, 0, 0), 0, LWA_COLORKEY);
+    if (overlayBackend == OverlayBackend::ColorKeyGdi) {
+        // Set transparency - make black (RGB(0,0,0)) completely transparent
+        // This way only the drawn graphics are visible, not the background
+        SetLayeredWindowAttributes(overlayHwnd, RGB(0, 0, 0), 0, LWA_COLORKEY);
+    }
+    // (LayeredAlpha: no attributes - the window content comes from UpdateLayeredWindowIndirect)
+    
+    if (overlayBackend == OverlayBackend::GpuComposition) {
+        SetLayeredWindowAttributes(overlayHwnd, 0, 255, LWA_ALPHA);
+        if (!initializeGpuOverlay(fromOverlayLoop)) {
+            // No usable Direct3D/DirectComposition - rebuild the window for the per-pixel-alpha GDI path
+            logError("GPU overlay unavailable - falling back to per-pixel alpha overlay");
+            DestroyWindow(overlayHwnd);
+            overlayHwnd = nullptr;
+            overlayBackend = OverlayBackend::LayeredAlpha;
+            createOverlay(fromOverlayLoop);
+            return;
+        }
+    }
+    
+    // Reused for every repaint to hold the dirty area
+    if (!paintRegion) {
+        paintRegion = CreateRectRgn(0, 0, 0, 0);
+        scratchRegion = CreateRectRgn(0, 0, 0, 0);
+    }
 
     ShowWindow(overlayHwnd, SW_SHOW);
     UpdateWindow(overlayHwnd);
+    if (overlayBackend != OverlayBackend::ColorKeyGdi) {
+        redrawOverlay(); // Without WM_PAINT nothing shows until the first frame is pushed
+    }
+    
+    // Touch mapping needs the overlay's final position
+    rebuildMonitorTopology();
     
     // Initialize touch injection (only if in touch mode)
     if (currentMode == InputMode::Touch) {
@@ -400,6 +613,17 @@ void ControllerMapper::createOverlay() {
 // ========== Controller Initialization ==========
 
 void ControllerMapper::initializeControllers() {
+    // A profile names the controllers outright - no enumeration, no menu
+    if (!profileControllers.empty()) {
+        if (openProfileControllers()) {
+            std::cout << "Controller initialized successfully! Opening GUI..." << std::endl;
+            detectMonitorFromCursor(true);
+            createOverlay();
+            return;
+        }
+        std::cout << "Profile controller not available - choose one (the profile is updated)" << std::endl;
+    }
+    
     // List all available controllers and let user choose
     std::vector<ControllerInfo> availableControllers = listAllControllers();
     
@@ -418,20 +642,10 @@ void ControllerMapper::initializeControllers() {
     int selectedIndex = getControllerSelection(availableControllers.size());
     
     if (selectedIndex >= 0 && selectedIndex < availableControllers.size()) {
-        ControllerInfo selected = availableControllers[selectedIndex];
-        if (selected.type == ControllerType::XInput) {
-            hasXInputController = true;
-            xInputControllerIndex = selected.index;
-            std::cout << "Selected XInput controller: " << selected.name << std::endl;
-        } else {
-            if (initializeDirectInputWithDevice(selected.guid)) {
-                std::cout << "Selected DirectInput controller: " << selected.name << std::endl;
-            } else {
-                logError("Failed to initialize selected controller!");
-                std::cerr << "Press any key to exit..." << std::endl;
-                _getch();
-                exit(1);
-            }
+        if (!openController(controllers[0], availableControllers[selectedIndex])) {
+            std::cerr << "Press any key to exit..." << std::endl;
+            _getch();
+            exit(1);
         }
     } else {
         std::cerr << "Invalid selection!" << std::endl;
@@ -439,6 +653,14 @@ void ControllerMapper::initializeControllers() {
         _getch();
         exit(1);
     }
+    controllerCount = 1;
+    
+    // Touch mode can drive one ring per controller; mouse and keyboard only have one cursor
+    if (currentMode == InputMode::Touch && availableControllers.size() > 1) {
+        std::vector<bool> taken(availableControllers.size(), false);
+        taken[selectedIndex] = true;
+        selectAdditionalControllers(availableControllers, taken);
+    }
     
     std::cout << "Controller initialized successfully! Opening GUI..." << std::endl;
     
@@ -446,6 +668,12 @@ void ControllerMapper::initializeControllers() {
     // and create the overlay on that monitor
     detectMonitorFromCursor(true); // Verbose on first detection
     createOverlay();
+    
+    // Next start (and restart) opens the same setup without asking - after createOverlay,
+    // so a GPU overlay that fell back is saved as what actually runs
+    if (!profilePath.empty()) {
+        saveProfile();
+    }
 }
 
 std::vector<ControllerInfo> ControllerMapper::listAllControllers() {
@@ -464,6 +692,9 @@ std::vector<ControllerInfo> ControllerMapper::listAllControllers() {
         }
     }
     
+    // List DualShock 4 controllers readable as raw HID (these also appear under DirectInput)
+    listDualShock4Controllers(controllers);
+    
     // List DirectInput controllers
     if (!di) {
         HRESULT hr = DirectInput8Create(GetModuleHandle(nullptr), DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&di, nullptr);
@@ -490,7 +721,8 @@ void ControllerMapper::displayControllerMenu(const std::vector<ControllerInfo>&
     std::cout << "Available controllers:" << std::endl;
     
     for (size_t i = 0; i < controllers.size(); i++) {
-        std::string typeStr = (controllers[i].type == ControllerType::XInput) ? "XInput" : "DirectInput";
+        std::string typeStr = (controllers[i].type == ControllerType::XInput) ? "XInput" :
+                              (controllers[i].type == ControllerType::DualShock4Hid) ? "DualShock 4 HID" : "DirectInput";
         std::cout << "[" << (i + 1) << "] " << controllers[i].name << " (" << typeStr << ")" << std::endl;
     }
     
@@ -498,21 +730,85 @@ void ControllerMapper::displayControllerMenu(const std::vector<ControllerInfo>&
 }
 
 int ControllerMapper::getControllerSelection(int maxControllers) {
+    // Blocks in _getch - nothing to do until a key arrives
     while (true) {
-        if (_kbhit()) {
-            int key = _getch();
-            if (key >= '1' && key <= '9') {
-                int selection = key - '1';
-                if (selection < maxControllers) {
-                    return selection;
-                }
+        int key = _getch();
+        if (key >= '1' && key <= '9') {
+            int selection = key - '1';
+            if (selection < maxControllers) {
+                return selection;
             }
         }
-        Sleep(SELECTION_SLEEP_MS);
     }
 }
 
-bool ControllerMapper::initializeDirectInputWithDevice(const GUID& deviceGuid) {
+bool ControllerMapper::openController(ControllerSlot& slot, const ControllerInfo& info) {
+    slot.type = info.type;
+    slot.source = info;
+    if (info.type == ControllerType::XInput) {
+        slot.xInputIndex = info.index;
+        std::cout << "Selected XInput controller: " << info.name << std::endl;
+    } else if (info.type == ControllerType::DualShock4Hid) {
+        if (!initializeDualShock4(slot, info.devicePath)) {
+            logError("Failed to open DualShock 4 HID device!");
+            return false;
+        }
+        std::cout << "Selected DualShock 4 (HID): " << info.name << std::endl;
+    } else {
+        if (!initializeDirectInputWithDevice(slot, info.guid)) {
+            logError("Failed to initialize selected controller!");
+            releaseController(slot);
+            return false;
+        }
+        std::cout << "Selected DirectInput controller: " << info.name << std::endl;
+    }
+    return true;
+}
+
+void ControllerMapper::selectAdditionalControllers(const std::vector<ControllerInfo>& available, std::vector<bool>& taken) {
+    while (controllerCount < MAX_CONTROLLERS) {
+        ControllerSlot& slot = controllers[controllerCount];
+        std::cout << "\r\nPress another number to add controller " << (controllerCount + 1)
+                  << " (its own ring, touch IDs " << slot.touchIdBase << "-" << (slot.touchIdBase + TOUCHES_PER_CONTROLLER - 1)
+                  << "), or any other key to start:" << std::endl;
+        
+        int key = _getch();
+        int selection = key - '1';
+        if (key < '1' || key > '9' || selection >= (int)available.size()) {
+            break;
+        }
+        if (taken[selection]) {
+            std::cout << "Already selected" << std::endl;
+            continue;
+        }
+        if (openController(slot, available[selection])) {
+            taken[selection] = true;
+            controllerCount++;
+        }
+    }
+    if (controllerCount > 1) {
+        std::cout << controllerCount << " controllers selected" << std::endl;
+    }
+}
+
+void ControllerMapper::releaseController(ControllerSlot& slot) {
+    if (slot.joystick) {
+        slot.joystick->Unacquire();
+        if (slot.diEvent) {
+            slot.joystick->SetEventNotification(nullptr);
+        }
+        slot.joystick->Release();
+        slot.joystick = nullptr;
+    }
+    if (slot.diEvent) {
+        CloseHandle(slot.diEvent);
+        slot.diEvent = nullptr;
+    }
+    slot.diBuffered = false;
+    closeDualShock4(slot);
+}
+
+bool ControllerMapper::initializeDirectInputWithDevice(ControllerSlot& slot, const GUID& deviceGuid) {
     if (!di) {
         HRESULT hr = DirectInput8Create(GetModuleHandle(nullptr), DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&di, nullptr);
         if (FAILED(hr)) {
@@ -520,28 +816,55 @@ bool ControllerMapper::initializeDirectInputWithDevice(const GUID& deviceGuid) {
         }
     }
 
-    HRESULT hr = di->CreateDevice(deviceGuid, &joystick, nullptr);
+    HRESULT hr = di->CreateDevice(deviceGuid, &slot.joystick, nullptr);
     if (FAILED(hr)) {
         return false;
     }
 
     // Set data format - use DIJOYSTATE2 for extended axes (includes sliders for DS4 touchpad)
-    hr = joystick->SetDataFormat(&c_dfDIJoystick2);
+    hr = slot.joystick->SetDataFormat(&c_dfDIJoystick2);
     if (FAILED(hr)) {
         return false;
     }
 
     // Set cooperative level
-    hr = joystick->SetCooperativeLevel(hwnd, DISCL_NONEXCLUSIVE | DISCL_BACKGROUND);
+    hr = slot.joystick->SetCooperativeLevel(hwnd, DISCL_NONEXCLUSIVE | DISCL_BACKGROUND);
     if (FAILED(hr)) {
-        hr = joystick->SetCooperativeLevel(hwnd, DISCL_NONEXCLUSIVE | DISCL_FOREGROUND);
+        hr = slot.joystick->SetCooperativeLevel(hwnd, DISCL_NONEXCLUSIVE | DISCL_FOREGROUND);
         if (FAILED(hr)) {
             return false;
         }
     }
 
+    // Buffered mode: give the device an event queue and a wake-up event so the polling
+    // thread sees every button edge instead of one GetDeviceState snapshot per period
+    // (must be configured before Acquire)
+    slot.diBuffered = useBufferedDirectInput;
+    if (slot.diBuffered) {
+        DIPROPDWORD bufferSize = {};
+        bufferSize.diph.dwSize = sizeof(DIPROPDWORD);
+        bufferSize.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+        bufferSize.diph.dwObj = 0;
+        bufferSize.diph.dwHow = DIPH_DEVICE;
+        bufferSize.dwData = DI_BUFFER_SIZE;
+        
+        hr = slot.joystick->SetProperty(DIPROP_BUFFERSIZE, &bufferSize.diph);
+        if (SUCCEEDED(hr)) {
+            if (!slot.diEvent) {
+                slot.diEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+            }
+            hr = slot.diEvent ? slot.joystick->SetEventNotification(slot.diEvent) : E_FAIL;
+        }
+        
+        if (FAILED(hr)) {
+            // Still works, just with one sample per poll period
+            std::cout << "Buffered DirectInput unavailable, falling back to polling" << std::endl;
+            slot.diBuffered = false;
+        }
+    }
+
     // Acquire the device
-    hr = joystick->Acquire();
+    hr = slot.joystick->Acquire();
     return SUCCEEDED(hr);
 }
 
@@ -568,75 +891,57 @@ void ControllerMapper::updateTouchPointerPosition(bool touchActive, bool pointer
     }
 }
 
-void ControllerMapper::updateOverlay(double leftX, double leftY, double rightX, double rightY, double leftAngle, double rightAngle) {
-    overlayLeftX = leftX;
-    overlayLeftY = leftY;
-    overlayRightX = rightX;
-    overlayRightY = rightY;
-    overlayLeftAngle = leftAngle;
-    overlayRightAngle = rightAngle;
+void ControllerMapper::updateOverlay(const ControllerSlot& slot, double leftX, double leftY, double rightX, double rightY, int leftDirection, int rightDirection) {
+    RingSnapshot& overlay = pollOverlay.rings[slot.index];
+    overlay.leftX = leftX;
+    overlay.leftY = leftY;
+    overlay.rightX = rightX;
+    overlay.rightY = rightY;
     
     // Calculate alpha values using helper function
     double leftDistance = std::sqrt(leftX * leftX + leftY * leftY);
     double rightDistance = std::sqrt(rightX * rightX + rightY * rightY);
-    overlayLeftAlpha = calculateAlpha(leftDistance, leftTouchActive, leftPointerLocked);
-    overlayRightAlpha = calculateAlpha(rightDistance, rightTouchActive, rightPointerLocked);
+    overlay.leftAlpha = calculateAlpha(leftDistance, slot.leftTouchActive, slot.leftPointerLocked);
+    overlay.rightAlpha = calculateAlpha(rightDistance, slot.rightTouchActive, slot.rightPointerLocked);
+    
+    // Direction indicators - resolved here so the renderer only draws
+    overlay.leftDirection = leftDirection;
+    overlay.rightDirection = rightDirection;
+    overlay.leftStickMoved = (leftDistance > DIRECTION_INDICATOR_DISTANCE);
+    overlay.rightStickMoved = (rightDistance > DIRECTION_INDICATOR_DISTANCE);
     
     // Calculate active touch pointer positions using helper function
-    updateTouchPointerPosition(leftTouchActive, leftPointerLocked, currentLHeldDirection, leftLockedDirection,
-                              leftX, leftY, overlayLeftLockedX, overlayLeftLockedY, overlayLeftLockedAlpha);
-    updateTouchPointerPosition(rightTouchActive, rightPointerLocked, currentRHeldDirection, rightLockedDirection,
-                              rightX, rightY, overlayRightLockedX, overlayRightLockedY, overlayRightLockedAlpha);
+    updateTouchPointerPosition(slot.leftTouchActive, slot.leftPointerLocked, slot.currentLHeldDirection, slot.leftLockedDirection,
+                              leftX, leftY, overlay.leftLockedX, overlay.leftLockedY, overlay.leftLockedAlpha);
+    updateTouchPointerPosition(slot.rightTouchActive, slot.rightPointerLocked, slot.currentRHeldDirection, slot.rightLockedDirection,
+                              rightX, rightY, overlay.rightLockedX, overlay.rightLockedY, overlay.rightLockedAlpha);
     
     // Calculate L3/R3 5-touch X pattern positions and alpha
-    overlayL3CenterX = l3TouchActive ? leftX : 0;
-    overlayL3CenterY = l3TouchActive ? leftY : 0;
-    overlayL3Alpha = l3TouchActive ? 255 : 0;
-    
-    overlayR3CenterX = r3TouchActive ? rightX : 0;
-    overlayR3CenterY = r3TouchActive ? rightY : 0;
-    overlayR3Alpha = r3TouchActive ? 255 : 0;
-    
-    // Only redraw if overlay content actually changed to prevent unnecessary blinking
-    bool contentChanged = (
-        overlayLeftX != prevOverlayLeftX || overlayLeftY != prevOverlayLeftY ||
-        overlayRightX != prevOverlayRightX || overlayRightY != prevOverlayRightY ||
-        overlayLeftAngle != prevOverlayLeftAngle || overlayRightAngle != prevOverlayRightAngle ||
-        overlayLeftAlpha != prevOverlayLeftAlpha || overlayRightAlpha != prevOverlayRightAlpha ||
-        overlayLeftLockedAlpha != prevOverlayLeftLockedAlpha ||
-        overlayRightLockedAlpha != prevOverlayRightLockedAlpha ||
-        overlayLeftLockedX != prevOverlayLeftLockedX || overlayLeftLockedY != prevOverlayLeftLockedY ||
-        overlayRightLockedX != prevOverlayRightLockedX || overlayRightLockedY != prevOverlayRightLockedY ||
-        overlayL3CenterX != prevOverlayL3CenterX || overlayL3CenterY != prevOverlayL3CenterY ||
-        overlayR3CenterX != prevOverlayR3CenterX || overlayR3CenterY != prevOverlayR3CenterY ||
-        overlayL3Alpha != prevOverlayL3Alpha || overlayR3Alpha != prevOverlayR3Alpha
-    );
-    
-    if (contentChanged && overlayHwnd) {
-        // Update previous values
-        prevOverlayLeftX = overlayLeftX;
-        prevOverlayLeftY = overlayLeftY;
-        prevOverlayRightX = overlayRightX;
-        prevOverlayRightY = overlayRightY;
-        prevOverlayLeftAngle = overlayLeftAngle;
-        prevOverlayRightAngle = overlayRightAngle;
-        prevOverlayLeftAlpha = overlayLeftAlpha;
-        prevOverlayRightAlpha = overlayRightAlpha;
-        prevOverlayLeftLockedAlpha = overlayLeftLockedAlpha;
-        prevOverlayRightLockedAlpha = overlayRightLockedAlpha;
-        prevOverlayLeftLockedX = overlayLeftLockedX;
-        prevOverlayLeftLockedY = overlayLeftLockedY;
-        prevOverlayRightLockedX = overlayRightLockedX;
-        prevOverlayRightLockedY = overlayRightLockedY;
-        prevOverlayL3CenterX = overlayL3CenterX;
-        prevOverlayL3CenterY = overlayL3CenterY;
-        prevOverlayR3CenterX = overlayR3CenterX;
-        prevOverlayR3CenterY = overlayR3CenterY;
-        prevOverlayL3Alpha = overlayL3Alpha;
-        prevOverlayR3Alpha = overlayR3Alpha;
-        
-        // Only redraw when content actually changed
-        InvalidateRect(overlayHwnd, nullptr, TRUE); // Let Windows handle redraw timing
+    overlay.l3CenterX = slot.l3TouchActive ? leftX : 0;
+    overlay.l3CenterY = slot.l3TouchActive ? leftY : 0;
+    overlay.l3Alpha = slot.l3TouchActive ? 255 : 0;
+    
+    overlay.r3CenterX = slot.r3TouchActive ? rightX : 0;
+    overlay.r3CenterY = slot.r3TouchActive ? rightY : 0;
+    overlay.r3Alpha = slot.r3TouchActive ? 255 : 0;
+    
+    overlay.leftTouchActive = slot.leftTouchActive;
+    overlay.rightTouchActive = slot.rightTouchActive;
+    overlay.l3TouchActive = slot.l3TouchActive;
+    overlay.r3TouchActive = slot.r3TouchActive;
+    for (int i = 0; i < TOUCHES_PER_CONTROLLER; i++) {
+        overlay.touchActive[i] = touchActive[slot.touchIdBase + i];
+        overlay.touchX[i] = touchX[slot.touchIdBase + i];
+        overlay.touchY[i] = touchY[slot.touchIdBase + i];
+    }
+    pollOverlay.ringCount = controllerCount;
+    pollOverlay.sampleTicks = currentSampleTicks;
+    
+    // Only publish when the frame would look different - the overlay thread
+    // repaints when it sees a new version
+    if (!pollOverlay.sameContent(publishedOverlay) && overlayHwnd) {
+        overlayState.write(pollOverlay);
+        publishedOverlay = pollOverlay;
     }
 }
 
@@ -679,14 +984,43 @@ LRESULT CALLBACK ControllerMapper::OverlayWindowProc(HWND hwnd, UINT uMsg, WPARA
     if (pThis) {
         switch (uMsg) {
             case WM_PAINT: {
+                if (pThis->overlayBackend != OverlayBackend::ColorKeyGdi) {
+                    break; // Content is pushed by the render loop - DefWindowProc validates
+                }
+                // The update region must be read before BeginPaint validates it
+                LONGLONG paintStart = qpcNow();
+                HRGN updateRegion = nullptr;
+                if (pThis->paintRegion && GetUpdateRgn(hwnd, pThis->paintRegion, FALSE) != ERROR) {
+                    updateRegion = pThis->paintRegion;
+                }
                 PAINTSTRUCT ps;
                 HDC hdc = BeginPaint(hwnd, &ps);
-                pThis->drawOverlay(hdc);
+                pThis->drawOverlay(hdc, ps.rcPaint, updateRegion);
                 EndPaint(hwnd, &ps);
+                pThis->recordPaintLatency(paintStart);
                 return 0;
             }
             case WM_ERASEBKGND:
                 return 1; // We handle background ourselves
+            case WM_WINDOWPOSCHANGED: {
+                // Overlay moved or resized - touch mapping depends on its position
+                const WINDOWPOS* windowPos = (const WINDOWPOS*)lParam;
+                if ((windowPos->flags & (SWP_NOMOVE | SWP_NOSIZE)) != (SWP_NOMOVE | SWP_NOSIZE)) {
+                    pThis->rebuildMonitorTopology();
+                }
+                if (!(windowPos->flags & SWP_NOSIZE) && pThis->overlayBackend != OverlayBackend::ColorKeyGdi) {
+                    pThis->redrawOverlay(); // No WM_PAINT will come - push content at the new size
+                }
+                break;
+            }
+            case WM_DISPLAYCHANGE:
+            case WM_DPICHANGED:
+                // Monitors were added, removed, moved or rescaled - rebuild and re-detect
+                // (the monitor handle may be stale even if the cursor didn't move)
+                pThis->rebuildMonitorTopology();
+                pThis->monitorHandle = nullptr;
+                pThis->detectMonitorFromCursor(false);
+                break;
         }
     }
 
@@ -695,30 +1029,73 @@ LRESULT CALLBACK ControllerMapper::OverlayWindowProc(HWND hwnd, UINT uMsg, WPARA
 
 // ========== Overlay Rendering ==========
 
-void ControllerMapper::drawOverlay(HDC hdc) {
+void ControllerMapper::drawOverlay(HDC windowDC, const RECT& paintRect, HRGN paintRgn) {
+    // ColorKeyGdi WM_PAINT path (LayeredAlpha renders in renderLayeredOverlay)
+    paintingSampleTicks = paintSnapshot.sampleTicks;
+    
     RECT rect;
     GetClientRect(overlayHwnd, &rect);
     
-    // Clear the window - make it completely transparent
-    // Fill with black which is our transparency key
-    HBRUSH clearBrush = CreateSolidBrush(RGB(0, 0, 0));
-    FillRect(hdc, &rect, clearBrush);
-    DeleteObject(clearBrush);
+    // Draw into the back buffer, clipped to the update region - everything outside it
+    // is already correct on screen
+    bool buffered = backBuffer.ensure(rect.right, rect.bottom);
+    HDC hdc = buffered ? backBuffer.dc : windowDC;
+    if (buffered) {
+        SelectClipRgn(hdc, paintRgn);
+    }
+    
+    drawOverlayScene(hdc, rect, paintRect);
+    
+    if (buffered) {
+        // The window DC is already clipped to the update region
+        BitBlt(windowDC, paintRect.left, paintRect.top,
+               paintRect.right - paintRect.left, paintRect.bottom - paintRect.top,
+               hdc, paintRect.left, paintRect.top, SRCCOPY);
+        SelectClipRgn(hdc, nullptr);
+    }
+}
+
+void ControllerMapper::drawOverlayScene(HDC hdc, const RECT& rect, const RECT& clearRect) {
+    // Draw the snapshot the pending invalidation was computed from, so what gets
+    // painted always lies inside the invalidated rectangles
+    const OverlaySnapshot& snapshot = paintSnapshot;
     
-    // Calculate center position - both sticks in the same location
-    int centerX = rect.right / 2;
-    int centerY = rect.bottom / 2;
+    // Clear the dirty area - make it completely transparent
+    // Fill with black which is our transparency key (and zero alpha in the mask pass)
+    FillRect(hdc, &clearRect, gdiCache.getBrush(RGB(0, 0, 0)));
     
+    // One ring per controller, side by side
+    for (int ring = 0; ring < snapshot.ringCount; ring++) {
+        int centerX, centerY;
+        getRingCenter(ring, snapshot.ringCount, rect, centerX, centerY);
+        drawOverlayRing(hdc, snapshot.rings[ring], centerX, centerY);
+    }
+    
+    // Draw debug text on the middle left (if enabled)
+    if (showDebugInfo && !paintDebugText.empty()) {
+        drawDebugText(hdc, rect);
+    }
+    if (showPerfHud) {
+        drawPerfHud(hdc, rect);
+    }
+}
+
+// Ring centres split the overlay into equal columns - a single controller stays centred
+void ControllerMapper::getRingCenter(int ring, int ringCount, const RECT& client, int& centerX, int& centerY) const {
+    centerX = (int)((LONGLONG)client.right * (2 * ring + 1) / (2 * ringCount));
+    centerY = client.bottom / 2;
+}
+
+void ControllerMapper::drawOverlayRing(HDC hdc, const RingSnapshot& snapshot, int centerX, int centerY) {
     // Draw boundary circle with fade based on max alpha
-    int maxAlpha = (overlayLeftAlpha > overlayRightAlpha) ? overlayLeftAlpha : overlayRightAlpha;
+    int maxAlpha = (snapshot.leftAlpha > snapshot.rightAlpha) ? snapshot.leftAlpha : snapshot.rightAlpha;
     
     if (maxAlpha > 10) {
         // Modulate pen width based on alpha for fade effect
         int boundaryWidth = 1 + (maxAlpha * 3 / 255); // 1-4 pixels
         
         // Draw outer circle (boundary) - only once for both sticks, full gray color
-        HPEN boundaryPen = CreatePen(PS_SOLID, boundaryWidth, RGB(200, 200, 200));
-        HPEN oldPen = (HPEN)SelectObject(hdc, boundaryPen);
+        HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(200, 200, 200), maxAlpha), boundaryWidth));
         HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
         
         Ellipse(hdc, 
@@ -729,69 +1106,59 @@ void ControllerMapper::drawOverlay(HDC hdc) {
         
         SelectObject(hdc, oldPen);
         SelectObject(hdc, oldBrush);
-        DeleteObject(boundaryPen);
     }
     
     // Draw direction indicators first (so they appear behind the stick indicators)
-    // Calculate current directions from angles
-    int leftDirection = getDirection(overlayLeftAngle);
-    int rightDirection = getDirection(overlayRightAngle);
+    // Directions and the deadzone test come precomputed in the snapshot
+    int leftDirection = snapshot.leftDirection;
+    int rightDirection = snapshot.rightDirection;
+    bool leftStickMoved = snapshot.leftStickMoved;
+    bool rightStickMoved = snapshot.rightStickMoved;
     
     // Draw direction indicators with overlap handling (only when sticks are actually moved with deadzone)
-    // Use the same distance calculation as the overlay alpha system for consistency
-    double leftDistance = std::sqrt(overlayLeftX * overlayLeftX + overlayLeftY * overlayLeftY);
-    double rightDistance = std::sqrt(overlayRightX * overlayRightX + overlayRightY * overlayRightY);
-    bool leftStickMoved = (leftDistance > 0.1); // Use distance-based deadzone like overlay
-    bool rightStickMoved = (rightDistance > 0.1);
-    
     if (leftStickMoved && rightStickMoved && leftDirection == rightDirection && leftDirection >= 0) {
         // Both sticks point to same direction - draw yellow blended arc
-        int maxAlpha = (overlayLeftAlpha > overlayRightAlpha) ? overlayLeftAlpha : overlayRightAlpha;
+        int maxAlpha = (snapshot.leftAlpha > snapshot.rightAlpha) ? snapshot.leftAlpha : snapshot.rightAlpha;
         // Use active thickness if either L1/R1 is pressed, otherwise use stick thickness
-        int thickness = (leftTouchActive || rightTouchActive) ? -1 : (1 + (maxAlpha * 5 / 255));
+        int thickness = (snapshot.leftTouchActive || snapshot.rightTouchActive) ? -1 : (1 + (maxAlpha * 5 / 255));
         drawDirectionIndicator(hdc, centerX, centerY, leftDirection, RGB(255, 255, 0), maxAlpha, thickness);
     } else {
         // Different directions or only one moved - draw each separately
         if (leftStickMoved && leftDirection >= 0) {
             // Use active thickness if L1/R1 is pressed, otherwise use stick thickness
-            int thickness = leftTouchActive ? -1 : (1 + (overlayLeftAlpha * 5 / 255));
-            drawDirectionIndicator(hdc, centerX, centerY, leftDirection, RGB(100, 150, 255), overlayLeftAlpha, thickness);
+            int thickness = snapshot.leftTouchActive ? -1 : (1 + (snapshot.leftAlpha * 5 / 255));
+            drawDirectionIndicator(hdc, centerX, centerY, leftDirection, RGB(100, 150, 255), snapshot.leftAlpha, thickness);
         }
         if (rightStickMoved && rightDirection >= 0) {
             // Use active thickness if L1/R1 is pressed, otherwise use stick thickness
-            int thickness = rightTouchActive ? -1 : (1 + (overlayRightAlpha * 5 / 255));
-            drawDirectionIndicator(hdc, centerX, centerY, rightDirection, RGB(255, 100, 150), overlayRightAlpha, thickness);
+            int thickness = snapshot.rightTouchActive ? -1 : (1 + (snapshot.rightAlpha * 5 / 255));
+            drawDirectionIndicator(hdc, centerX, centerY, rightDirection, RGB(255, 100, 150), snapshot.rightAlpha, thickness);
         }
     }
     
     // Draw both sticks at the same position (they will overlap)
     // Draw left stick (blue)
-    drawStick(hdc, centerX, centerY, overlayLeftX, overlayLeftY, RGB(100, 150, 255), overlayLeftAlpha);
+    drawStick(hdc, centerX, centerY, snapshot.leftX, snapshot.leftY, RGB(100, 150, 255), snapshot.leftAlpha);
     
     // Draw right stick (pink)
-    drawStick(hdc, centerX, centerY, overlayRightX, overlayRightY, RGB(255, 100, 150), overlayRightAlpha);
+    drawStick(hdc, centerX, centerY, snapshot.rightX, snapshot.rightY, RGB(255, 100, 150), snapshot.rightAlpha);
     
     // Draw locked pointers (solid circles, bigger, only when trigger press (L2/R2) is active)
     // Left locked pointer (darker blue) - draw below raw pointer
-    drawLockedPointer(hdc, centerX, centerY, overlayLeftLockedX, overlayLeftLockedY, RGB(50, 100, 200), overlayLeftLockedAlpha);
+    drawLockedPointer(hdc, centerX, centerY, snapshot.leftLockedX, snapshot.leftLockedY, RGB(50, 100, 200), snapshot.leftLockedAlpha);
     
     // Right locked pointer (darker pink) - draw below raw pointer
-    drawLockedPointer(hdc, centerX, centerY, overlayRightLockedX, overlayRightLockedY, RGB(200, 50, 100), overlayRightLockedAlpha);
+    drawLockedPointer(hdc, centerX, centerY, snapshot.rightLockedX, snapshot.rightLockedY, RGB(200, 50, 100), snapshot.rightLockedAlpha);
     
     // Draw L3/R3 5-touch X pattern (only when L3/R3 is active)
     // L3 pattern (darker blue-green) - draw below locked pointer
-    drawPalmTouchPattern(hdc, centerX, centerY, overlayL3CenterX, overlayL3CenterY, RGB(50, 200, 150), overlayL3Alpha);
+    drawPalmTouchPattern(hdc, snapshot, centerX, centerY, snapshot.l3CenterX, snapshot.l3CenterY, RGB(50, 200, 150), snapshot.l3Alpha);
     
     // R3 pattern (darker pink-purple) - draw below locked pointer
-    drawPalmTouchPattern(hdc, centerX, centerY, overlayR3CenterX, overlayR3CenterY, RGB(200, 50, 150), overlayR3Alpha);
+    drawPalmTouchPattern(hdc, snapshot, centerX, centerY, snapshot.r3CenterX, snapshot.r3CenterY, RGB(200, 50, 150), snapshot.r3Alpha);
     
     // Draw all 10 touches (0-9) for debug overlay
-    drawAllTouches(hdc, centerX, centerY);
-    
-    // Draw debug text on the middle left (if enabled)
-    if (showDebugInfo && !debugText.empty()) {
-        drawDebugText(hdc, rect);
-    }
+    drawAllTouches(hdc, snapshot, centerX, centerY);
 }
 
 void ControllerMapper::drawDirectionIndicator(HDC hdc, int centerX, int centerY, int direction, COLORREF color, int alpha, int thickness) {
@@ -812,27 +1179,13 @@ void ControllerMapper::drawDirectionIndicator(HDC hdc, int centerX, int centerY,
             continue; // Skip non-adjacent directions
         }
         
-        // Calculate angle for this direction
-        // Direction 0 should be Up-Right (22.5°), not directly up (0°)
-        double dirAngle = (dir * DEGREES_PER_SECTOR) + 22.5;
-        if (dirAngle >= 360.0) {
-            dirAngle -= 360.0;
-        }
-        
-        // Draw an arc for this direction (45 degrees span)
-        double arcSpan = DEGREES_PER_SECTOR; // 45 degrees per direction
-        double arcStartAngle = dirAngle - arcSpan / 2.0;
-        double arcEndAngle = dirAngle + arcSpan / 2.0;
-        
-        // Convert to radians (standard math: 0° = right, counter-clockwise)
-        double startRad = (90 - arcStartAngle) * PI / 180.0;
-        double endRad = (90 - arcEndAngle) * PI / 180.0;
-        
-        // Calculate arc endpoints on the boundary circle
-        int startX = centerX + (int)(cos(startRad) * overlayStickRadius);
-        int startY = centerY - (int)(sin(startRad) * overlayStickRadius);
-        int endX = centerX + (int)(cos(endRad) * overlayStickRadius);
-        int endY = centerY - (int)(sin(endRad) * overlayStickRadius);
+        // Arc endpoints on the boundary circle - this direction's 45 degree span
+        // (direction 0 is Up-Right, 0° to 45°, not centred on up)
+        int nextDir = (dir + 1) % DIRECTION_SECTORS;
+        int startX = centerX + (int)(DIRECTION_BOUNDARY_X[dir] * overlayStickRadius);
+        int startY = centerY - (int)(DIRECTION_BOUNDARY_Y[dir] * overlayStickRadius);
+        int endX = centerX + (int)(DIRECTION_BOUNDARY_X[nextDir] * overlayStickRadius);
+        int endY = centerY - (int)(DIRECTION_BOUNDARY_Y[nextDir] * overlayStickRadius);
         
         // Modulate pen width based on alpha for fade effect
         int penWidth;
@@ -851,8 +1204,7 @@ void ControllerMapper::drawDirectionIndicator(HDC hdc, int centerX, int centerY,
         }
         
         // Draw the arc along the main circle boundary
-        HPEN arcPen = CreatePen(PS_SOLID, penWidth, color);
-        HPEN oldPen = (HPEN)SelectObject(hdc, arcPen);
+        HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(color, currentAlpha), penWidth));
         HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
         
         // Use Arc function to draw along the boundary circle
@@ -863,7 +1215,6 @@ void ControllerMapper::drawDirectionIndicator(HDC hdc, int centerX, int centerY,
         
         SelectObject(hdc, oldPen);
         SelectObject(hdc, oldBrush);
-        DeleteObject(arcPen);
     }
 }
 
@@ -882,9 +1233,8 @@ void ControllerMapper::drawStick(HDC hdc, int centerX, int centerY, double stick
     int indicatorX = centerX + (int)(stickX * (overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS));
     int indicatorY = centerY - (int)(stickY * (overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS)); // Inverted Y
     
-    // Create colored pen for the edge with modulated width - use full bright color
-    HPEN indicatorPen = CreatePen(PS_SOLID, penWidth, color);
-    HPEN oldPen = (HPEN)SelectObject(hdc, indicatorPen);
+    // Colored pen for the edge with modulated width - use full bright color
+    HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(color, alpha), penWidth));
     HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
     
     Ellipse(hdc,
@@ -895,7 +1245,6 @@ void ControllerMapper::drawStick(HDC hdc, int centerX, int centerY, double stick
     
     SelectObject(hdc, oldPen);
     SelectObject(hdc, oldBrush);
-    DeleteObject(indicatorPen);
 }
 
 void ControllerMapper::drawTouchPointIndicatorAtOverlayPos(HDC hdc, int overlayX, int overlayY, COLORREF color) {
@@ -904,8 +1253,7 @@ void ControllerMapper::drawTouchPointIndicatorAtOverlayPos(HDC hdc, int overlayX
     const int TOUCH_INDICATOR_RADIUS = 40; // Larger radius for visibility
     
     // Outer circle (border) - white for maximum visibility
-    HPEN borderPen = CreatePen(PS_SOLID, 5, RGB(255, 255, 255)); // Thick white border
-    HPEN oldPen = (HPEN)SelectObject(hdc, borderPen);
+    HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(255, 255, 255), 255), 5)); // Thick white border
     HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
     
     Ellipse(hdc,
@@ -915,8 +1263,7 @@ void ControllerMapper::drawTouchPointIndicatorAtOverlayPos(HDC hdc, int overlayX
             overlayY + TOUCH_INDICATOR_RADIUS);
     
     // Inner circle (filled) - bright color
-    HBRUSH fillBrush = CreateSolidBrush(color);
-    SelectObject(hdc, fillBrush);
+    SelectObject(hdc, gdiCache.getBrush(overlayColor(color, 255)));
     SelectObject(hdc, GetStockObject(NULL_PEN));
     
     Ellipse(hdc,
@@ -927,8 +1274,6 @@ void ControllerMapper::drawTouchPointIndicatorAtOverlayPos(HDC hdc, int overlayX
     
     SelectObject(hdc, oldPen);
     SelectObject(hdc, oldBrush);
-    DeleteObject(borderPen);
-    DeleteObject(fillBrush);
 }
 
 void ControllerMapper::drawTouchPointIndicator(HDC hdc, LONG screenX, LONG screenY, COLORREF color) {
@@ -961,8 +1306,7 @@ void ControllerMapper::drawTouchPointIndicator(HDC hdc, LONG screenX, LONG scree
     // Use bright, contrasting colors
     
     // Outer circle (border) - white for maximum visibility
-    HPEN borderPen = CreatePen(PS_SOLID, 4, RGB(255, 255, 255)); // White border
-    HPEN oldPen = (HPEN)SelectObject(hdc, borderPen);
+    HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(255, 255, 255), 255), 4)); // White border
     HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
     
     Ellipse(hdc,
@@ -972,8 +1316,7 @@ void ControllerMapper::drawTouchPointIndicator(HDC hdc, LONG screenX, LONG scree
             indicatorY + TOUCH_INDICATOR_RADIUS);
     
     // Inner circle (filled) - bright color
-    HBRUSH fillBrush = CreateSolidBrush(color);
-    SelectObject(hdc, fillBrush);
+    SelectObject(hdc, gdiCache.getBrush(overlayColor(color, 255)));
     SelectObject(hdc, GetStockObject(NULL_PEN));
     
     Ellipse(hdc,
@@ -983,8 +1326,7 @@ void ControllerMapper::drawTouchPointIndicator(HDC hdc, LONG screenX, LONG scree
             indicatorY + TOUCH_INDICATOR_RADIUS - 4);
     
     // Center dot for precise location
-    HBRUSH centerBrush = CreateSolidBrush(RGB(255, 255, 255)); // White center
-    SelectObject(hdc, centerBrush);
+    SelectObject(hdc, gdiCache.getBrush(overlayColor(RGB(255, 255, 255), 255))); // White center
     Ellipse(hdc,
             indicatorX - 5,
             indicatorY - 5,
@@ -993,9 +1335,6 @@ void ControllerMapper::drawTouchPointIndicator(HDC hdc, LONG screenX, LONG scree
     
     SelectObject(hdc, oldPen);
     SelectObject(hdc, oldBrush);
-    DeleteObject(borderPen);
-    DeleteObject(fillBrush);
-    DeleteObject(centerBrush);
 }
 
 void ControllerMapper::drawLockedPointer(HDC hdc, int centerX, int centerY, double stickX, double stickY, COLORREF color, int alpha) {
@@ -1005,9 +1344,8 @@ void ControllerMapper::drawLockedPointer(HDC hdc, int centerX, int centerY, doub
     int indicatorX = centerX + (int)(stickX * (overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS));
     int indicatorY = centerY - (int)(stickY * (overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS)); // Inverted Y
     
-    // Create solid brush for filled circle
-    HBRUSH solidBrush = CreateSolidBrush(color);
-    HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, solidBrush);
+    // Solid brush for filled circle
+    HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, gdiCache.getBrush(overlayColor(color, alpha)));
     HPEN oldPen = (HPEN)SelectObject(hdc, GetStockObject(NULL_PEN));
     
     Ellipse(hdc,
@@ -1018,36 +1356,35 @@ void ControllerMapper::drawLockedPointer(HDC hdc, int centerX, int centerY, doub
     
     SelectObject(hdc, oldBrush);
     SelectObject(hdc, oldPen);
-    DeleteObject(solidBrush);
 }
 
-void ControllerMapper::drawPalmTouchPattern(HDC hdc, int centerX, int centerY, double centerStickX, double centerStickY, COLORREF color, int alpha) {
+void ControllerMapper::drawPalmTouchPattern(HDC hdc, const RingSnapshot& snapshot, int centerX, int centerY, double centerStickX, double centerStickY, COLORREF color, int alpha) {
     if (alpha == 0) return; // Don't draw if invisible
     
     // Use the actual stored touch positions from touchX/touchY arrays
     // This matches exactly what's being sent to Windows
-    int centerTouchId = (centerStickX == overlayL3CenterX && centerStickY == overlayL3CenterY) ? 0 : 1;
+    int centerTouchId = (centerStickX == snapshot.l3CenterX && centerStickY == snapshot.l3CenterY) ? 0 : 1;
     int cornerStartId = (centerTouchId == 0) ? 2 : 10;
     
     // Draw center circle using actual stored touch position
-    if (centerTouchId >= 0 && centerTouchId < 20 && touchActive[centerTouchId]) {
+    if (centerTouchId >= 0 && centerTouchId < TOUCHES_PER_CONTROLLER && snapshot.touchActive[centerTouchId]) {
         int centerOverlayX, centerOverlayY;
-        convertStickToOverlayCoords(touchX[centerTouchId], touchY[centerTouchId], centerX, centerY, centerOverlayX, centerOverlayY);
-        drawTouchCircleWithId(hdc, centerOverlayX, centerOverlayY, centerTouchId, color);
+        convertStickToOverlayCoords(snapshot.touchX[centerTouchId], snapshot.touchY[centerTouchId], centerX, centerY, centerOverlayX, centerOverlayY);
+        drawTouchCircleWithId(hdc, centerOverlayX, centerOverlayY, snapshot.touchIdBase + centerTouchId, color);
     }
     
     // Draw 8 circles around the center using actual stored touch positions
     for (int i = 0; i < 8; i++) {
         int touchId = cornerStartId + i;
-        if (touchId >= 0 && touchId < 20 && touchActive[touchId]) {
+        if (touchId >= 0 && touchId < TOUCHES_PER_CONTROLLER && snapshot.touchActive[touchId]) {
             int cornerOverlayX, cornerOverlayY;
-            convertStickToOverlayCoords(touchX[touchId], touchY[touchId], centerX, centerY, cornerOverlayX, cornerOverlayY);
-            drawTouchCircleWithId(hdc, cornerOverlayX, cornerOverlayY, touchId, color);
+            convertStickToOverlayCoords(snapshot.touchX[touchId], snapshot.touchY[touchId], centerX, centerY, cornerOverlayX, cornerOverlayY);
+            drawTouchCircleWithId(hdc, cornerOverlayX, cornerOverlayY, snapshot.touchIdBase + touchId, color);
         }
     }
 }
 
-void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
+void ControllerMapper::drawAllTouches(HDC hdc, const RingSnapshot& snapshot, int centerX, int centerY) {
     const int TOUCH_RADIUS = 8; // Small circles for each touch
     COLORREF colors[2] = {
         RGB(100, 150, 255),  // Touch 0: Blue
@@ -1056,10 +1393,10 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
     
     // Draw touches 0-1 individually
     for (int i = 0; i < 2; i++) {
-        if (touchActive[i]) {
+        if (snapshot.touchActive[i]) {
             int screenX, screenY;
-            convertStickToOverlayCoords(touchX[i], touchY[i], centerX, centerY, screenX, screenY);
-            drawTouchCircleWithId(hdc, screenX, screenY, i, colors[i], TOUCH_RADIUS);
+            convertStickToOverlayCoords(snapshot.touchX[i], snapshot.touchY[i], centerX, centerY, screenX, screenY);
+            drawTouchCircleWithId(hdc, screenX, screenY, snapshot.touchIdBase + i, colors[i], TOUCH_RADIUS);
         }
     }
     
@@ -1069,19 +1406,19 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
     int l3PalmCount = 0;
     
     // Count center touch 0 (only if L3 is active, not L1/L2)
-    if (l3TouchActive && touchActive[0]) {
+    if (snapshot.l3TouchActive && snapshot.touchActive[0]) {
         l3PalmActive = true;
-        l3PalmCenterX += touchX[0];
-        l3PalmCenterY += touchY[0];
+        l3PalmCenterX += snapshot.touchX[0];
+        l3PalmCenterY += snapshot.touchY[0];
         l3PalmCount++;
     }
     
     // Count around touches 2-9
     for (int i = 2; i < 10; i++) {
-        if (touchActive[i]) {
+        if (snapshot.touchActive[i]) {
             l3PalmActive = true;
-            l3PalmCenterX += touchX[i];
-            l3PalmCenterY += touchY[i];
+            l3PalmCenterX += snapshot.touchX[i];
+            l3PalmCenterY += snapshot.touchY[i];
             l3PalmCount++;
         }
     }
@@ -1096,10 +1433,8 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
         int overlayY = centerY - (int)(l3PalmCenterY * (overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS)); // Inverted Y
         
         const int PALM_RADIUS = 10;
-        HBRUSH brush = CreateSolidBrush(RGB(50, 200, 150)); // Blue-green for L3 palm
-        HPEN pen = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
-        HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, brush);
-        HPEN oldPen = (HPEN)SelectObject(hdc, pen);
+        HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, gdiCache.getBrush(overlayColor(RGB(50, 200, 150), 255))); // Blue-green for L3 palm
+        HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(255, 255, 255), 255), 2));
         
         Ellipse(hdc,
                 overlayX - PALM_RADIUS, overlayY - PALM_RADIUS,
@@ -1107,8 +1442,6 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
         
         SelectObject(hdc, oldBrush);
         SelectObject(hdc, oldPen);
-        DeleteObject(brush);
-        DeleteObject(pen);
     }
     
     // Check for R3 palm touches (1 + 10-17) - center touch 1 + 8 around touches
@@ -1117,19 +1450,19 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
     int r3PalmCount = 0;
     
     // Count center touch 1 (only if R3 is active, not R1/R2)
-    if (r3TouchActive && touchActive[1]) {
+    if (snapshot.r3TouchActive && snapshot.touchActive[1]) {
         r3PalmActive = true;
-        r3PalmCenterX += touchX[1];
-        r3PalmCenterY += touchY[1];
+        r3PalmCenterX += snapshot.touchX[1];
+        r3PalmCenterY += snapshot.touchY[1];
         r3PalmCount++;
     }
     
     // Count around touches 10-17
     for (int i = 10; i < 18; i++) {
-        if (touchActive[i]) {
+        if (snapshot.touchActive[i]) {
             r3PalmActive = true;
-            r3PalmCenterX += touchX[i];
-            r3PalmCenterY += touchY[i];
+            r3PalmCenterX += snapshot.touchX[i];
+            r3PalmCenterY += snapshot.touchY[i];
             r3PalmCount++;
         }
     }
@@ -1144,10 +1477,8 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
         int overlayY = centerY - (int)(r3PalmCenterY * (overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS)); // Inverted Y
         
         const int PALM_RADIUS = 10;
-        HBRUSH brush = CreateSolidBrush(RGB(200, 50, 150)); // Pink-purple for R3 palm
-        HPEN pen = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
-        HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, brush);
-        HPEN oldPen = (HPEN)SelectObject(hdc, pen);
+        HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, gdiCache.getBrush(overlayColor(RGB(200, 50, 150), 255))); // Pink-purple for R3 palm
+        HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(255, 255, 255), 255), 2));
         
         Ellipse(hdc,
                 overlayX - PALM_RADIUS, overlayY - PALM_RADIUS,
@@ -1155,8 +1486,6 @@ void ControllerMapper::drawAllTouches(HDC hdc, int centerX, int centerY) {
         
         SelectObject(hdc, oldBrush);
         SelectObject(hdc, oldPen);
-        DeleteObject(brush);
-        DeleteObject(pen);
     }
 }
 
@@ -1168,10 +1497,8 @@ void ControllerMapper::convertStickToOverlayCoords(double stickX, double stickY,
 
 // Helper function to draw a touch circle with ID number
 void ControllerMapper::drawTouchCircleWithId(HDC hdc, int overlayX, int overlayY, int touchId, COLORREF color, int radius) {
-    HBRUSH brush = CreateSolidBrush(color);
-    HPEN pen = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
-    HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, brush);
-    HPEN oldPen = (HPEN)SelectObject(hdc, pen);
+    HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, gdiCache.getBrush(overlayColor(color, 255)));
+    HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(255, 255, 255), 255), 2));
     
     Ellipse(hdc,
             overlayX - radius, overlayY - radius,
@@ -1180,7 +1507,7 @@ void ControllerMapper::drawTouchCircleWithId(HDC hdc, int overlayX, int overlayY
     // Draw touch ID number only when debug overlay is shown
     if (showDebugInfo) {
         SetBkMode(hdc, TRANSPARENT);
-        SetTextColor(hdc, RGB(255, 255, 255));
+        SetTextColor(hdc, overlayColor(RGB(255, 255, 255), 255));
         char idStr[4];
         sprintf_s(idStr, "%d", touchId);
         TextOutA(hdc, overlayX - 5, overlayY - 8, idStr, (int)strlen(idStr));
@@ -1188,57 +1515,84 @@ void ControllerMapper::drawTouchCircleWithId(HDC hdc, int overlayX, int overlayY
     
     SelectObject(hdc, oldBrush);
     SelectObject(hdc, oldPen);
-    DeleteObject(brush);
-    DeleteObject(pen);
 }
 
-void ControllerMapper::drawDebugText(HDC hdc, RECT rect) {
-    // Position at bottom-left, 120px from bottom
-    int textX = 30;
-    int lineHeight = 24;
+void ControllerMapper::recordPaintLatency(LONGLONG paintStartTicks) {
+    overlayPaintTime.record(paintStartTicks, qpcNow());
     
-    // Calculate text height to position from bottom
-    int lineCount = 0;
-    std::string tempText = debugText;
-    size_t pos = 0;
-    while ((pos = tempText.find("\r\n")) != std::string::npos) {
-        lineCount++;
-        tempText.erase(0, pos + 2);
+    // Count each sample once - repaints of an unchanged snapshot (e.g. cursor moves) aren't latency
+    if (paintingSampleTicks != 0 && paintingSampleTicks != lastPaintedSampleTicks) {
+        sampleToPaintLatency.record(paintingSampleTicks, qpcNow());
+        lastPaintedSampleTicks = paintingSampleTicks;
     }
-    if (!tempText.empty()) lineCount++;
+}
+
+void ControllerMapper::appendLatencyStats(DebugTextBuffer& out) {
+    struct Row {
+        const char* label;
+        const LatencyRecorder* recorder;
+    };
+    const Row rows[] = {
+        { "Read->handler", &sampleToHandlerLatency },
+        { "Read->inject ", &sampleToInjectLatency },
+        { "Read->paint  ", &sampleToPaintLatency },
+    };
     
-    int textHeight = lineCount * lineHeight;
-    int textY = rect.bottom - textHeight - 120; // 120px from bottom
+    out.append("\r\nLATENCY (us)       p50      p99      max\r\n");
+    for (const Row& row : rows) {
+        LatencyStats stats = row.recorder->getStats();
+        if (stats.count > 0) {
+            out.appendf("  %s %8.0f %8.0f %8.0f\r\n", row.label, stats.p50Us, stats.p99Us, stats.maxUs);
+        } else {
+            out.appendf("  %s      ---\r\n", row.label);
+        }
+    }
+}
+
+const DebugTextBuffer& ControllerMapper::formatPaintDebugText() {
+    // Latency stats are read here on the overlay thread so they're as fresh as the paint
+    paintTextBuffer.clear();
+    paintTextBuffer.append(paintDebugText.c_str());
+    appendLatencyStats(paintTextBuffer);
+    return paintTextBuffer;
+}
+
+void ControllerMapper::drawTextLines(HDC hdc, int x, int y, const char* text, int length) {
+    // One TextOut per "\r\n"-separated line, straight out of the buffer
+    const char* end = text + length;
+    const char* lineStart = text;
+    for (;;) {
+        const char* lineEnd = lineStart;
+        while (lineEnd < end && !(lineEnd[0] == '\r' && lineEnd + 1 < end && lineEnd[1] == '\n')) {
+            lineEnd++;
+        }
+        if (lineEnd > lineStart) {
+            TextOutA(hdc, x, y, lineStart, (int)(lineEnd - lineStart));
+        }
+        if (lineEnd == end) break;
+        y += DEBUG_TEXT_LINE_HEIGHT;
+        lineStart = lineEnd + 2;
+    }
+}
+
+void ControllerMapper::drawDebugText(HDC hdc, RECT rect) {
+    const DebugTextBuffer& debugText = formatPaintDebugText();
     
-    if (textY < 30) textY = 30; // Don't go too high
+    // Position at bottom-left, 120px from bottom
+    RECT textRect = getDebugTextRect(rect, debugText.text, debugText.length, 0, 0);
     
-    // Create large, bold font for easy reading
-    HFONT hFont = CreateFont(20, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
-                            OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-                            DEFAULT_PITCH | FF_DONTCARE, "Consolas");
-    HFONT oldFont = (HFONT)SelectObject(hdc, hFont);
+    // Large, bold font for easy reading (grayscale antialiasing when the pixels carry
+    // real alpha - ClearType's colored fringes would end up in the mask)
+    DWORD quality = (overlayBackend == OverlayBackend::LayeredAlpha) ? ANTIALIASED_QUALITY : CLEARTYPE_QUALITY;
+    HFONT oldFont = (HFONT)SelectObject(hdc, gdiCache.getFont(20, FW_BOLD, quality));
     
     // Set up text rendering - no background, just clean text
     SetBkMode(hdc, TRANSPARENT);
-    SetTextColor(hdc, RGB(255, 255, 255)); // White text
+    SetTextColor(hdc, overlayColor(RGB(255, 255, 255), 255)); // White text
     
-    // Render text lines
-    std::string text = debugText;
-    size_t textPos = 0;
-    int currentY = textY;
-    
-    while ((textPos = text.find("\r\n")) != std::string::npos) {
-        std::string line = text.substr(0, textPos);
-        TextOutA(hdc, textX, currentY, line.c_str(), line.length());
-        currentY += lineHeight;
-        text.erase(0, textPos + 2);
-    }
-    if (!text.empty()) {
-        TextOutA(hdc, textX, currentY, text.c_str(), text.length());
-    }
+    drawTextLines(hdc, textRect.left, textRect.top, debugText.text, debugText.length);
     
     SelectObject(hdc, oldFont);
-    DeleteObject(hFont);
 }
 
 // ========== Utility Functions ==========
@@ -1280,6 +1634,19 @@ int ControllerMapper::getDirection(double angle) {
     return direction;
 }
 
+int ControllerMapper::getStickDirection(double x, double y) {
+    if (x == 0 && y == 0) return -1; // No input detected
+    
+    // Same sectors as getDirection(calculateAngle(x, y)) without atan2: the signs pick
+    // the quadrant, comparing |x| with |y| picks the half of it either side of 45°.
+    // Exact boundaries (straight down, the lower diagonals) resolve the way the
+    // angle version rounds them
+    if (x >= 0 && y > 0) return (x < y) ? 0 : 1;    // Up to right
+    if (x >= 0) return (-y <= x) ? 2 : 3;           // Right to down (y <= 0)
+    if (y < 0) return (-x <= -y) ? 4 : 5;           // Down to left (x < 0)
+    return (y < -x) ? 6 : 7;                        // Left to up (x < 0, y >= 0)
+}
+
 void ControllerMapper::getAdjacentDirections(int direction, int& leftAdjacent, int& rightAdjacent) {
     if (direction < 0 || direction >= DIRECTION_SECTORS) {
         leftAdjacent = -1;
@@ -1298,17 +1665,12 @@ void ControllerMapper::getDirectionArcCenter(int direction, double& centerX, dou
         return;
     }
     
-    // Calculate the center angle of this direction
-    double centerAngle = (direction * DEGREES_PER_SECTOR) + 22.5;
-    if (centerAngle >= 360.0) centerAngle -= 360.0;
-    
-    // Convert to radians and calculate position at full radius (1.0)
-    double angleRad = centerAngle * PI / 180.0;
-    centerX = std::sin(angleRad);  // X = sin(angle)
-    centerY = std::cos(angleRad);  // Y = cos(angle)
+    // Centre of the direction's arc at full radius (1.0), from the compile-time table
+    centerX = DIRECTION_CENTER_X[direction];
+    centerY = DIRECTION_CENTER_Y[direction];
 }
 
-bool ControllerMapper::checkPointerLock(int heldDirection, int currentDirection, double currentAngle, int& lockedDirection) {
+bool ControllerMapper::checkPointerLock(int heldDirection, int currentDirection, double currentX, double currentY, int& lockedDirection) {
     if (heldDirection < 0 || currentDirection < 0) return false;
     
     // Calculate the opposite direction (180° away)
@@ -1319,27 +1681,15 @@ bool ControllerMapper::checkPointerLock(int heldDirection, int currentDirection,
     int leftAdjacent = (oppositeDirection - 1 + 8) % 8;
     int rightAdjacent = (oppositeDirection + 1) % 8;
     
-    // Calculate angles for the held direction and the two adjacent directions
-    double heldAngle = (heldDirection * DEGREES_PER_SECTOR) + 22.5;
-    if (heldAngle >= 360.0) heldAngle -= 360.0;
-    
-    double leftAngle = (leftAdjacent * DEGREES_PER_SECTOR) + 22.5;
-    if (leftAngle >= 360.0) leftAngle -= 360.0;
-    
-    double rightAngle = (rightAdjacent * DEGREES_PER_SECTOR) + 22.5;
-    if (rightAngle >= 360.0) rightAngle -= 360.0;
-    
-    // Determine which adjacent direction the current angle is closer to
+    // Determine which adjacent direction the stick is closer to - for unit arc centres
+    // the larger dot product is the smaller angle, so no angle is needed
     // This chooses the path the user is moving toward
-    double angleDiffToLeft = std::abs(currentAngle - leftAngle);
-    if (angleDiffToLeft > 180.0) angleDiffToLeft = 360.0 - angleDiffToLeft;
-    
-    double angleDiffToRight = std::abs(currentAngle - rightAngle);
-    if (angleDiffToRight > 180.0) angleDiffToRight = 360.0 - angleDiffToRight;
+    double dotLeft = currentX * DIRECTION_CENTER_X[leftAdjacent] + currentY * DIRECTION_CENTER_Y[leftAdjacent];
+    double dotRight = currentX * DIRECTION_CENTER_X[rightAdjacent] + currentY * DIRECTION_CENTER_Y[rightAdjacent];
     
     // Choose the closer adjacent direction as the end point
     // The path will be from heldDirection to the chosen adjacent direction
-    if (angleDiffToLeft < angleDiffToRight) {
+    if (dotLeft > dotRight) {
         lockedDirection = leftAdjacent;
     } else {
         lockedDirection = rightAdjacent;
@@ -1351,28 +1701,16 @@ bool ControllerMapper::checkPointerLock(int heldDirection, int currentDirection,
 void ControllerMapper::calculateLockedPosition(int heldDirection, int lockedDirection, 
                               double currentX, double currentY,
                               double& lockedX, double& lockedY) {
-    // Calculate angles for held and locked directions
-    double heldAngle = (heldDirection * DEGREES_PER_SECTOR) + 22.5;
-    if (heldAngle >= 360.0) heldAngle -= 360.0;
-    
-    double endAngle = (lockedDirection * DEGREES_PER_SECTOR) + 22.5;
-    if (endAngle >= 360.0) endAngle -= 360.0;
-    
-    // Calculate path direction vector (from held to locked direction)
-    double pathX = std::sin(endAngle * PI / 180.0) - std::sin(heldAngle * PI / 180.0);
-    double pathY = std::cos(endAngle * PI / 180.0) - std::cos(heldAngle * PI / 180.0);
-    
-    // Normalize the path vector to get unit direction
-    double pathLength = std::sqrt(pathX * pathX + pathY * pathY);
-    if (pathLength > 0) {
-        pathX /= pathLength;
-        pathY /= pathLength;
-    }
+    // Unit path vector and length (from held to locked direction) come precomputed
+    const DirectionPath& path = DIRECTION_PATHS.paths[heldDirection][lockedDirection];
+    double pathX = path.unitX;
+    double pathY = path.unitY;
+    double pathLength = path.length;
     
     // Get center position of held direction (path start point)
     // Use center of direction arc instead of captured position for consistency
-    double heldX, heldY;
-    getDirectionArcCenter(heldDirection, heldX, heldY);
+    double heldX = DIRECTION_CENTER_X[heldDirection];
+    double heldY = DIRECTION_CENTER_Y[heldDirection];
     
     // Project current stick position onto the path using dot product
     // This projects the vector from held center to current position onto the path direction
@@ -1390,264 +1728,6 @@ void ControllerMapper::calculateLockedPosition(int heldDirection, int lockedDire
     lockedY = heldY + t * pathY;
 }
 
-void ControllerMapper::updateDebugInfo(double lAngle, double rAngle, int lDirection, int rDirection, DIJOYSTATE2* diState) {
-    // Build debug info string based on current mode
-    // This is displayed on the overlay (bottom-left, large text)
-    
-    std::string info = "CONTROLLER INPUT MAPPER\r\n";
-    info += std::string(hasXInputController ? "XInput" : "DirectInput") + " | ";
-    
-    // Show current mode
-    switch (currentMode) {
-        case InputMode::Touch:
-            info += "Touch Mode\r\n";
-            break;
-        case InputMode::Mouse:
-            info += "Mouse Mode\r\n";
-            break;
-        case InputMode::Keyboard:
-            info += "Keyboard Mode\r\n";
-            break;
-    }
-    info += "\r\n";
-    
-    // Mode-specific status
-    if (currentMode == InputMode::Touch) {
-        info += "TOUCH STATUS:\r\n";
-        
-        // Add monitor information - use overlay's actual monitor for accuracy
-        HMONITOR overlayMon = MonitorFromWindow(overlayHwnd, MONITOR_DEFAULTTONEAREST);
-        MONITORINFOEX monitorInfoEx = {};
-        monitorInfoEx.cbSize = sizeof(MONITORINFOEX);
-        if (GetMonitorInfo(overlayMon, (MONITORINFO*)&monitorInfoEx)) {
-            info += "Monitor: " + std::string(monitorInfoEx.szDevice) + "\r\n";
-            LONG actualMonLeft = monitorInfoEx.rcMonitor.left;
-            LONG actualMonTop = monitorInfoEx.rcMonitor.top;
-            LONG actualMonWidth = monitorInfoEx.rcMonitor.right - monitorInfoEx.rcMonitor.left;
-            LONG actualMonHeight = monitorInfoEx.rcMonitor.bottom - monitorInfoEx.rcMonitor.top;
-            info += "  Size: " + std::to_string(actualMonWidth) + "x" + std::to_string(actualMonHeight) + "\r\n";
-            info += "  Position: (" + std::to_string(actualMonLeft) + ", " + std::to_string(actualMonTop) + ")\r\n";
-            
-            // Also show if it's primary
-            HMONITOR primaryMon = MonitorFromPoint(POINT{0, 0}, MONITOR_DEFAULTTOPRIMARY);
-            if (overlayMon == primaryMon) {
-                info += "  (Primary Monitor)\r\n";
-            } else {
-                info += "  (Secondary Monitor)\r\n";
-            }
-        } else {
-            info += "Monitor: Unknown\r\n";
-        }
-        
-        // Show cursor position used for detection
-        POINT cursorPos;
-        if (GetCursorPos(&cursorPos)) {
-            info += "Cursor:\r\n";
-            info += "  Position: (" + std::to_string(cursorPos.x) + ", " + std::to_string(cursorPos.y) + ")\r\n";
-            info += "  (Used for monitor detection)\r\n";
-        }
-        info += "\r\n";
-        
-        
-        // Show all touches (0-19) - compact format
-        info += "ALL TOUCHES STATUS:\r\n";
-        
-        // Touch 0 (L1/L2 or L3 center) - always show all lines
-        bool touch0Active = leftTouchActive || (l3TouchActive && touchActive[0]);
-        info += "  Touch 0 (L1/L2/L3): " + std::string(touch0Active ? "ACTIVE" : "---") + "\r\n";
-        LONG touchX0, touchY0;
-        if (touch0Active) {
-            // Use actual touch position if L3 is active, otherwise use L1/L2 position
-            if (l3TouchActive && touchActive[0]) {
-                getTouchCoordinates(touchX[0], touchY[0], touchX0, touchY0);
-            } else {
-                getTouchCoordinates(overlayLeftX, overlayLeftY, touchX0, touchY0);
-            }
-            info += "    Screen: (" + std::to_string(touchX0) + ", " + std::to_string(touchY0) + ")\r\n";
-        } else {
-            info += "    Screen: ---\r\n";
-        }
-        info += "    Held Dir: " + (currentLHeldDirection >= 0 ? std::to_string(currentLHeldDirection) : "---") + "\r\n";
-        info += "    LOCKED: " + (leftPointerLocked ? ("to " + std::to_string(leftLockedDirection)) : "---") + "\r\n";
-        info += "    L3 Active: " + std::string(l3TouchActive ? "YES" : "---") + "\r\n";
-        
-        // Touch 1 (R1/R2 or R3 center) - always show all lines
-        bool touch1Active = rightTouchActive || (r3TouchActive && touchActive[1]);
-        info += "  Touch 1 (R1/R2/R3): " + std::string(touch1Active ? "ACTIVE" : "---") + "\r\n";
-        LONG touchX1, touchY1;
-        if (touch1Active) {
-            // Use actual touch position if R3 is active, otherwise use R1/R2 position
-            if (r3TouchActive && touchActive[1]) {
-                getTouchCoordinates(touchX[1], touchY[1], touchX1, touchY1);
-            } else {
-                getTouchCoordinates(overlayRightX, overlayRightY, touchX1, touchY1);
-            }
-            info += "    Screen: (" + std::to_string(touchX1) + ", " + std::to_string(touchY1) + ")\r\n";
-        } else {
-            info += "    Screen: ---\r\n";
-        }
-        info += "    Held Dir: " + (currentRHeldDirection >= 0 ? std::to_string(currentRHeldDirection) : "---") + "\r\n";
-        info += "    LOCKED: " + (rightPointerLocked ? ("to " + std::to_string(rightLockedDirection)) : "---") + "\r\n";
-        info += "    R3 Active: " + std::string(r3TouchActive ? "YES" : "---") + "\r\n";
-        
-        
-        // L3 palm touches (0 + 2-9) - always show line
-        int activeL3PalmTouches = 0;
-        std::string l3PalmInfo = "  L3 palm (0+2-9): ";
-        // Count center touch 0 if L3 is active
-        if (l3TouchActive && touchActive[0]) {
-            activeL3PalmTouches++;
-            if (activeL3PalmTouches <= 5) {
-                LONG screenX, screenY;
-                getTouchCoordinates(touchX[0], touchY[0], screenX, screenY);
-                l3PalmInfo += "0(" + std::to_string(screenX) + "," + std::to_string(screenY) + ") ";
-            }
-        }
-        for (int i = 2; i < 10; i++) {
-            if (touchActive[i]) {
-                activeL3PalmTouches++;
-                if (activeL3PalmTouches <= 5) {
-                    LONG screenX, screenY;
-                    getTouchCoordinates(touchX[i], touchY[i], screenX, screenY);
-                    l3PalmInfo += std::to_string(i) + "(" + std::to_string(screenX) + "," + std::to_string(screenY) + ") ";
-                }
-            }
-        }
-        if (activeL3PalmTouches > 0) {
-            l3PalmInfo += "[" + std::to_string(activeL3PalmTouches) + " total]";
-        } else {
-            l3PalmInfo += "none";
-        }
-        info += l3PalmInfo + "\r\n";
-        
-        // R3 palm touches (1 + 10-17) - always show line
-        int activeR3PalmTouches = 0;
-        std::string r3PalmInfo = "  R3 palm (1+10-17): ";
-        // Count center touch 1 if R3 is active
-        if (r3TouchActive && touchActive[1]) {
-            activeR3PalmTouches++;
-            if (activeR3PalmTouches <= 5) {
-                LONG screenX, screenY;
-                getTouchCoordinates(touchX[1], touchY[1], screenX, screenY);
-                r3PalmInfo += "1(" + std::to_string(screenX) + "," + std::to_string(screenY) + ") ";
-            }
-        }
-        for (int i = 10; i < 18; i++) {
-            if (touchActive[i]) {
-                activeR3PalmTouches++;
-                if (activeR3PalmTouches <= 5) {
-                    LONG screenX, screenY;
-                    getTouchCoordinates(touchX[i], touchY[i], screenX, screenY);
-                    r3PalmInfo += std::to_string(i) + "(" + std::to_string(screenX) + "," + std::to_string(screenY) + ") ";
-                }
-            }
-        }
-        if (activeR3PalmTouches > 0) {
-            r3PalmInfo += "[" + std::to_string(activeR3PalmTouches) + " total]";
-        } else {
-            r3PalmInfo += "none";
-        }
-        info += r3PalmInfo + "\r\n";
-        info += "\r\n";
-        
-        // Stick positions
-        info += "STICK POSITIONS:\r\n";
-        char buf[64];
-        sprintf_s(buf, "  Left:  X=%.2f Y=%.2f\r\n", overlayLeftX, overlayLeftY);
-        info += buf;
-        sprintf_s(buf, "  Right: X=%.2f Y=%.2f\r\n", overlayRightX, overlayRightY);
-        info += buf;
-        info += "\r\n";
-        
-        // Current angles and directions
-        info += "CURRENT DIRECTIONS:\r\n";
-        if (lAngle >= 0) {
-            sprintf_s(buf, "  Left:  %.1f° (Dir %d)\r\n", lAngle, lDirection);
-            info += buf;
-        } else {
-            info += "  Left:  ---\r\n";
-        }
-        if (rAngle >= 0) {
-            sprintf_s(buf, "  Right: %.1f° (Dir %d)\r\n", rAngle, rDirection);
-            info += buf;
-        } else {
-            info += "  Right: ---\r\n";
-        }
-        info += "\r\n";
-        
-    } else if (currentMode == InputMode::Mouse) {
-        info += "MOUSE CONTROL:\r\n";
-        bool leftPressed = prevL1;
-        bool rightPressed = prevR1;
-        bool bothPressed = leftPressed && rightPressed;
-        
-        // Get current mouse position
-        POINT mousePos;
-        GetCursorPos(&mousePos);
-        info += "  Cursor: (" + std::to_string(mousePos.x) + ", " + std::to_string(mousePos.y) + ")\r\n";
-        
-        if (bothPressed) {
-            info += "  Mode: Alternating sticks\r\n";
-            info += "  Current: " + std::string(alternateFrame ? "Left" : "Right") + "\r\n";
-        } else if (leftPressed) {
-            info += "  Mode: Left stick\r\n";
-        } else if (rightPressed) {
-            info += "  Mode: Right stick\r\n";
-        } else {
-            info += "  Mode: Inactive\r\n";
-        }
-        info += "\r\n";
-        
-        // Stick positions
-        info += "STICK POSITIONS:\r\n";
-        char buf[64];
-        sprintf_s(buf, "  Left:  X=%.2f Y=%.2f\r\n", overlayLeftX, overlayLeftY);
-        info += buf;
-        sprintf_s(buf, "  Right: X=%.2f Y=%.2f\r\n", overlayRightX, overlayRightY);
-        info += buf;
-        info += "\r\n";
-    } else if (currentMode == InputMode::Keyboard) {
-        info += "KEYBOARD (1-8):\r\n";
-        info += "  L Stick Key: " + (currentLeftKey.empty() ? std::string("---") : currentLeftKey) + "\r\n";
-        info += "  R Stick Key: " + (currentRightKey.empty() ? std::string("---") : currentRightKey) + "\r\n";
-        info += "\r\n";
-        
-        // Show stick details for keyboard mode
-        info += "STICK POSITIONS:\r\n";
-        char buf[64];
-        sprintf_s(buf, "  Left:  X=%.2f Y=%.2f\r\n", overlayLeftX, overlayLeftY);
-        info += buf;
-        sprintf_s(buf, "  Right: X=%.2f Y=%.2f\r\n", overlayRightX, overlayRightY);
-        info += buf;
-        info += "\r\n";
-        
-        info += "ANGLES:\r\n";
-        if (lAngle >= 0) {
-            sprintf_s(buf, "  Left:  %.1f°\r\n", lAngle);
-            info += buf;
-        } else {
-            info += "  Left:  ---\r\n";
-        }
-        if (rAngle >= 0) {
-            sprintf_s(buf, "  Right: %.1f°\r\n", rAngle);
-            info += buf;
-        } else {
-            info += "  Right: ---\r\n";
-        }
-        info += "\r\n";
-        
-        info += "DIRECTIONS:\r\n";
-        info += "  Left:  " + (lDirection >= 0 ? std::to_string(lDirection + 1) : std::string("---")) + "\r\n";
-        info += "  Right: " + (rDirection >= 0 ? std::to_string(rDirection + 1) : std::string("---")) + "\r\n";
-        info += "\r\n";
-    }
-    
-    info += "Ctrl+Shift+` = Toggle | Ctrl+Alt+Shift+` = Restart\r\n";
-
-    // Store debug info for overlay rendering
-    debugText = info;
-}
-
 void ControllerMapper::logError(const std::string& message) {
     std::cerr << "[ERROR] " << message << std::endl;
 }
@@ -1657,38 +1737,17 @@ void ControllerMapper::logInfo(const std::string& message) {
 }
 
 void ControllerMapper::run() {
-    if (!hwnd || (!joystick && !hasXInputController)) {
+    // initializeControllers() exits unless a controller was opened, replay unless the recording loaded
+    if (!hwnd) {
         std::cerr << "Not initialized!" << std::endl;
         return;
     }
     
     // Keep console visible throughout the process
     
-    // Clear keyboard state completely to prevent restart flag persistence
-    for (int i = 0; i < 20; i++) {
-        GetAsyncKeyState(VK_CONTROL);
-        GetAsyncKeyState(VK_SHIFT);
-        GetAsyncKeyState(VK_MENU);
-        GetAsyncKeyState(VK_OEM_3);
-        Sleep(20);
-    }
-    
-    // Wait for physical keys to be released
-    int waitCount = 0;
-    while (waitCount < 100) { // Max 5 seconds
-        bool anyKeyHeld = (GetAsyncKeyState(VK_CONTROL) & 0x8000) || 
-                          (GetAsyncKeyState(VK_SHIFT) & 0x8000) || 
-                          (GetAsyncKeyState(VK_MENU) & 0x8000) || 
-                          (GetAsyncKeyState(VK_OEM_3) & 0x8000);
-        
-        if (!anyKeyHeld) break;
-        
-        Sleep(50);
-        waitCount++;
-    }
-    
-    // Additional delay for safety
-    Sleep(200);
+    // No waiting for the restart keys to come up: the shortcuts fire on a press edge and
+    // their previous state starts out as the current one (below), so keys still held from
+    // the restart can't trigger anything
     
     // Clear ALL leftover messages from previous instance
     MSG clearMsg;
@@ -1705,9 +1764,21 @@ void ControllerMapper::run() {
     bool togglePressed = ctrlDown && shiftDown && !altDown && backtickDown;
     bool restartPressed = ctrlDown && shiftDown && altDown && backtickDown;
     
+    // Ctrl+Shift+F1/F2/F3: switch to touch/mouse/keyboard mode without restarting
+    static const int modeSwitchKeys[] = { VK_F1, VK_F2, VK_F3 };  // InputMode order
+    bool modeSwitchPressed[3];
+    for (int i = 0; i < 3; i++) {
+        modeSwitchPressed[i] = ctrlDown && shiftDown && !altDown && (GetAsyncKeyState(modeSwitchKeys[i]) & 0x8000) != 0;
+    }
+    
     // Initialize prev states to CURRENT state to prevent first-frame trigger
     bool prevTogglePressed = togglePressed;
     bool prevRestartPressed = restartPressed;
+    bool prevModeSwitchPressed[3] = { modeSwitchPressed[0], modeSwitchPressed[1], modeSwitchPressed[2] };
+
+    // Controller polling and injection run on their own thread from here on
+    startPollThread();
+    overlayPacer.reset();
 
     MSG msg = {};
     while (true) {
@@ -1716,11 +1787,19 @@ void ControllerMapper::run() {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
             if (msg.message == WM_QUIT) {
+                stopPollThread();
                 cleanup(); // Release all inputs before exiting
                 return; // Return immediately from run() method
             }
         }
 
+        // A replay ends the session once the whole recording went through
+        if (replayFinished) {
+            stopPollThread();
+            cleanup();
+            return;
+        }
+        
         // Check keyboard shortcuts
         ctrlDown = (GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0;
         shiftDown = (GetAsyncKeyState(VK_SHIFT) & 0x8000) != 0;
@@ -1730,194 +1809,582 @@ void ControllerMapper::run() {
         togglePressed = ctrlDown && shiftDown && !altDown && backtickDown;
         restartPressed = ctrlDown && shiftDown && altDown && backtickDown;
         
-        // Toggle debug on key press (not hold)
+        // Cycle debug panel -> panel and performance HUD -> off on key press (not hold)
         if (togglePressed && !prevTogglePressed) {
-            showDebugInfo = !showDebugInfo;
-            std::cout << "Debug info " << (showDebugInfo ? "enabled" : "disabled") << std::endl;
+            if (showDebugInfo && !showPerfHud) {
+                showPerfHud = true;
+                perfHudText.clear();        // Nothing to show until a full refresh interval was measured
+                perfHudRefreshTicks = 0;
+            } else if (showDebugInfo) {
+                showDebugInfo = false;
+                showPerfHud = false;
+            } else {
+                showDebugInfo = true;
+            }
+            std::cout << "Debug info " << (showDebugInfo ? (showPerfHud ? "enabled with performance HUD" : "enabled") : "disabled") << std::endl;
             if (overlayHwnd) {
-                RedrawWindow(overlayHwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW | RDW_NOFRAME);
+                redrawOverlay();
             }
         }
         
         // Restart program on key press (not hold)
         if (restartPressed && !prevRestartPressed) {
             std::cout << "Restarting..." << std::endl;
+            stopPollThread();
             cleanup(); // Release all inputs before restarting
             PostQuitMessage(0);
             return;
         }
         
+        // Switch mode on key press (not hold) - applied by the polling thread between samples
+        for (int i = 0; i < 3; i++) {
+            modeSwitchPressed[i] = ctrlDown && shiftDown && !altDown && (GetAsyncKeyState(modeSwitchKeys[i]) & 0x8000) != 0;
+            if (modeSwitchPressed[i] && !prevModeSwitchPressed[i]) {
+                static const char* modeNames[] = { "TOUCH", "MOUSE", "KEYBOARD" };
+                std::cout << "Switching to " << modeNames[i] << " mode..." << std::endl;
+                requestModeSwitch((InputMode)i);
+            }
+            prevModeSwitchPressed[i] = modeSwitchPressed[i];
+        }
+        
         prevTogglePressed = togglePressed;
         prevRestartPressed = restartPressed;
 
-        // Process controller (always, regardless of focus)
-        bool controllerSuccess = false;
-        bool l1Pressed = false;
-        bool r1Pressed = false;
-        bool l2Pressed = false;
-        bool r2Pressed = false;
-        bool l3Pressed = false;
-        bool r3Pressed = false;
-        double joyX = 0, joyY = 0, joyZ = 0, joyR = 0;
-        
-        if (hasXInputController) {
-            // Process XInput controller (Xbox controllers)
-            DWORD result = XInputGetState(xInputControllerIndex, &xInputState);
-            if (result == ERROR_SUCCESS) {
-                controllerSuccess = true;
-                
-                // XInput button mapping: Left Shoulder = L1, Right Shoulder = R1
-                l1Pressed = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER) != 0;
-                r1Pressed = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER) != 0;
-                
-                // XInput trigger mapping: L2 = Left trigger, R2 = Right trigger
-                // Triggers are analog (0-255), threshold at 128 (50%) to determine press
-                l2Pressed = xInputState.Gamepad.bLeftTrigger > 128;
-                r2Pressed = xInputState.Gamepad.bRightTrigger > 128;
-                
-                // XInput stick press mapping: L3 = Left stick press, R3 = Right stick press
-                l3Pressed = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_THUMB) != 0;
-                r3Pressed = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_THUMB) != 0;
-                
-                // XInput stick values: -32768 to 32767, normalize to -1.0 to 1.0
-                // For XInput, we need to match DirectInput coordinate system
-                joyX = xInputState.Gamepad.sThumbLX / STICK_MAX_VALUE;   // Left stick X
-                joyY = xInputState.Gamepad.sThumbLY / STICK_MAX_VALUE;   // Left stick Y (not inverted for XInput)
-                joyZ = xInputState.Gamepad.sThumbRX / STICK_MAX_VALUE;   // Right stick X
-                joyR = xInputState.Gamepad.sThumbRY / STICK_MAX_VALUE;   // Right stick Y (not inverted for XInput)
+        // Repaint only when the polling thread published new overlay state
+        if (overlayHwnd) {
+            bool overlayChanged = false;
+            if (overlayState.version() != paintStateVersion) {
+                paintStateVersion = overlayState.read(paintSnapshot);
+                overlayChanged = true;
             }
-        } else if (joystick) {
-            // Process DirectInput controller - use DIJOYSTATE2 for extended axes
-            DIJOYSTATE2 state;
-            HRESULT hr = joystick->GetDeviceState(sizeof(DIJOYSTATE2), &state);
-            
-            // If device lost, try to reacquire
-            if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED) {
-                joystick->Unacquire();
-                joystick->Acquire();
-                continue;
+            bool debugTextChanged = false;
+            if (debugTextVersion.load(std::memory_order_acquire) != paintDebugTextVersion) {
+                std::lock_guard<std::mutex> lock(debugTextMutex);
+                paintDebugText = sharedDebugText;
+                paintDebugTextVersion = debugTextVersion.load(std::memory_order_relaxed);
+                debugTextChanged = true;
+            }
+            if (overlayChanged) {
+                invalidateOverlayChanges(); // Only the areas that changed - Windows handles redraw timing
+            } else if (debugTextChanged) {
+                invalidateDebugText();      // Text-only refresh - just the panel rectangle
+            }
+            if (showPerfHud) {
+                refreshPerfHud();           // Its own rectangle, PERF_HUD_REFRESH_HZ at most
             }
             
-            if (SUCCEEDED(hr)) {
-                controllerSuccess = true;
-                
-                // DirectInput button mapping
-                l1Pressed = (state.rgbButtons[4] & 0x80) != 0;
-                r1Pressed = (state.rgbButtons[5] & 0x80) != 0;
-                
-                // DirectInput trigger mapping - use L2 and R2 buttons
-                l2Pressed = (state.rgbButtons[6] & 0x80) != 0;  // L2 button (button 6)
-                r2Pressed = (state.rgbButtons[7] & 0x80) != 0;  // R2 button (button 7)
-                
-                // DirectInput stick press mapping - use L3 and R3 buttons
-                l3Pressed = (state.rgbButtons[10] & 0x80) != 0;  // L3 button (button 10)
-                r3Pressed = (state.rgbButtons[11] & 0x80) != 0;  // R3 button (button 11)
-                
-                
-                // DirectInput stick values
-                joyX = (state.lX / 32767.5) - 1.0;
-                joyY = 1.0 - (state.lY / 32767.5);
-                joyZ = (state.lZ / 32767.5) - 1.0;
-                joyR = 1.0 - (state.lRz / 32767.5);
+            // GPU overlay that lost its device and couldn't get a new one yet
+            if (overlayBackend == OverlayBackend::GpuComposition && !d2dContext) {
+                recoverGpuOverlay();
             }
         }
-        
-        if (controllerSuccess) {
-            // Calculate angles
-            double lAngle = calculateAngle(joyX, joyY);
-            double rAngle = calculateAngle(joyZ, joyR);
-
-            // Get directions (for debug info)
-            int lDirection = getDirection(lAngle);
-            int rDirection = getDirection(rAngle);
-
-            // Handle input based on current mode
-            switch (currentMode) {
-                case InputMode::Touch:
-                    handleTouchControl(l1Pressed, r1Pressed, l2Pressed, r2Pressed, l3Pressed, r3Pressed, joyX, joyY, joyZ, joyR);
-                    break;
-                case InputMode::Mouse:
-                    handleMouseControl(l1Pressed, r1Pressed, joyX, joyY, joyZ, joyR);
-                    break;
-                case InputMode::Keyboard:
-                    handleKeyboardControl(l1Pressed, r1Pressed, joyX, joyY, joyZ, joyR);
-                    break;
-            }
             
-            // Update overlay with stick positions and angles
-            updateOverlay(joyX, joyY, joyZ, joyR, lAngle, rAngle);
-
-            // Update debug info (only if visible for efficiency)
-            if (showDebugInfo) {
-                if (hasXInputController) {
-                    updateDebugInfo(lAngle, rAngle, lDirection, rDirection);
-                } else if (joystick) {
-                    // For DirectInput, we need to get the state again for debug info
-                    DIJOYSTATE2 debugState;
-                    HRESULT debugHr = joystick->GetDeviceState(sizeof(DIJOYSTATE2), &debugState);
-                    if (SUCCEEDED(debugHr)) {
-                        updateDebugInfo(lAngle, rAngle, lDirection, rDirection, &debugState);
-                    } else {
-                        updateDebugInfo(lAngle, rAngle, lDirection, rDirection);
+        // Real-time monitor detection - check if cursor crossed monitor border
+        // (the debug panel picks the cursor position up on its own refresh)
+        checkMonitorChange();
+
+        // GPU overlay: everything above only marked the frame dirty - one render and
+        // Present for the whole iteration, including a move or resize from the monitor check
+        if (gpuFrameDirty && overlayHwnd) {
+            gpuFrameDirty = false;
+            renderGpuOverlay();
+        }
+
+        // Pace to the monitor refresh rate (overlay only - polling has its own pacer)
+        waitForOverlayFrame();
+    }
+}
+
+// ========== Polling Thread ==========
+
+void ControllerMapper::startPollThread() {
+    if (pollThreadRunning) return;
+    pollThreadRunning = true;
+    pollThread = std::thread(&ControllerMapper::pollLoop, this);
+    std::cout << "Polling thread started at " << pollRateHz << "Hz" << std::endl;
+}
+
+void ControllerMapper::stopPollThread() {
+    pollThreadRunning = false;
+    if (pollThread.joinable()) {
+        pollThread.join();
+    }
+}
+
+void ControllerMapper::pollLoop() {
+    // Join the multi-threaded apartment so the InputInjector created on the main thread works here
+    init_apartment();
+    
+    // Register with MMCSS as "Pro Audio" so polling is scheduled ahead of normal work
+    DWORD mmcssTaskIndex = 0;
+    HANDLE mmcssHandle = AvSetMmThreadCharacteristicsA("Pro Audio", &mmcssTaskIndex);
+    if (mmcssHandle) {
+        AvSetMmThreadPriority(mmcssHandle, AVRT_PRIORITY_HIGH);
+    } else {
+        // MMCSS unavailable (service disabled) - fall back to a plain priority boost
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    }
+    
+    // 1ms scheduler granularity for the pacer's fallback path on systems without
+    // high-resolution waitable timers
+    timeBeginPeriod(1);
+    pollPacer.setRate(pollDeadlineRateHz());
+    pollPacer.reset();
+    
+    if (replaying) {
+        replayRecording();
+    } else {
+        pollDeviceLoop();
+    }
+    
+    timeEndPeriod(1);
+    if (mmcssHandle) {
+        AvRevertMmThreadCharacteristics(mmcssHandle);
+    }
+    uninit_apartment();
+}
+
+double ControllerMapper::pollDeadlineRateHz() const {
+    // Upsampling interpolates on the poll deadlines, so it sets the deadline rate when it's faster
+    bool upsampling = (currentMode == InputMode::Touch && touchUpsampleHz > pollRateHz);
+    return upsampling ? touchUpsampleHz : pollRateHz;
+}
+
+bool ControllerMapper::isNeutralSample(const ControllerSample& sample) const {
+    if (sample.l1 || sample.r1 || sample.l2 || sample.r2 || sample.l3 || sample.r3) return false;
+    const double radiusSquared = IDLE_STICK_RADIUS * IDLE_STICK_RADIUS;
+    return sample.leftX * sample.leftX + sample.leftY * sample.leftY < radiusSquared &&
+           sample.rightX * sample.rightX + sample.rightY * sample.rightY < radiusSquared;
+}
+
+void ControllerMapper::leavePollIdle() {
+    // Pull the next deadline in from the idle period too, not just the ones after it
+    pollIdle = false;
+    pollPacer.setRate(pollDeadlineRateHz());
+    pollPacer.reset();
+    MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "Input - polling at %.0fHz", pollDeadlineRateHz());
+}
+
+void ControllerMapper::pollDeviceLoop() {
+    // Event-driven backends wake the thread as soon as new input is available on any controller
+    HANDLE inputEvents[MAX_CONTROLLERS];
+    int inputEventCount = 0;
+    for (int i = 0; i < controllerCount; i++) {
+        ControllerSlot& slot = controllers[i];
+        if (slot.joystick && slot.diBuffered) {
+            // Buffered events are applied on top of this, so start from the real device state
+            slot.joystick->GetDeviceState(sizeof(DIJOYSTATE2), &slot.diBufferedState);
+            inputEvents[inputEventCount++] = slot.diEvent;
+        } else if (slot.ds4Handle) {
+            inputEvents[inputEventCount++] = slot.ds4ReadEvent;
+        }
+    }
+    
+    // Only idle when every controller signals its input - those are still handled the moment
+    // it arrives. A polled (XInput/unbuffered) controller is only read on the deadline, so a
+    // slower one would hold back the first press by up to a whole idle period
+    bool idleAllowed = idleMs > 0 && inputEventCount == controllerCount;
+    lastActiveTicks = qpcNow();
+    
+    bool deadlineReached = true;
+    LONGLONG lastDeadlineTicks = 0;
+    while (pollThreadRunning) {
+        perfCounters.add(perfCounters.loopWakes);
+        applyModeSwitch();
+        for (int i = 0; i < controllerCount; i++) {
+            ControllerSlot& slot = controllers[i];
+            if (!pollSlot(slot, deadlineReached)) {
+                // Try to reacquire DirectInput if needed
+                if (slot.joystick) {
+                    slot.joystick->Unacquire();
+                    Sleep(10);
+                    slot.joystick->Acquire();
+                    if (slot.diBuffered) {
+                        slot.joystick->GetDeviceState(sizeof(DIJOYSTATE2), &slot.diBufferedState);
                     }
-                } else {
-                    updateDebugInfo(lAngle, rAngle, lDirection, rDirection);
+                } else if (slot.ds4Handle) {
+                    Sleep(10);  // Unplugged - don't spin on a failing read
                 }
             }
+        }
+        
+        // Neutral on every controller for idleMs - slow the deadline down until the next real input
+        if (idleAllowed && !pollIdle && qpcNow() - lastActiveTicks > idleMs * qpcFrequency() / 1000) {
+            pollIdle = true;
+            pollPacer.setRate(IDLE_EVENT_RATE_HZ);
+            MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "Idle - polling at %.0fHz", IDLE_EVENT_RATE_HZ);
+        }
+        
+        // Absolute-deadline pacing keeps the poll period exact regardless of how long this iteration took.
+        // Event-driven backends also wake early when a device signals new data.
+        if (inputEventCount > 0) {
+            deadlineReached = !pollPacer.waitOrEvents(inputEvents, inputEventCount);
         } else {
-            // Try to reacquire DirectInput if needed
-            if (joystick) {
-                joystick->Unacquire();
-                Sleep(10);
-                joystick->Acquire();
-            }
+            pollPacer.wait();
         }
-            
-        // Real-time monitor detection - check if cursor crossed monitor border
-        // This also gets cursor position which we'll use for debug overlay updates
-        POINT cursorPos = checkMonitorChange();
         
-        // Check for mouse movement to update debug overlay visually
-        if (showDebugInfo && (lastMousePos.x != cursorPos.x || lastMousePos.y != cursorPos.y)) {
-            // Mouse moved - force overlay redraw to show updated mouse position
-            // The debug info text will be updated on next controller processing cycle
-            // which already calls updateDebugInfo() and includes mouse position
-            if (overlayHwnd) {
-                InvalidateRect(overlayHwnd, nullptr, TRUE);
+        // Deadline-to-deadline periods feed the HUD's jitter graph
+        if (deadlineReached) {
+            LONGLONG now = qpcNow();
+            if (lastDeadlineTicks != 0) {
+                pollPeriodRecorder.record(lastDeadlineTicks, now);
             }
-            lastMousePos = cursorPos;
+            lastDeadlineTicks = now;
         }
+    }
+}
+
+bool ControllerMapper::pollSlot(ControllerSlot& slot, bool deadlineReached) {
+    if (slot.joystick && slot.diBuffered) {
+        return drainDirectInputBuffer(slot, deadlineReached);
+    }
+    if (slot.ds4Handle) {
+        return readDualShock4Reports(slot, deadlineReached);
+    }
+    
+    // Polled backends are read once per period, not on another controller's early wake-up
+    if (!deadlineReached) {
+        return true;
+    }
+    ControllerSample sample;
+    if (!pollController(slot, sample)) {
+        return false;
+    }
+    processSample(slot, sample);
+    return true;
+}
 
-        // Sleep based on refresh rate to match monitor
-        Sleep(updateIntervalMs);
+bool ControllerMapper::pollController(ControllerSlot& slot, ControllerSample& sample) {
+    sample = {};
+    
+    if (slot.type == ControllerType::XInput) {
+        // Process XInput controller (Xbox controllers)
+        XINPUT_STATE xInputState;
+        DWORD result = XInputGetState(slot.xInputIndex, &xInputState);
+        if (result != ERROR_SUCCESS) {
+            return false;
+        }
+        
+        // XInput button mapping: Left Shoulder = L1, Right Shoulder = R1
+        sample.l1 = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER) != 0;
+        sample.r1 = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER) != 0;
+        
+        // XInput trigger mapping: L2 = Left trigger, R2 = Right trigger
+        // Triggers are analog (0-255), pressed past the conditioning threshold (default 128, 50%)
+        sample.l2 = stickConditioner.triggerPressed(xInputState.Gamepad.bLeftTrigger);
+        sample.r2 = stickConditioner.triggerPressed(xInputState.Gamepad.bRightTrigger);
+        
+        // XInput stick press mapping: L3 = Left stick press, R3 = Right stick press
+        sample.l3 = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_THUMB) != 0;
+        sample.r3 = (xInputState.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_THUMB) != 0;
+        
+        // XInput stick values: -32768 to 32767, normalized (and conditioned) to -1.0 to 1.0
+        // For XInput, we need to match DirectInput coordinate system
+        sample.leftX = stickConditioner.xInputAxis(xInputState.Gamepad.sThumbLX);   // Left stick X
+        sample.leftY = stickConditioner.xInputAxis(xInputState.Gamepad.sThumbLY);   // Left stick Y (not inverted for XInput)
+        sample.rightX = stickConditioner.xInputAxis(xInputState.Gamepad.sThumbRX);  // Right stick X
+        sample.rightY = stickConditioner.xInputAxis(xInputState.Gamepad.sThumbRY);  // Right stick Y (not inverted for XInput)
+        stickConditioner.applyRadial(sample.leftX, sample.leftY);
+        stickConditioner.applyRadial(sample.rightX, sample.rightY);
+        sample.timestamp = qpcNow();
+        return true;
+    }
+    
+    if (slot.joystick) {
+        // Process DirectInput controller - use DIJOYSTATE2 for extended axes
+        DIJOYSTATE2 state;
+        HRESULT hr = slot.joystick->GetDeviceState(sizeof(DIJOYSTATE2), &state);
+        
+        // If device lost, try to reacquire
+        if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED) {
+            slot.joystick->Unacquire();
+            slot.joystick->Acquire();
+            return false;
+        }
+        
+        if (FAILED(hr)) {
+            return false;
+        }
+        
+        sampleFromDirectInputState(state, sample);
+        sample.timestamp = qpcNow();
+        return true;
     }
+    
+    return false;
 }
 
-void ControllerMapper::cleanup() {
-    // Release all keyboard keys (for Keyboard mode)
-    if (!currentLeftKey.empty()) {
-        sendKeyPress(currentLeftKey, false);
-        currentLeftKey = "";
+void ControllerMapper::sampleFromDirectInputState(const DIJOYSTATE2& state, ControllerSample& sample) {
+    // DirectInput button mapping (buttons 4/5 by default)
+    sample.l1 = (state.rgbButtons[diButtonMap.l1 & 127] & 0x80) != 0;
+    sample.r1 = (state.rgbButtons[diButtonMap.r1 & 127] & 0x80) != 0;
+    
+    // DirectInput trigger mapping - use L2 and R2 buttons (6/7 by default)
+    sample.l2 = (state.rgbButtons[diButtonMap.l2 & 127] & 0x80) != 0;
+    sample.r2 = (state.rgbButtons[diButtonMap.r2 & 127] & 0x80) != 0;
+    
+    // DirectInput stick press mapping - use L3 and R3 buttons (10/11 by default)
+    sample.l3 = (state.rgbButtons[diButtonMap.l3 & 127] & 0x80) != 0;
+    sample.r3 = (state.rgbButtons[diButtonMap.r3 & 127] & 0x80) != 0;
+    
+    // DirectInput stick values (0-65535, Y axes point down)
+    sample.leftX = stickConditioner.directInputAxis(state.lX);
+    sample.leftY = -stickConditioner.directInputAxis(state.lY);
+    sample.rightX = stickConditioner.directInputAxis(state.lZ);
+    sample.rightY = -stickConditioner.directInputAxis(state.lRz);
+    stickConditioner.applyRadial(sample.leftX, sample.leftY);
+    stickConditioner.applyRadial(sample.rightX, sample.rightY);
+}
+
+bool ControllerMapper::drainDirectInputBuffer(ControllerSlot& slot, bool deadlineReached) {
+    // No-op for interrupt-driven HID devices, required for polled ones to fill the buffer
+    slot.joystick->Poll();
+    
+    DIDEVICEOBJECTDATA events[DI_BUFFER_SIZE];
+    DWORD count;
+    do {
+        count = DI_BUFFER_SIZE;
+        HRESULT hr = slot.joystick->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), events, &count, 0);
+        if (FAILED(hr)) {
+            return false;  // Lost/not acquired - pollDeviceLoop reacquires and resyncs
+        }
+        
+        if (hr == DI_BUFFEROVERFLOW) {
+            // Events were dropped, so the buffered state can't be trusted - flush what's
+            // left and resync from the device (the next deadline dispatches it)
+            slot.diBufferOverflows++;
+            perfCounters.add(perfCounters.bufferOverflows);
+            DWORD flush = INFINITE;
+            slot.joystick->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), nullptr, &flush, 0);
+            slot.joystick->GetDeviceState(sizeof(DIJOYSTATE2), &slot.diBufferedState);
+            break;
+        }
+        
+        // Events from the same device report share a sequence number - apply the whole
+        // report, then dispatch it once if it changed a mapped button
+        int mappedEdges = 0;
+        for (DWORD i = 0; i < count; i++) {
+            const DIDEVICEOBJECTDATA& event = events[i];
+            switch (event.dwOfs) {
+                case DIJOFS_X:  slot.diBufferedState.lX = (LONG)event.dwData; break;
+                case DIJOFS_Y:  slot.diBufferedState.lY = (LONG)event.dwData; break;
+                case DIJOFS_Z:  slot.diBufferedState.lZ = (LONG)event.dwData; break;
+                case DIJOFS_RZ: slot.diBufferedState.lRz = (LONG)event.dwData; break;
+                default:
+                    if (event.dwOfs >= DIJOFS_BUTTON0 && event.dwOfs < DIJOFS_BUTTON(128)) {
+                        DWORD button = event.dwOfs - DIJOFS_BUTTON0;
+                        BYTE pressed = (BYTE)(event.dwData & 0x80);
+                        if ((slot.diBufferedState.rgbButtons[button] & 0x80) != pressed && diMappedButtons[button]) {
+                            mappedEdges++;
+                        }
+                        slot.diBufferedState.rgbButtons[button] = (BYTE)event.dwData;
+                    }
+                    break;
+            }
+            
+            bool reportEnds = (i + 1 == count) || (events[i + 1].dwSequence != event.dwSequence);
+            if (reportEnds && mappedEdges > 0) {
+                ControllerSample sample = {};
+                sampleFromDirectInputState(slot.diBufferedState, sample);
+                // Drain time, not dwTimeStamp - that is tick-granular (~15.6ms) and would
+                // put an edge before the slot's previous QPC-stamped sample
+                sample.timestamp = qpcNow();
+                processSample(slot, sample);
+                if (mappedEdges > 1) {
+                    perfCounters.add(perfCounters.coalescedEdges, mappedEdges - 1);
+                }
+                mappedEdges = 0;
+            }
+        }
+    } while (count == DI_BUFFER_SIZE);  // A full read may have left more behind
+    
+    // Stick motion is folded into the running state and sent once per poll period,
+    // which also keeps held touches updated when nothing changes. While idle that period
+    // is long, so the first stick motion out of the centre is sent as soon as it arrives
+    if (deadlineReached || pollIdle) {
+        ControllerSample sample = {};
+        sampleFromDirectInputState(slot.diBufferedState, sample);
+        sample.timestamp = qpcNow();
+        if (deadlineReached || !isNeutralSample(sample)) {
+            processSample(slot, sample);
+        }
+    }
+    return true;
+}
+
+void ControllerMapper::processSample(ControllerSlot& slot, const ControllerSample& sample) {
+    // Get directions (for the overlay and debug info)
+    int lDirection = getStickDirection(sample.leftX, sample.leftY);
+    int rDirection = getStickDirection(sample.rightX, sample.rightY);
+
+    if (!recordPath.empty()) {
+        recordSample(slot.index, sample);
     }
-    if (!currentRightKey.empty()) {
-        sendKeyPress(currentRightKey, false);
-        currentRightKey = "";
+    
+    // Everything this sample causes is measured from the moment it was read
+    currentSampleTicks = sample.timestamp;
+    sampleToHandlerLatency.record(sample.timestamp, qpcNow());
+    perfCounters.add(perfCounters.samples);
+    
+    // Any real input ends idling before it's handled
+    if (!isNeutralSample(sample)) {
+        lastActiveTicks = sample.timestamp;
+        if (pollIdle) {
+            leavePollIdle();
+        }
     }
     
-    // Release all touch points
-    if (leftTouchActive) {
-        sendTouch(0, 0, 0, false, true); // Send touch up
-        leftTouchActive = false;
+    // Handle input based on current mode
+    (this->*MODE_HANDLERS[(int)currentMode])(slot, sample);
+    flushInputFrame();  // Mouse/keyboard events of this sample, one SendInput
+    
+    // Update overlay with stick positions and directions
+    updateOverlay(slot, sample.leftX, sample.leftY, sample.rightX, sample.rightY, lDirection, rDirection);
+
+    // Update debug info (only if visible, and no faster than debugRefreshHz) - the panel
+    // describes the first controller
+    if (showDebugInfo && slot.index == 0) {
+        LONGLONG now = qpcNow();
+        if (now - lastDebugUpdateTicks >= qpcFrequency() / debugRefreshHz) {
+            lastDebugUpdateTicks = now;
+            // Angles are only displayed, so only computed here
+            updateDebugInfo(slot, calculateAngle(sample.leftX, sample.leftY), calculateAngle(sample.rightX, sample.rightY),
+                            lDirection, rDirection);
+        }
+    }
+}
+
+// Indexed by InputMode - keep in enum order
+const ControllerMapper::ModeHandler ControllerMapper::MODE_HANDLERS[3] = {
+    &ControllerMapper::processTouchSample,
+    &ControllerMapper::processMouseSample,
+    &ControllerMapper::processKeyboardSample,
+};
+
+void ControllerMapper::processTouchSample(ControllerSlot& slot, const ControllerSample& sample) {
+    // Touches follow the predicted stick; the overlay still shows the real one
+    double leftX = sample.leftX, leftY = sample.leftY;
+    double rightX = sample.rightX, rightY = sample.rightY;
+    if (predictionMs > 0) {
+        predictTouchPositions(slot, sample, leftX, leftY, rightX, rightY);
+    }
+    if (touchUpsampleHz > 0) {
+        upsampleTouchPositions(slot, sample, leftX, leftY, rightX, rightY);
+    }
+    handleTouchControl(slot, sample.l1, sample.r1, sample.l2, sample.r2, sample.l3, sample.r3,
+                       leftX, leftY, rightX, rightY);
+}
+
+// There is one cursor and one keyboard, so only the first controller drives mouse and keyboard mode
+void ControllerMapper::processMouseSample(ControllerSlot& slot, const ControllerSample& sample) {
+    if (slot.index == 0) {
+        handleMouseControl(slot, sample.l1, sample.r1, sample.leftX, sample.leftY, sample.rightX, sample.rightY);
+    }
+}
+
+void ControllerMapper::processKeyboardSample(ControllerSlot& slot, const ControllerSample& sample) {
+    if (slot.index == 0) {
+        handleKeyboardControl(slot, sample.l1, sample.r1, sample.leftX, sample.leftY, sample.rightX, sample.rightY);
+    }
+}
+
+// ========== Keyboard/Mouse Input Frame ==========
+
+void ControllerMapper::queueInput(const INPUT& input) {
+    if (inputFrameCount == (int)(sizeof(inputFrame) / sizeof(inputFrame[0]))) {
+        flushInputFrame();  // Can't happen with the current modes - keep order if it ever does
+    }
+    inputFrame[inputFrameCount++] = input;
+}
+
+void ControllerMapper::flushInputFrame() {
+    if (inputFrameCount == 0) return;
+    if (!replaying) {  // Replay never presses real keys or moves the real cursor
+        SendInput(inputFrameCount, inputFrame, sizeof(INPUT));
+    }
+    inputFrameCount = 0;
+}
+
+void ControllerMapper::cleanup() {
+    // Release whatever the sticks hold down (for Keyboard mode)
+    if (currentLeftSector != -1) {
+        sendSectorAction(keyboardLayout.left[currentLeftSector], false);
+        currentLeftSector = -1;
+    }
+    if (currentRightSector != -1) {
+        sendSectorAction(keyboardLayout.right[currentRightSector], false);
+        currentRightSector = -1;
+    }
+    
+    // Release every contact still down on any controller - touches and palm patterns -
+    // where it was last injected
+    flushTouchFrame();
+    for (int touchId = 0; touchId < controllerCount * TOUCHES_PER_CONTROLLER; touchId++) {
+        if (injectedTouchActive[touchId]) {
+            sendTouch(touchId, injectedTouchX[touchId], injectedTouchY[touchId], false, true); // Send touch up
+        }
     }
-    if (rightTouchActive) {
-        sendTouch(1, 0, 0, false, true); // Send touch up
-        rightTouchActive = false;
+    for (int i = 0; i < controllerCount; i++) {
+        controllers[i].leftTouchActive = false;
+        controllers[i].rightTouchActive = false;
+        controllers[i].l3TouchActive = false;
+        controllers[i].r3TouchActive = false;
     }
+    flushTouchFrame();
     
     // Release mouse button
     if (mouseButtonPressed) {
         sendMouseButton(false);
         mouseButtonPressed = false;
     }
+    flushInputFrame();
+}
+
+// ========== Mode Switching ==========
+// Ctrl+Shift+F1/F2/F3 change the mode in place: the controllers, the overlay window and
+// the injector stay, only the handler that samples are dispatched to (and its state) changes
+
+void ControllerMapper::requestModeSwitch(InputMode mode) {
+    if (replaying) return;  // A replay runs in the mode it was recorded in
+    
+    // The injector is created once, on this thread like at startup, and kept from then on.
+    // The polling thread only touches it in touch mode, which it isn't in yet
+    if (mode == InputMode::Touch) {
+        initializeTouchInjection();
+        if (!inputInjectorInitialized) {
+            logError("Touch injection unavailable - staying in the current mode");
+            return;
+        }
+    }
+    requestedMode.store((int)mode, std::memory_order_release);
+}
+
+void ControllerMapper::applyModeSwitch() {
+    int requested = requestedMode.exchange(-1, std::memory_order_acquire);
+    if (requested < 0 || (InputMode)requested == currentMode) return;
+    
+    // Lift everything the old mode holds down and forget its per-controller state. The
+    // previous button states stay, so a button held through the switch needs a new press
+    cleanup();
+    for (int i = 0; i < controllerCount; i++) {
+        ControllerSlot& slot = controllers[i];
+        slot.currentLHeldDirection = -1;
+        slot.currentRHeldDirection = -1;
+        slot.leftPointerLocked = false;
+        slot.rightPointerLocked = false;
+        slot.leftLockedDirection = -1;
+        slot.rightLockedDirection = -1;
+        slot.leftPredictor.reset();
+        slot.rightPredictor.reset();
+        slot.upsampleValid = false;
+    }
+    alternateFrame = false;
+    
+    currentMode = (InputMode)requested;
+    pollIdle = false;
+    lastActiveTicks = qpcNow();
+    pollPacer.setRate(pollDeadlineRateHz());
+    static const char* modeNames[] = { "touch", "mouse", "keyboard" };
+    MAPPER_LOG(asyncLog.poll, LogLevel::Info, "Switched to %s mode", modeNames[requested]);
 }
 
@@ -0,0 +1,237 @@
+#include "ControllerInput.h"
+
+// ========== DualShock 4 HID Implementation ==========
+// Reads the DS4's own input reports instead of going through DirectInput's generic
+// DIJOYSTATE2 translation. Every report is handled the moment its read completes,
+// so report-to-injection latency can be measured per report.
+
+void ControllerMapper::listDualShock4Controllers(std::vector<ControllerInfo>& controllers) {
+    GUID hidGuid;
+    HidD_GetHidGuid(&hidGuid);
+
+    HDEVINFO devInfo = SetupDiGetClassDevsA(&hidGuid, nullptr, nullptr, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+    if (devInfo == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    int found = 0;
+    SP_DEVICE_INTERFACE_DATA interfaceData = {};
+    interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+    for (DWORD i = 0; SetupDiEnumDeviceInterfaces(devInfo, nullptr, &hidGuid, i, &interfaceData); i++) {
+        DWORD detailSize = 0;
+        SetupDiGetDeviceInterfaceDetailA(devInfo, &interfaceData, nullptr, 0, &detailSize, nullptr);
+        if (detailSize == 0) {
+            continue;
+        }
+
+        std::vector<BYTE> detailBuffer(detailSize);
+        SP_DEVICE_INTERFACE_DETAIL_DATA_A* detail = (SP_DEVICE_INTERFACE_DETAIL_DATA_A*)detailBuffer.data();
+        detail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_A);
+        if (!SetupDiGetDeviceInterfaceDetailA(devInfo, &interfaceData, detail, detailSize, nullptr, nullptr)) {
+            continue;
+        }
+
+        // No access rights needed to read attributes - works even while another app has the device open
+        HANDLE device = CreateFileA(detail->DevicePath, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (device == INVALID_HANDLE_VALUE) {
+            continue;
+        }
+
+        bool isDualShock4 = false;
+        HIDD_ATTRIBUTES attributes = {};
+        attributes.Size = sizeof(HIDD_ATTRIBUTES);
+        if (HidD_GetAttributes(device, &attributes) && attributes.VendorID == DS4_VENDOR_ID) {
+            for (USHORT productId : DS4_PRODUCT_IDS) {
+                if (attributes.ProductID == productId) {
+                    isDualShock4 = true;
+                }
+            }
+        }
+        CloseHandle(device);
+
+        if (isDualShock4) {
+            ControllerInfo info;
+            info.type = ControllerType::DualShock4Hid;
+            info.name = "DualShock 4 Controller " + std::to_string(++found);
+            info.index = 0;
+            info.guid = {};
+            info.devicePath = detail->DevicePath;
+            controllers.push_back(info);
+        }
+    }
+
+    SetupDiDestroyDeviceInfoList(devInfo);
+}
+
+bool ControllerMapper::initializeDualShock4(ControllerSlot& slot, const std::string& devicePath) {
+    HANDLE device = CreateFileA(devicePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    if (device == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // Report size differs between USB (64 bytes) and Bluetooth (547 bytes)
+    PHIDP_PREPARSED_DATA preparsed = nullptr;
+    HIDP_CAPS caps = {};
+    if (!HidD_GetPreparsedData(device, &preparsed)) {
+        CloseHandle(device);
+        return false;
+    }
+    HidP_GetCaps(preparsed, &caps);
+    HidD_FreePreparsedData(preparsed);
+
+    if (caps.InputReportByteLength == 0) {
+        CloseHandle(device);
+        return false;
+    }
+
+    slot.ds4Handle = device;
+    slot.ds4Report.assign(caps.InputReportByteLength, 0);
+
+    // Deeper driver queue so no report is dropped if the polling thread is briefly late
+    HidD_SetNumInputBuffers(slot.ds4Handle, 64);
+
+    // Over Bluetooth the DS4 only sends the reduced 0x01 report until feature report 0x02
+    // is read, which switches it to the full-rate 0x11 report (harmless over USB)
+    if (caps.FeatureReportByteLength > 0) {
+        std::vector<BYTE> feature(caps.FeatureReportByteLength, 0);
+        feature[0] = 0x02;
+        HidD_GetFeature(slot.ds4Handle, feature.data(), (ULONG)feature.size());
+    }
+
+    // Manual-reset as required for overlapped I/O - ReadFile clears it when each read starts
+    slot.ds4ReadEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    slot.ds4Overlapped = {};
+    slot.ds4Overlapped.hEvent = slot.ds4ReadEvent;
+    slot.ds4ReadPending = false;
+    return slot.ds4ReadEvent != nullptr;
+}
+
+void ControllerMapper::closeDualShock4(ControllerSlot& slot) {
+    if (slot.ds4Handle) {
+        if (slot.ds4ReadPending) {
+            // The read targets ds4Report - let it finish cancelling before the buffer goes away
+            DWORD bytesRead = 0;
+            CancelIoEx(slot.ds4Handle, &slot.ds4Overlapped);
+            GetOverlappedResult(slot.ds4Handle, &slot.ds4Overlapped, &bytesRead, TRUE);
+            slot.ds4ReadPending = false;
+        }
+        CloseHandle(slot.ds4Handle);
+        slot.ds4Handle = nullptr;
+    }
+    if (slot.ds4ReadEvent) {
+        CloseHandle(slot.ds4ReadEvent);
+        slot.ds4ReadEvent = nullptr;
+    }
+}
+
+bool ControllerMapper::readDualShock4Reports(ControllerSlot& slot, bool deadlineReached) {
+    bool gotReport = false;
+
+    // Handle every completed report, keeping one read outstanding
+    for (;;) {
+        if (!slot.ds4ReadPending) {
+            if (!ReadFile(slot.ds4Handle, slot.ds4Report.data(), (DWORD)slot.ds4Report.size(), nullptr, &slot.ds4Overlapped) &&
+                GetLastError() != ERROR_IO_PENDING) {
+                return false;  // Disconnected
+            }
+            slot.ds4ReadPending = true;
+        }
+
+        DWORD bytesRead = 0;
+        if (!GetOverlappedResult(slot.ds4Handle, &slot.ds4Overlapped, &bytesRead, FALSE)) {
+            if (GetLastError() == ERROR_IO_INCOMPLETE) {
+                break;  // No new report yet
+            }
+            slot.ds4ReadPending = false;
+            return false;
+        }
+        slot.ds4ReadPending = false;
+
+        LONGLONG arrival = qpcNow();
+        ControllerSample sample = {};
+        int reportCounter;
+        if (!parseDualShock4Report(slot.ds4Report.data(), bytesRead, sample, reportCounter)) {
+            continue;  // Not an input report we understand
+        }
+        sample.timestamp = arrival;
+
+        // The counter steps by one per report - a bigger step is reports the HID stack dropped
+        if (slot.ds4LastCounter >= 0) {
+            int missed = (reportCounter - slot.ds4LastCounter - 1) & 63;
+            if (missed > 0) {
+                perfCounters.add(perfCounters.droppedReports, missed);
+            }
+        }
+        slot.ds4LastCounter = reportCounter;
+
+        if (slot.ds4LastReportTicks != 0) {
+            double intervalMs = (arrival - slot.ds4LastReportTicks) * 1000.0 / qpcFrequency();
+            slot.ds4ReportIntervalMs += (intervalMs - slot.ds4ReportIntervalMs) * 0.05;
+        }
+        slot.ds4LastReportTicks = arrival;
+
+        // The pad reports continuously - while idle, neutral reports are left to the idle
+        // deadline below instead of each going through the handlers
+        if (pollIdle && isNeutralSample(sample)) {
+            slot.ds4LastSample = sample;
+            continue;
+        }
+        processSample(slot, sample);
+
+        // Report arrival -> handler (and its injection) finished
+        double latencyUs = (qpcNow() - arrival) * 1000000.0 / qpcFrequency();
+        slot.ds4ReportLatencyUs += (latencyUs - slot.ds4ReportLatencyUs) * 0.05;
+        if (latencyUs > slot.ds4MaxReportLatencyUs) {
+            slot.ds4MaxReportLatencyUs = latencyUs;
+        }
+
+        slot.ds4LastSample = sample;
+        gotReport = true;
+    }
+
+    // Reports normally outpace the poll deadline; if one is late, re-send the last
+    // state so held touches keep updating
+    if (deadlineReached && !gotReport && slot.ds4LastReportTicks != 0) {
+        ControllerSample sample = slot.ds4LastSample;
+        sample.timestamp = qpcNow();
+        processSample(slot, sample);
+    }
+    return true;
+}
+
+bool ControllerMapper::parseDualShock4Report(const BYTE* report, DWORD length, ControllerSample& sample, int& reportCounter) {
+    // USB (and reduced Bluetooth) report 0x01 has data from byte 1,
+    // the full Bluetooth report 0x11 has two extra header bytes first
+    DWORD offset;
+    if (length >= 10 && report[0] == 0x01) {
+        offset = 1;
+    } else if (length >= 12 && report[0] == 0x11) {
+        offset = 3;
+    } else {
+        return false;
+    }
+    const BYTE* data = report + offset;
+
+    // Sticks: 0-255, Y axes point down - same orientation as the DirectInput mapping
+    sample.leftX = stickConditioner.ds4Axis(data[0]);
+    sample.leftY = -stickConditioner.ds4Axis(data[1]);
+    sample.rightX = stickConditioner.ds4Axis(data[2]);
+    sample.rightY = -stickConditioner.ds4Axis(data[3]);
+    stickConditioner.applyRadial(sample.leftX, sample.leftY);
+    stickConditioner.applyRadial(sample.rightX, sample.rightY);
+
+    // Byte 5 of the data: L1, R1, L2, R2, Share, Options, L3, R3
+    // (the same order DirectInput exposes as buttons 4-11)
+    BYTE buttons = data[5];
+    sample.l1 = (buttons & 0x01) != 0;
+    sample.r1 = (buttons & 0x02) != 0;
+    sample.l2 = (buttons & 0x04) != 0;
+    sample.r2 = (buttons & 0x08) != 0;
+    sample.l3 = (buttons & 0x40) != 0;
+    sample.r3 = (buttons & 0x80) != 0;
+
+    // Byte 6: PS and touchpad click in the low bits, a 6-bit report counter above them
+    reportCounter = data[6] >> 2;
+    return true;
+}
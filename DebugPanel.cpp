@@ -0,0 +1,288 @@
+#include "ControllerInput.h"
+#include <cstdarg>
+#include <cstdio>
+
+// ========== Debug Panel Implementation ==========
+// The panel text is formatted on the polling thread from the sample it already
+// handled, into a fixed buffer, at most debugRefreshHz times a second. It is only
+// handed to the overlay (and its rectangle only repainted) when the text changed.
+
+void DebugTextBuffer::append(const char* str) {
+    while (*str && length < CAPACITY - 1) {
+        text[length++] = *str++;
+    }
+    text[length] = '\0';
+}
+
+void DebugTextBuffer::appendf(const char* format, ...) {
+    int space = CAPACITY - length;
+    if (space <= 1) return;
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text + length, space, format, args);
+    va_end(args);
+
+    // Truncated output still leaves a terminated, full buffer
+    if (written > 0) {
+        length += (written < space) ? written : space - 1;
+    }
+}
+
+void ControllerMapper::appendTouchScreenPos(DebugTextBuffer& out, int touchId, double stickX, double stickY) {
+    LONG screenX, screenY;
+    getTouchCoordinates(stickX, stickY, screenX, screenY);
+    if (touchId >= 0) {
+        out.appendf("%d(%ld,%ld) ", touchId, screenX, screenY);
+    } else {
+        out.appendf("    Screen: (%ld, %ld)\r\n", screenX, screenY);
+    }
+}
+
+void ControllerMapper::appendPalmTouches(DebugTextBuffer& out, const char* label, int centerId, int firstCorner, int lastCorner, bool palmActive) {
+    out.append(label);
+    int activeTouches = 0;
+
+    // Count the center touch if the palm is active, then the corners
+    if (palmActive && touchActive[centerId]) {
+        activeTouches++;
+        appendTouchScreenPos(out, centerId, touchX[centerId], touchY[centerId]);
+    }
+    for (int i = firstCorner; i <= lastCorner; i++) {
+        if (touchActive[i]) {
+            activeTouches++;
+            if (activeTouches <= 5) {
+                appendTouchScreenPos(out, i, touchX[i], touchY[i]);
+            }
+        }
+    }
+    if (activeTouches > 0) {
+        out.appendf("[%d total]\r\n", activeTouches);
+    } else {
+        out.append("none\r\n");
+    }
+}
+
+void ControllerMapper::updateDebugInfo(const ControllerSlot& slot, double lAngle, double rAngle, int lDirection, int rDirection) {
+    // Build debug info text based on current mode
+    // This is displayed on the overlay (bottom-left, large text)
+    DebugTextBuffer& out = debugTextBuilder;
+    out.clear();
+
+    out.append("CONTROLLER INPUT MAPPER\r\n");
+    DWORD bufferOverflows = 0;
+    for (int i = 0; i < controllerCount; i++) {
+        const ControllerSlot& pad = controllers[i];
+        if (controllerCount > 1) {
+            out.appendf("P%d ", i + 1);
+        }
+        out.append(pad.type == ControllerType::XInput ? "XInput" : pad.ds4Handle ? "DualShock 4 (HID)" :
+                   (pad.joystick && pad.diBuffered) ? "DirectInput (buffered)" : "DirectInput");
+        out.append(" | ");
+        bufferOverflows += pad.diBufferOverflows;
+    }
+    if (bufferOverflows > 0) {
+        out.appendf("Buffer overflows: %lu | ", bufferOverflows);
+    }
+
+    // Show current mode
+    switch (currentMode) {
+        case InputMode::Touch:
+            out.append("Touch Mode\r\n");
+            break;
+        case InputMode::Mouse:
+            out.append("Mouse Mode\r\n");
+            break;
+        case InputMode::Keyboard:
+            out.append("Keyboard Mode\r\n");
+            break;
+    }
+
+    // Achieved loop periods (target in parentheses) - confirms the pacers hold their rate
+    out.appendf("Poll: %.3fms (%.3f)%s | Overlay: %.2fms (%.2f)%s\r\n",
+                pollPacer.getAchievedPeriodMs(), pollPacer.getTargetPeriodMs(), pollIdle ? " [idle]" : "",
+                overlayPacer.getAchievedPeriodMs(), overlayPacer.getTargetPeriodMs(),
+                pollPacer.isHighResolution() ? "" : " [low-res timer]");
+    if (currentMode == InputMode::Touch && lastPalmSpreadUs > 0.0) {
+        static const char* palmModeNames[] = { "atomic", "staggered", "serialized" };
+        out.appendf("Palm down spread: %.0fus (%s)\r\n", lastPalmSpreadUs, palmModeNames[(int)palmInjectionMode]);
+    }
+    if (currentMode == InputMode::Touch && predictionMs > 0) {
+        out.appendf("Slide prediction: %dms look-ahead\r\n", predictionMs);
+    }
+    if (currentMode == InputMode::Touch && touchUpsampleHz > 0) {
+        out.appendf("Touch upsampling: %dHz (%.2fms segments)\r\n",
+                    touchUpsampleHz > pollRateHz ? touchUpsampleHz : pollRateHz, slot.upsampleIntervalMs);
+    }
+    if (!stickConditioner.isIdentity()) {
+        const StickConditioning& conditioning = stickConditioner.settings();
+        out.appendf("Sticks: deadzone %.2f (axial %.2f, anti %.2f, outer %.2f) curve %.2f | Trigger >%d\r\n",
+                    conditioning.radialDeadzone, conditioning.axialDeadzone, conditioning.antiDeadzone,
+                    conditioning.outerDeadzone, conditioning.curve, conditioning.triggerThreshold);
+    }
+    if (slot.ds4Handle) {
+        // Report interval shows the controller's actual rate (4ms USB default, 1ms overclocked)
+        out.appendf("Report: %.2fms | Report->inject: %.0fus (max %.0fus)\r\n",
+                    slot.ds4ReportIntervalMs, slot.ds4ReportLatencyUs, slot.ds4MaxReportLatencyUs);
+    }
+    out.append("\r\n");
+
+    // Mode-specific status
+    if (currentMode == InputMode::Touch) {
+        out.append("TOUCH STATUS:\r\n");
+
+        // Add monitor information - use overlay's actual monitor for accuracy
+        if (sharedTopology.version() != pollTopologyVersion) {
+            pollTopologyVersion = sharedTopology.read(pollTopology);
+        }
+        if (pollTopology.currentIndex >= 0) {
+            const MonitorTopology::Monitor& overlayMon = pollTopology.monitors[pollTopology.currentIndex];
+            out.appendf("Monitor: %s\r\n", overlayMon.device);
+            out.appendf("  Size: %ldx%ld\r\n", overlayMon.width, overlayMon.height);
+            out.appendf("  Position: (%ld, %ld)\r\n", overlayMon.left, overlayMon.top);
+            out.appendf("  DPI: %d | %dHz\r\n", overlayMon.dpiX, overlayMon.refreshRate);
+            out.append(overlayMon.isPrimary ? "  (Primary Monitor)\r\n" : "  (Secondary Monitor)\r\n");
+        } else {
+            out.append("Monitor: Unknown\r\n");
+        }
+
+        // Show cursor position used for detection
+        POINT cursorPos;
+        if (GetCursorPos(&cursorPos)) {
+            out.append("Cursor:\r\n");
+            out.appendf("  Position: (%ld, %ld)\r\n", cursorPos.x, cursorPos.y);
+            out.append("  (Used for monitor detection)\r\n");
+        }
+        out.append("\r\n");
+
+        // Show all touches (0-19) - compact format
+        out.append("ALL TOUCHES STATUS:\r\n");
+
+        // Touch 0 (L1/L2 or L3 center) - always show all lines
+        bool touch0Active = slot.leftTouchActive || (slot.l3TouchActive && touchActive[0]);
+        out.appendf("  Touch 0 (L1/L2/L3): %s\r\n", touch0Active ? "ACTIVE" : "---");
+        if (touch0Active) {
+            // Use actual touch position if L3 is active, otherwise use L1/L2 position
+            if (slot.l3TouchActive && touchActive[0]) {
+                appendTouchScreenPos(out, -1, touchX[0], touchY[0]);
+            } else {
+                appendTouchScreenPos(out, -1, pollOverlay.rings[slot.index].leftX, pollOverlay.rings[slot.index].leftY);
+            }
+        } else {
+            out.append("    Screen: ---\r\n");
+        }
+        if (slot.currentLHeldDirection >= 0) out.appendf("    Held Dir: %d\r\n", slot.currentLHeldDirection);
+        else out.append("    Held Dir: ---\r\n");
+        if (slot.leftPointerLocked) out.appendf("    LOCKED: to %d\r\n", slot.leftLockedDirection);
+        else out.append("    LOCKED: ---\r\n");
+        out.appendf("    L3 Active: %s\r\n", slot.l3TouchActive ? "YES" : "---");
+
+        // Touch 1 (R1/R2 or R3 center) - always show all lines
+        bool touch1Active = slot.rightTouchActive || (slot.r3TouchActive && touchActive[1]);
+        out.appendf("  Touch 1 (R1/R2/R3): %s\r\n", touch1Active ? "ACTIVE" : "---");
+        if (touch1Active) {
+            // Use actual touch position if R3 is active, otherwise use R1/R2 position
+            if (slot.r3TouchActive && touchActive[1]) {
+                appendTouchScreenPos(out, -1, touchX[1], touchY[1]);
+            } else {
+                appendTouchScreenPos(out, -1, pollOverlay.rings[slot.index].rightX, pollOverlay.rings[slot.index].rightY);
+            }
+        } else {
+            out.append("    Screen: ---\r\n");
+        }
+        if (slot.currentRHeldDirection >= 0) out.appendf("    Held Dir: %d\r\n", slot.currentRHeldDirection);
+        else out.append("    Held Dir: ---\r\n");
+        if (slot.rightPointerLocked) out.appendf("    LOCKED: to %d\r\n", slot.rightLockedDirection);
+        else out.append("    LOCKED: ---\r\n");
+        out.appendf("    R3 Active: %s\r\n", slot.r3TouchActive ? "YES" : "---");
+
+        // Palm touches - always show line (first 5 listed)
+        appendPalmTouches(out, "  L3 palm (0+2-9): ", 0, 2, 9, slot.l3TouchActive);
+        appendPalmTouches(out, "  R3 palm (1+10-17): ", 1, 10, 17, slot.r3TouchActive);
+        out.append("\r\n");
+
+        // Stick positions
+        out.append("STICK POSITIONS:\r\n");
+        out.appendf("  Left:  X=%.2f Y=%.2f\r\n", pollOverlay.rings[slot.index].leftX, pollOverlay.rings[slot.index].leftY);
+        out.appendf("  Right: X=%.2f Y=%.2f\r\n", pollOverlay.rings[slot.index].rightX, pollOverlay.rings[slot.index].rightY);
+        out.append("\r\n");
+
+        // Current angles and directions
+        out.append("CURRENT DIRECTIONS:\r\n");
+        if (lAngle >= 0) out.appendf("  Left:  %.1f° (Dir %d)\r\n", lAngle, lDirection);
+        else out.append("  Left:  ---\r\n");
+        if (rAngle >= 0) out.appendf("  Right: %.1f° (Dir %d)\r\n", rAngle, rDirection);
+        else out.append("  Right: ---\r\n");
+        out.append("\r\n");
+
+    } else if (currentMode == InputMode::Mouse) {
+        out.append("MOUSE CONTROL:\r\n");
+        bool leftPressed = slot.prevL1;
+        bool rightPressed = slot.prevR1;
+        bool bothPressed = leftPressed && rightPressed;
+
+        // Get current mouse position
+        POINT mousePos = {};
+        GetCursorPos(&mousePos);
+        out.appendf("  Cursor: (%ld, %ld)\r\n", mousePos.x, mousePos.y);
+
+        if (bothPressed) {
+            out.append("  Mode: Alternating sticks\r\n");
+            out.appendf("  Current: %s\r\n", alternateFrame ? "Left" : "Right");
+        } else if (leftPressed) {
+            out.append("  Mode: Left stick\r\n");
+        } else if (rightPressed) {
+            out.append("  Mode: Right stick\r\n");
+        } else {
+            out.append("  Mode: Inactive\r\n");
+        }
+        out.append("\r\n");
+
+        // Stick positions
+        out.append("STICK POSITIONS:\r\n");
+        out.appendf("  Left:  X=%.2f Y=%.2f\r\n", pollOverlay.rings[slot.index].leftX, pollOverlay.rings[slot.index].leftY);
+        out.appendf("  Right: X=%.2f Y=%.2f\r\n", pollOverlay.rings[slot.index].rightX, pollOverlay.rings[slot.index].rightY);
+        out.append("\r\n");
+    } else if (currentMode == InputMode::Keyboard) {
+        out.appendf("KEYBOARD (%s):\r\n", layoutPath.empty() ? "1-8" : "layout file");
+        out.appendf("  L Stick Key: %s\r\n", currentLeftSector == -1 ? "---" : keyboardLayout.left[currentLeftSector].label);
+        out.appendf("  R Stick Key: %s\r\n", currentRightSector == -1 ? "---" : keyboardLayout.right[currentRightSector].label);
+        out.append("\r\n");
+
+        // Show stick details for keyboard mode
+        out.append("STICK POSITIONS:\r\n");
+        out.appendf("  Left:  X=%.2f Y=%.2f\r\n", pollOverlay.rings[slot.index].leftX, pollOverlay.rings[slot.index].leftY);
+        out.appendf("  Right: X=%.2f Y=%.2f\r\n", pollOverlay.rings[slot.index].rightX, pollOverlay.rings[slot.index].rightY);
+        out.append("\r\n");
+
+        out.append("ANGLES:\r\n");
+        if (lAngle >= 0) out.appendf("  Left:  %.1f°\r\n", lAngle);
+        else out.append("  Left:  ---\r\n");
+        if (rAngle >= 0) out.appendf("  Right: %.1f°\r\n", rAngle);
+        else out.append("  Right: ---\r\n");
+        out.append("\r\n");
+
+        out.append("DIRECTIONS:\r\n");
+        if (lDirection >= 0) out.appendf("  Left:  %d\r\n", lDirection + 1);
+        else out.append("  Left:  ---\r\n");
+        if (rDirection >= 0) out.appendf("  Right: %d\r\n", rDirection + 1);
+        else out.append("  Right: ---\r\n");
+        out.append("\r\n");
+    }
+
+    out.append("Ctrl+Shift+` = Debug/HUD/Off | Ctrl+Alt+Shift+` = Restart\r\n");
+
+    // Most refreshes format the same text (idle sticks, nothing held) - skip the
+    // hand-off and the repaint then
+    if (out.sameAs(publishedDebugText)) {
+        return;
+    }
+    publishedDebugText = out;
+
+    // Hand the debug info to the overlay thread for rendering
+    {
+        std::lock_guard<std::mutex> lock(debugTextMutex);
+        sharedDebugText.assign(out.text, out.length);  // Reuses the string's capacity
+        debugTextVersion.fetch_add(1, std::memory_order_release);
+    }
+}
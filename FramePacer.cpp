@@ -0,0 +1,103 @@
+#include "ControllerInput.h"
+
+// ========== Frame Pacer Implementation ==========
+
+FramePacer::FramePacer() : timer(nullptr), highResolution(false),
+                           periodTicks(0.0), nextDeadline(0.0), lastWakeTicks(0),
+                           lastPeriodMs(0.0), achievedPeriodMs(0.0) {
+    // High-resolution waitable timers (Windows 10 1803+) wake within ~0.5ms without
+    // raising the global timer resolution
+    timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (timer) {
+        highResolution = true;
+    } else {
+        // Older Windows - regular timer, finished off with a short spin in wait()
+        timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    setRate(60.0);
+}
+
+FramePacer::~FramePacer() {
+    if (timer) {
+        CloseHandle(timer);
+    }
+}
+
+void FramePacer::setRate(double hz) {
+    if (hz < 1.0) hz = 1.0;
+    periodTicks = (double)qpcFrequency() / hz;
+    // Keep the existing deadline so a rate change doesn't cause a hitch
+}
+
+void FramePacer::reset() {
+    nextDeadline = (double)qpcNow() + periodTicks;
+    lastWakeTicks = 0;
+}
+
+double FramePacer::getTargetPeriodMs() const {
+    return periodTicks * 1000.0 / (double)qpcFrequency();
+}
+
+void FramePacer::wait() {
+    waitOrEvents(nullptr, 0);
+}
+
+bool FramePacer::waitOrEvents(const HANDLE* events, int count) {
+    LONGLONG now = qpcNow();
+    if (nextDeadline == 0.0) {
+        nextDeadline = (double)now + periodTicks;
+    }
+    
+    while ((double)now < nextDeadline) {
+        double remainingTicks = nextDeadline - (double)now;
+        
+        // Without a high-resolution timer, sleep until ~1ms before the deadline and spin the rest
+        double spinTicks = highResolution ? 0.0 : (double)qpcFrequency() / 1000.0;
+        if (remainingTicks > spinTicks && timer) {
+            // Relative due time in 100ns units (negative = relative)
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = -(LONGLONG)((remainingTicks - spinTicks) * 10000000.0 / (double)qpcFrequency());
+            if (dueTime.QuadPart >= 0) dueTime.QuadPart = -1;
+            SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE);
+            
+            if (count > 0) {
+                HANDLE handles[1 + MAX_CONTROLLERS] = { timer };
+                for (int i = 0; i < count; i++) {
+                    handles[1 + i] = events[i];
+                }
+                DWORD result = WaitForMultipleObjects(1 + count, handles, FALSE, INFINITE);
+                if (result > WAIT_OBJECT_0 && result <= WAIT_OBJECT_0 + (DWORD)count) {
+                    // Woken by input - the deadline stays where it is
+                    CancelWaitableTimer(timer);
+                    return true;
+                }
+            } else {
+                WaitForSingleObject(timer, INFINITE);
+            }
+        } else {
+            if (count > 0 && WaitForMultipleObjects(count, events, FALSE, 0) < WAIT_OBJECT_0 + (DWORD)count) {
+                return true;
+            }
+            YieldProcessor();
+        }
+        now = qpcNow();
+    }
+    
+    // Advance on the absolute timeline so per-frame work never accumulates as drift.
+    // If we overran by whole periods, skip them instead of bursting to catch up.
+    nextDeadline += periodTicks;
+    if ((double)now >= nextDeadline) {
+        double missed = std::floor(((double)now - nextDeadline) / periodTicks) + 1.0;
+        nextDeadline += missed * periodTicks;
+    }
+    
+    // Measure the period we actually achieved (smoothed so the readout is stable)
+    if (lastWakeTicks != 0) {
+        double periodMs = (double)(now - lastWakeTicks) * 1000.0 / (double)qpcFrequency();
+        lastPeriodMs = periodMs;
+        double smoothed = achievedPeriodMs.load();
+        achievedPeriodMs = (smoothed == 0.0) ? periodMs : smoothed + (periodMs - smoothed) * 0.05;
+    }
+    lastWakeTicks = now;
+    return false;
+}
@@ -0,0 +1,461 @@
+#include "ControllerInput.h"
+
+// ========== GPU Overlay Implementation ==========
+// Direct2D draws the overlay into a premultiplied-alpha flip-model swap chain that
+// DirectComposition shows in the overlay window. Each frame is presented on vblank and
+// the overlay loop then waits on the swap chain's frame-latency object, so drawing
+// never tears and the CPU only spends a few draw calls per frame.
+// Draws the same paintSnapshot as the GDI renderers, with real per-element alpha.
+
+template <typename T>
+static void releaseCom(T*& object) {
+    if (object) {
+        object->Release();
+        object = nullptr;
+    }
+}
+
+bool ControllerMapper::initializeGpuOverlay(bool fromOverlayLoop) {
+    RECT client;
+    GetClientRect(overlayHwnd, &client);
+    gpuWidth = (client.right > 0) ? client.right : 1;
+    gpuHeight = (client.bottom > 0) ? client.bottom : 1;
+
+    // BGRA support is required for Direct2D interop; WARP if there is no usable GPU
+    UINT deviceFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+    HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, deviceFlags, nullptr, 0,
+                                   D3D11_SDK_VERSION, &gpuDevice, nullptr, nullptr);
+    if (FAILED(hr)) {
+        hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, deviceFlags, nullptr, 0,
+                               D3D11_SDK_VERSION, &gpuDevice, nullptr, nullptr);
+    }
+    if (FAILED(hr)) {
+        if (!fromOverlayLoop) {  // Retries after a device loss fail quietly
+            logError("GPU overlay: D3D11CreateDevice failed");
+        }
+        return false;
+    }
+
+    IDXGIDevice* dxgiDevice = nullptr;
+    IDXGIFactory2* dxgiFactory = nullptr;
+    IDXGISwapChain1* swapChain1 = nullptr;
+    ID2D1Device* d2dDevice = nullptr;
+    bool ok = false;
+
+    do {
+        if (FAILED(gpuDevice->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice))) break;
+        if (FAILED(CreateDXGIFactory2(0, __uuidof(IDXGIFactory2), (void**)&dxgiFactory))) break;
+
+        // Composition swap chain: flip model, premultiplied alpha, waitable
+        DXGI_SWAP_CHAIN_DESC1 desc = {};
+        desc.Width = gpuWidth;
+        desc.Height = gpuHeight;
+        desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        desc.BufferCount = 2;
+        desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+        desc.AlphaMode = DXGI_ALPHA_MODE_PREMULTIPLIED;
+        desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+        if (FAILED(dxgiFactory->CreateSwapChainForComposition(gpuDevice, &desc, nullptr, &swapChain1))) break;
+        if (FAILED(swapChain1->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&gpuSwapChain))) break;
+
+        // One queued frame - what's on screen is never more than a refresh behind the snapshot
+        gpuSwapChain->SetMaximumFrameLatency(1);
+        gpuFrameWaitable = gpuSwapChain->GetFrameLatencyWaitableObject();
+        if (gpuFrameWaitable) {
+            // Consume the initial count so every later wait lines up with a presented frame
+            WaitForSingleObjectEx(gpuFrameWaitable, 1000, TRUE);
+        }
+
+        // Show the swap chain in the overlay window
+        if (FAILED(DCompositionCreateDevice(dxgiDevice, __uuidof(IDCompositionDevice), (void**)&dcompDevice))) break;
+        if (FAILED(dcompDevice->CreateTargetForHwnd(overlayHwnd, TRUE, &dcompTarget))) break;
+        if (FAILED(dcompDevice->CreateVisual(&dcompVisual))) break;
+        if (FAILED(dcompVisual->SetContent(gpuSwapChain))) break;
+        if (FAILED(dcompTarget->SetRoot(dcompVisual))) break;
+        if (FAILED(dcompDevice->Commit())) break;
+
+        // Direct2D context drawing straight into the swap chain's back buffer
+        D2D1_FACTORY_OPTIONS factoryOptions = {};
+        if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, __uuidof(ID2D1Factory1),
+                                     &factoryOptions, (void**)&d2dFactory))) break;
+        if (FAILED(d2dFactory->CreateDevice(dxgiDevice, &d2dDevice))) break;
+        if (FAILED(d2dDevice->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &d2dContext))) break;
+        d2dContext->SetDpi(96.0f, 96.0f);  // 1 DIP = 1 pixel, same coordinates as the GDI path
+
+        if (FAILED(d2dContext->CreateSolidColorBrush(D2D1::ColorF(1.0f, 1.0f, 1.0f, 1.0f), &d2dBrush))) break;
+        if (!resizeGpuOverlay(gpuWidth, gpuHeight)) break;
+
+        // Debug panel and touch ID labels
+        if (FAILED(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), (IUnknown**)&dwriteFactory))) break;
+        if (FAILED(dwriteFactory->CreateTextFormat(L"Consolas", nullptr, DWRITE_FONT_WEIGHT_BOLD, DWRITE_FONT_STYLE_NORMAL,
+                                                   DWRITE_FONT_STRETCH_NORMAL, 20.0f, L"", &debugTextFormat))) break;
+        debugTextFormat->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP);
+        debugTextFormat->SetLineSpacing(DWRITE_LINE_SPACING_METHOD_UNIFORM, (float)DEBUG_TEXT_LINE_HEIGHT, 19.0f);
+        if (FAILED(dwriteFactory->CreateTextFormat(L"Consolas", nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL,
+                                                   DWRITE_FONT_STRETCH_NORMAL, 14.0f, L"", &touchIdTextFormat))) break;
+        touchIdTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+        touchIdTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+
+        ok = true;
+    } while (false);
+
+    releaseCom(d2dDevice);
+    releaseCom(swapChain1);
+    releaseCom(dxgiFactory);
+    releaseCom(dxgiDevice);
+
+    if (!ok) {
+        if (!fromOverlayLoop) {
+            logError("GPU overlay: Direct2D/DirectComposition setup failed");
+        }
+        releaseGpuOverlay();
+        return false;
+    }
+
+    if (!fromOverlayLoop) {
+        std::cout << "GPU overlay: " << gpuWidth << "x" << gpuHeight << " composition swap chain, vblank-paced" << std::endl;
+    } else {
+        MAPPER_LOG(asyncLog.overlay, LogLevel::Info, "GPU overlay: %dx%d composition swap chain recreated", gpuWidth, gpuHeight);
+    }
+    return true;
+}
+
+void ControllerMapper::releaseGpuOverlay() {
+    if (d2dContext) {
+        d2dContext->SetTarget(nullptr);
+    }
+    for (ID2D1PathGeometry*& arc : gpuArcs) {
+        releaseCom(arc);
+    }
+    gpuArcRadius = 0;
+    releaseCom(touchIdTextFormat);
+    releaseCom(debugTextFormat);
+    releaseCom(dwriteFactory);
+    releaseCom(d2dBrush);
+    releaseCom(d2dTarget);
+    releaseCom(d2dContext);
+    releaseCom(d2dFactory);
+    releaseCom(dcompVisual);
+    releaseCom(dcompTarget);
+    releaseCom(dcompDevice);
+    if (gpuFrameWaitable) {
+        CloseHandle(gpuFrameWaitable);
+        gpuFrameWaitable = nullptr;
+    }
+    releaseCom(gpuSwapChain);
+    releaseCom(gpuDevice);
+    gpuFramePresented = false;
+}
+
+bool ControllerMapper::resizeGpuOverlay(int width, int height) {
+    // The swap chain can't resize while Direct2D still references its buffer
+    d2dContext->SetTarget(nullptr);
+    releaseCom(d2dTarget);
+
+    if (width != gpuWidth || height != gpuHeight) {
+        if (FAILED(gpuSwapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN,
+                                               DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT))) {
+            return false;
+        }
+        gpuWidth = width;
+        gpuHeight = height;
+    }
+
+    // Flip model: buffer 0 is always the current back buffer, so one bitmap serves every frame
+    IDXGISurface* surface = nullptr;
+    if (FAILED(gpuSwapChain->GetBuffer(0, __uuidof(IDXGISurface), (void**)&surface))) {
+        return false;
+    }
+    D2D1_BITMAP_PROPERTIES1 properties = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED), 96.0f, 96.0f);
+    HRESULT hr = d2dContext->CreateBitmapFromDxgiSurface(surface, &properties, &d2dTarget);
+    surface->Release();
+    if (FAILED(hr)) {
+        return false;
+    }
+    d2dContext->SetTarget(d2dTarget);
+    return true;
+}
+
+void ControllerMapper::rebuildGpuArcs(int centerX, int centerY) {
+    // Same 45-degree spans drawDirectionIndicator() passes to GDI Arc(), built once
+    // per overlay size instead of every frame
+    for (int dir = 0; dir < DIRECTION_SECTORS; dir++) {
+        releaseCom(gpuArcs[dir]);
+
+        int nextDir = (dir + 1) % DIRECTION_SECTORS;
+        D2D1_POINT_2F start = D2D1::Point2F((float)(centerX + DIRECTION_BOUNDARY_X[dir] * overlayStickRadius),
+                                            (float)(centerY - DIRECTION_BOUNDARY_Y[dir] * overlayStickRadius));
+        D2D1_POINT_2F end = D2D1::Point2F((float)(centerX + DIRECTION_BOUNDARY_X[nextDir] * overlayStickRadius),
+                                          (float)(centerY - DIRECTION_BOUNDARY_Y[nextDir] * overlayStickRadius));
+
+        ID2D1GeometrySink* sink = nullptr;
+        if (FAILED(d2dFactory->CreatePathGeometry(&gpuArcs[dir])) || FAILED(gpuArcs[dir]->Open(&sink))) {
+            releaseCom(gpuArcs[dir]);
+            continue;
+        }
+        sink->BeginFigure(start, D2D1_FIGURE_BEGIN_HOLLOW);
+        sink->AddArc(D2D1::ArcSegment(end, D2D1::SizeF((float)overlayStickRadius, (float)overlayStickRadius),
+                                      0.0f, D2D1_SWEEP_DIRECTION_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+        sink->EndFigure(D2D1_FIGURE_END_OPEN);
+        sink->Close();
+        sink->Release();
+    }
+    gpuArcRadius = overlayStickRadius;
+    gpuArcCenterX = centerX;
+    gpuArcCenterY = centerY;
+}
+
+void ControllerMapper::setGpuBrush(COLORREF color, int alpha) {
+    d2dBrush->SetColor(D2D1::ColorF(GetRValue(color) / 255.0f, GetGValue(color) / 255.0f,
+                                    GetBValue(color) / 255.0f, alpha / 255.0f));
+}
+
+void ControllerMapper::drawGpuTouchCircle(float x, float y, float radius, int touchId, COLORREF color) {
+    D2D1_ELLIPSE circle = D2D1::Ellipse(D2D1::Point2F(x, y), radius, radius);
+    setGpuBrush(color, 255);
+    d2dContext->FillEllipse(circle, d2dBrush);
+    setGpuBrush(RGB(255, 255, 255), 255);
+    d2dContext->DrawEllipse(circle, d2dBrush, 2.0f);
+
+    // Touch ID number only when debug overlay is shown
+    if (showDebugInfo) {
+        wchar_t idStr[4];
+        int length = swprintf_s(idStr, L"%d", touchId);
+        d2dContext->DrawText(idStr, length, touchIdTextFormat,
+                             D2D1::RectF(x - 12.0f, y - 10.0f, x + 12.0f, y + 10.0f), d2dBrush);
+    }
+}
+
+void ControllerMapper::renderGpuOverlay() {
+    if (!d2dContext) return;
+    LONGLONG paintStart = qpcNow();
+    const OverlaySnapshot& snapshot = paintSnapshot;
+    paintingSampleTicks = snapshot.sampleTicks;
+
+    RECT rect;
+    GetClientRect(overlayHwnd, &rect);
+    if (rect.right <= 0 || rect.bottom <= 0) return;
+    if ((rect.right != gpuWidth || rect.bottom != gpuHeight || !d2dTarget) && !resizeGpuOverlay(rect.right, rect.bottom)) {
+        MAPPER_LOG(asyncLog.overlay, LogLevel::Error, "GPU overlay: swap chain resize failed");
+        return;
+    }
+
+    // Arcs are built around the first ring and translated to the others
+    int centerX, centerY;
+    getRingCenter(0, snapshot.ringCount, rect, centerX, centerY);
+    if (gpuArcRadius != overlayStickRadius || gpuArcCenterX != centerX || gpuArcCenterY != centerY) {
+        rebuildGpuArcs(centerX, centerY);
+    }
+
+    d2dContext->BeginDraw();
+    d2dContext->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+
+    for (int ring = 0; ring < snapshot.ringCount; ring++) {
+        getRingCenter(ring, snapshot.ringCount, rect, centerX, centerY);
+        renderGpuRing(snapshot.rings[ring], (float)centerX, (float)centerY);
+    }
+
+    // Debug panel - same position as the GDI text
+    if (showDebugInfo && !paintDebugText.empty()) {
+        const DebugTextBuffer& text = formatPaintDebugText();
+        RECT textRect = getDebugTextRect(rect, text.text, text.length, 0, 0);
+        int length = MultiByteToWideChar(CP_ACP, 0, text.text, text.length, nullptr, 0);
+        gpuTextBuffer.resize(length);  // Keeps its capacity - only grows for a longer panel
+        MultiByteToWideChar(CP_ACP, 0, text.text, text.length, &gpuTextBuffer[0], length);
+        setGpuBrush(RGB(255, 255, 255), 255);
+        d2dContext->DrawText(gpuTextBuffer.c_str(), (UINT32)gpuTextBuffer.size(), debugTextFormat,
+                             D2D1::RectF((float)textRect.left, (float)textRect.top,
+                                         (float)rect.right, (float)textRect.bottom + DEBUG_TEXT_LINE_HEIGHT), d2dBrush);
+    }
+    if (showPerfHud) {
+        renderGpuPerfHud(rect);
+    }
+
+    HRESULT hr = d2dContext->EndDraw();
+    if (SUCCEEDED(hr)) {
+        hr = gpuSwapChain->Present(1, 0);  // Flip on the next vblank
+    }
+
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET || hr == D2DERR_RECREATE_TARGET) {
+        // Driver update, TDR or adapter change - start over with a new device
+        MAPPER_LOG(asyncLog.overlay, LogLevel::Error, "GPU overlay: device lost, recreating");
+        releaseGpuOverlay();
+        recoverGpuOverlay();
+        return;
+    }
+    gpuFramePresented = SUCCEEDED(hr);
+    recordPaintLatency(paintStart);
+}
+
+void ControllerMapper::recoverGpuOverlay() {
+    // Called right after the device was lost, then once per overlay frame from run()
+    // while the driver is still resetting
+    if (initializeGpuOverlay(true)) {
+        gpuRecoveryAttempts = 0;
+        gpuFrameDirty = true;  // Nothing is on the new swap chain until the next full redraw
+        return;
+    }
+    if (++gpuRecoveryAttempts < GPU_RECOVERY_ATTEMPTS) {
+        return;
+    }
+
+    // The GPU didn't come back - same fallback as at startup, the window has no
+    // redirection bitmap for GDI to draw into
+    MAPPER_LOG(asyncLog.overlay, LogLevel::Error, "GPU overlay unavailable - falling back to per-pixel alpha overlay");
+    gpuRecoveryAttempts = 0;
+    overlayDirtyRectCount = 0;
+    DestroyWindow(overlayHwnd);
+    overlayHwnd = nullptr;
+    overlayBackend = OverlayBackend::LayeredAlpha;
+    createOverlay(true);
+}
+
+void ControllerMapper::renderGpuRing(const RingSnapshot& ring, float centerX, float centerY) {
+    float indicatorRange = (float)(overlayStickRadius - OVERLAY_STICK_INDICATOR_RADIUS);
+
+    // Boundary circle
+    int maxAlpha = (ring.leftAlpha > ring.rightAlpha) ? ring.leftAlpha : ring.rightAlpha;
+    if (maxAlpha > 10) {
+        setGpuBrush(RGB(200, 200, 200), maxAlpha);
+        d2dContext->DrawEllipse(D2D1::Ellipse(D2D1::Point2F(centerX, centerY),
+                                              (float)overlayStickRadius, (float)overlayStickRadius),
+                                d2dBrush, (float)(1 + (maxAlpha * 3 / 255)));
+    }
+
+    // Direction arcs - same selection, colors and widths as drawDirectionIndicator()
+    struct ArcRequest {
+        int direction;
+        COLORREF color;
+        int alpha;
+        int thickness;
+    };
+    ArcRequest arcs[2];
+    int arcCount = 0;
+    int leftDirection = ring.leftDirection;
+    int rightDirection = ring.rightDirection;
+    bool leftStickMoved = ring.leftStickMoved;
+    bool rightStickMoved = ring.rightStickMoved;
+    if (leftStickMoved && rightStickMoved && leftDirection == rightDirection && leftDirection >= 0) {
+        int thickness = (ring.leftTouchActive || ring.rightTouchActive) ? -1 : (1 + (maxAlpha * 5 / 255));
+        arcs[arcCount++] = { leftDirection, RGB(255, 255, 0), maxAlpha, thickness };
+    } else {
+        if (leftStickMoved && leftDirection >= 0) {
+            int thickness = ring.leftTouchActive ? -1 : (1 + (ring.leftAlpha * 5 / 255));
+            arcs[arcCount++] = { leftDirection, RGB(100, 150, 255), ring.leftAlpha, thickness };
+        }
+        if (rightStickMoved && rightDirection >= 0) {
+            int thickness = ring.rightTouchActive ? -1 : (1 + (ring.rightAlpha * 5 / 255));
+            arcs[arcCount++] = { rightDirection, RGB(255, 100, 150), ring.rightAlpha, thickness };
+        }
+    }
+    d2dContext->SetTransform(D2D1::Matrix3x2F::Translation(centerX - gpuArcCenterX, centerY - gpuArcCenterY));
+    for (int i = 0; i < arcCount; i++) {
+        const ArcRequest& arc = arcs[i];
+        if (arc.alpha < 10) continue;
+        for (int offset = -1; offset <= 1; offset++) {
+            int dir = (arc.direction + offset + DIRECTION_SECTORS) % DIRECTION_SECTORS;
+            if (!gpuArcs[dir]) continue;
+            int dirAlpha = (offset == 0) ? arc.alpha : 1;  // Adjacent directions almost invisible
+            float width = (offset != 0) ? 1.0f :
+                          (arc.thickness == -1) ? (float)(2 + (dirAlpha * 8 / 255)) : (float)arc.thickness;
+            setGpuBrush(arc.color, dirAlpha);
+            d2dContext->DrawGeometry(gpuArcs[dir], d2dBrush, width);
+        }
+    }
+    d2dContext->SetTransform(D2D1::Matrix3x2F::Identity());
+
+    // Stick indicators (hollow) and locked pointers (solid)
+    struct StickMarker {
+        double x, y;
+        COLORREF color;
+        int alpha;
+        bool locked;
+    };
+    const StickMarker markers[4] = {
+        { ring.leftX, ring.leftY, RGB(100, 150, 255), ring.leftAlpha, false },
+        { ring.rightX, ring.rightY, RGB(255, 100, 150), ring.rightAlpha, false },
+        { ring.leftLockedX, ring.leftLockedY, RGB(50, 100, 200), ring.leftLockedAlpha, true },
+        { ring.rightLockedX, ring.rightLockedY, RGB(200, 50, 100), ring.rightLockedAlpha, true },
+    };
+    for (const StickMarker& marker : markers) {
+        if (marker.alpha == 0 || (!marker.locked && marker.alpha < 10)) continue;
+        D2D1_POINT_2F position = D2D1::Point2F(centerX + (float)marker.x * indicatorRange,
+                                               centerY - (float)marker.y * indicatorRange);
+        setGpuBrush(marker.color, marker.alpha);
+        if (marker.locked) {
+            d2dContext->FillEllipse(D2D1::Ellipse(position, (float)OVERLAY_LOCKED_INDICATOR_RADIUS,
+                                                  (float)OVERLAY_LOCKED_INDICATOR_RADIUS), d2dBrush);
+        } else {
+            d2dContext->DrawEllipse(D2D1::Ellipse(position, (float)OVERLAY_STICK_INDICATOR_RADIUS,
+                                                  (float)OVERLAY_STICK_INDICATOR_RADIUS),
+                                    d2dBrush, (float)(1 + (marker.alpha * 5 / 255)));
+        }
+    }
+
+    // L3/R3 palm contacts (center + 8 around), then touches 0-1 and the palm centroids
+    const COLORREF palmColors[2] = { RGB(50, 200, 150), RGB(200, 50, 150) };
+    const int palmAlphas[2] = { ring.l3Alpha, ring.r3Alpha };
+    const bool palmCenterActive[2] = { ring.l3TouchActive, ring.r3TouchActive };
+    for (int palm = 0; palm < 2; palm++) {
+        if (palmAlphas[palm] == 0) continue;
+        int cornerStartId = (palm == 0) ? 2 : 10;
+        for (int i = -1; i < 8; i++) {
+            int touchId = (i < 0) ? palm : cornerStartId + i;
+            if (!ring.touchActive[touchId]) continue;
+            drawGpuTouchCircle(centerX + (float)ring.touchX[touchId] * indicatorRange,
+                               centerY - (float)ring.touchY[touchId] * indicatorRange,
+                               (float)OVERLAY_LOCKED_INDICATOR_RADIUS, ring.touchIdBase + touchId, palmColors[palm]);
+        }
+    }
+
+    const COLORREF touchColors[2] = { RGB(100, 150, 255), RGB(255, 100, 150) };
+    for (int i = 0; i < 2; i++) {
+        if (ring.touchActive[i]) {
+            drawGpuTouchCircle(centerX + (float)ring.touchX[i] * indicatorRange,
+                               centerY - (float)ring.touchY[i] * indicatorRange, 8.0f, ring.touchIdBase + i, touchColors[i]);
+        }
+    }
+
+    for (int palm = 0; palm < 2; palm++) {
+        double sumX = 0.0, sumY = 0.0;
+        int count = 0;
+        int cornerStartId = (palm == 0) ? 2 : 10;
+        if (palmCenterActive[palm] && ring.touchActive[palm]) {
+            sumX += ring.touchX[palm];
+            sumY += ring.touchY[palm];
+            count++;
+        }
+        for (int i = cornerStartId; i < cornerStartId + 8; i++) {
+            if (ring.touchActive[i]) {
+                sumX += ring.touchX[i];
+                sumY += ring.touchY[i];
+                count++;
+            }
+        }
+        if (count == 0) continue;
+        D2D1_ELLIPSE centroid = D2D1::Ellipse(D2D1::Point2F(centerX + (float)(sumX / count) * indicatorRange,
+                                                            centerY - (float)(sumY / count) * indicatorRange), 10.0f, 10.0f);
+        setGpuBrush(palmColors[palm], 255);
+        d2dContext->FillEllipse(centroid, d2dBrush);
+        setGpuBrush(RGB(255, 255, 255), 255);
+        d2dContext->DrawEllipse(centroid, d2dBrush, 2.0f);
+    }
+}
+
+void ControllerMapper::waitForOverlayFrame() {
+    if (gpuFramePresented) {
+        // Returns at the vblank that retires the frame just presented
+        gpuFramePresented = false;
+        if (!gpuFrameWaitable || WaitForSingleObjectEx(gpuFrameWaitable, 100, TRUE) != WAIT_OBJECT_0) {
+            DwmFlush();
+        }
+        return;
+    }
+    
+    // Nothing presented (or a GDI backend) - pace to the refresh rate
+    overlayPacer.wait();
+}
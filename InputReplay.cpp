@@ -0,0 +1,171 @@
+#include "ControllerInput.h"
+#include <cstdio>
+
+// ========== Input Recording & Replay Implementation ==========
+// --record keeps every processed sample in a buffer reserved at startup and writes
+// them out on shutdown, so recording never touches the disk or the allocator from
+// the polling thread. --replay feeds a
+// recording back through processSample() on the polling thread at the recorded
+// timing (or as fast as possible) with injection turned into a no-op.
+
+static const char RECORDING_MAGIC[4] = { 'C', 'I', 'M', 'R' };
+static const uint16_t RECORDING_VERSION = 1;
+
+void ControllerMapper::recordSample(int controllerIndex, const ControllerSample& sample) {
+    // The buffer is reserved at startup - never grow it on the polling thread
+    if (recordedSamples.size() >= MAX_RECORDED_SAMPLES) {
+        return;
+    }
+    if (recordedSamples.empty()) {
+        recordStartTicks = sample.timestamp;
+    }
+
+    RecordedSample record;
+    record.timeUs = (uint64_t)((sample.timestamp - recordStartTicks) * 1000000 / qpcFrequency());
+    record.leftX = (float)sample.leftX;
+    record.leftY = (float)sample.leftY;
+    record.rightX = (float)sample.rightX;
+    record.rightY = (float)sample.rightY;
+    record.buttons = (uint8_t)((sample.l1 ? 0x01 : 0) | (sample.r1 ? 0x02 : 0) | (sample.l2 ? 0x04 : 0) |
+                               (sample.r2 ? 0x08 : 0) | (sample.l3 ? 0x10 : 0) | (sample.r3 ? 0x20 : 0) |
+                               (controllerIndex << 6));
+    recordedSamples.push_back(record);
+    if (recordedSamples.size() == MAX_RECORDED_SAMPLES) {
+        MAPPER_LOG(asyncLog.poll, LogLevel::Warning, "Recording buffer full after %u samples - the rest of the session is not recorded",
+                   (unsigned)MAX_RECORDED_SAMPLES);
+    }
+}
+
+int ControllerMapper::sampleFromRecorded(const RecordedSample& record, ControllerSample& sample) {
+    sample.leftX = record.leftX;
+    sample.leftY = record.leftY;
+    sample.rightX = record.rightX;
+    sample.rightY = record.rightY;
+    sample.l1 = (record.buttons & 0x01) != 0;
+    sample.r1 = (record.buttons & 0x02) != 0;
+    sample.l2 = (record.buttons & 0x04) != 0;
+    sample.r2 = (record.buttons & 0x08) != 0;
+    sample.l3 = (record.buttons & 0x10) != 0;
+    sample.r3 = (record.buttons & 0x20) != 0;
+    return record.buttons >> 6;  // Single-controller recordings are all controller 0
+}
+
+bool ControllerMapper::saveRecording() {
+    if (recordPath.empty() || recordedSamples.empty()) {
+        return true;
+    }
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, recordPath.c_str(), "wb") != 0 || !file) {
+        logError("Failed to create recording: " + recordPath);
+        return false;
+    }
+
+    RecordingHeader header = {};
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.mode = (uint8_t)currentMode;
+    header.sampleCount = (uint32_t)recordedSamples.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(recordedSamples.data(), sizeof(RecordedSample), recordedSamples.size(), file) == recordedSamples.size();
+    fclose(file);
+
+    if (!ok) {
+        logError("Failed to write recording: " + recordPath);
+        return false;
+    }
+    logInfo("Recorded " + std::to_string(recordedSamples.size()) + " samples to " + recordPath +
+            (recordedSamples.size() >= MAX_RECORDED_SAMPLES ? " (buffer full - session truncated)" : ""));
+    recordedSamples.clear();
+    return true;
+}
+
+bool ControllerMapper::loadRecording() {
+    FILE* file = nullptr;
+    if (fopen_s(&file, replayPath.c_str(), "rb") != 0 || !file) {
+        logError("Failed to open recording: " + replayPath);
+        return false;
+    }
+
+    RecordingHeader header = {};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == RECORDING_VERSION &&
+              header.mode <= (uint8_t)InputMode::Keyboard;
+    if (ok) {
+        replaySamples.resize(header.sampleCount);
+        ok = fread(replaySamples.data(), sizeof(RecordedSample), header.sampleCount, file) == header.sampleCount;
+    }
+    fclose(file);
+
+    if (!ok || replaySamples.empty()) {
+        logError("Not a valid recording: " + replayPath);
+        replaySamples.clear();
+        return false;
+    }
+
+    // Replay in the mode and with the controllers the session was recorded with
+    currentMode = (InputMode)header.mode;
+    controllerCount = 1;
+    for (const RecordedSample& record : replaySamples) {
+        int controllerIndex = record.buttons >> 6;
+        if (controllerIndex >= controllerCount) {
+            controllerCount = controllerIndex + 1;
+        }
+    }
+    return true;
+}
+
+bool ControllerMapper::initializeReplay() {
+    if (!loadRecording()) {
+        return false;
+    }
+    const char* modeNames[] = { "touch", "mouse", "keyboard" };
+    std::cout << "Replaying " << replaySamples.size() << " samples (" << modeNames[(int)currentMode] << " mode, "
+              << controllerCount << (controllerCount == 1 ? " controller, " : " controllers, ")
+              << (replayFullSpeed ? "full speed" : "recorded timing") << "), injection disabled" << std::endl;
+
+    // Same overlay and touch mapping setup as a live controller
+    detectMonitorFromCursor(true);
+    createOverlay();
+    return true;
+}
+
+void ControllerMapper::replayRecording() {
+    LONGLONG frequency = qpcFrequency();
+    LONGLONG start = qpcNow();
+    LONGLONG handlerTicks = 0;
+    size_t replayed = 0;
+
+    for (const RecordedSample& record : replaySamples) {
+        if (!pollThreadRunning) break;
+
+        if (!replayFullSpeed) {
+            // Sleep most of the gap, spin the last stretch - same split as FramePacer's fallback
+            LONGLONG due = start + (LONGLONG)(record.timeUs * frequency / 1000000);
+            for (LONGLONG now = qpcNow(); now < due; now = qpcNow()) {
+                if ((due - now) * 1000 / frequency >= 2) {
+                    Sleep(1);
+                } else {
+                    YieldProcessor();
+                }
+            }
+        }
+
+        ControllerSample sample = {};
+        int controllerIndex = sampleFromRecorded(record, sample);
+        sample.timestamp = qpcNow();
+        processSample(controllers[controllerIndex], sample);
+        handlerTicks += qpcNow() - sample.timestamp;
+        replayed++;
+    }
+
+    double elapsedMs = (qpcNow() - start) * 1000.0 / frequency;
+    double perSampleUs = replayed ? handlerTicks * 1000000.0 / frequency / replayed : 0.0;
+    char summary[160];
+    sprintf_s(summary, "Replay finished: %zu samples in %.1fms, %.2fus per sample (%.0f samples/s)",
+              replayed, elapsedMs, perSampleUs, elapsedMs > 0.0 ? replayed * 1000.0 / elapsedMs : 0.0);
+    logInfo(summary);
+    replayFinished = true;
+}
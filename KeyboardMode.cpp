@@ -1,95 +1,209 @@
 #include "ControllerInput.h"
+#include <cstdio>
+#include <cctype>
 
 // ========== Keyboard Mode Implementation ==========
 
-int ControllerMapper::getKeyCode(const std::string& key) {
-    if (key == "1") return '1';
-    if (key == "2") return '2';
-    if (key == "3") return '3';
-    if (key == "4") return '4';
-    if (key == "5") return '5';
-    if (key == "6") return '6';
-    if (key == "7") return '7';
-    if (key == "8") return '8';
-    return 0;
+// ========== Layout Compilation ==========
+// A layout file names what each sector presses, one per line:
+//     <left|right> <sector 1-8> <action>
+// Sectors count clockwise from straight up, the same as the default number keys.
+// Everything is resolved here, once - the input path only indexes the table.
+
+struct NamedKey {
+    const char* name;
+    WORD virtualKey;
+};
+
+static const NamedKey NAMED_KEYS[] = {
+    { "SPACE", VK_SPACE }, { "ENTER", VK_RETURN }, { "TAB", VK_TAB }, { "ESC", VK_ESCAPE },
+    { "BACKSPACE", VK_BACK }, { "SHIFT", VK_SHIFT }, { "CTRL", VK_CONTROL }, { "ALT", VK_MENU },
+    { "UP", VK_UP }, { "DOWN", VK_DOWN }, { "LEFT", VK_LEFT }, { "RIGHT", VK_RIGHT },
+};
+
+SectorLayout ControllerMapper::defaultSectorLayout() {
+    // Number keys 1-8 on both sticks
+    SectorLayout layout;
+    for (int i = 0; i < DIRECTION_SECTORS; i++) {
+        std::string key(1, (char)('1' + i));
+        parseSectorAction(key, layout.left[i]);
+        parseSectorAction(key, layout.right[i]);
+    }
+    return layout;
 }
 
-void ControllerMapper::simulateKeyPress(int keyCode, bool isDown) {
-    INPUT input = {};
-    input.type = INPUT_KEYBOARD;
-    input.ki.wVk = keyCode;
-    input.ki.dwFlags = isDown ? 0 : KEYEVENTF_KEYUP;
-    input.ki.wScan = MapVirtualKey(keyCode, MAPVK_VK_TO_VSC);
-    input.ki.dwExtraInfo = GetMessageExtraInfo();
-    SendInput(1, &input, sizeof(INPUT));
+bool ControllerMapper::parseSectorAction(const std::string& name, SectorAction& action) {
+    std::string upper = name;
+    for (char& c : upper) c = (char)toupper((unsigned char)c);
+
+    action = SectorAction();
+    strncpy_s(action.label, upper.c_str(), _TRUNCATE);
+
+    if (upper == "NONE") {
+        return true;
+    }
+    if (upper == "MOUSE-LEFT" || upper == "MOUSE-RIGHT" || upper == "MOUSE-MIDDLE") {
+        action.type = SectorActionType::MouseButton;
+        if (upper == "MOUSE-LEFT") {
+            action.virtualKey = VK_LBUTTON;
+            action.downFlags = MOUSEEVENTF_LEFTDOWN;
+            action.upFlags = MOUSEEVENTF_LEFTUP;
+        } else if (upper == "MOUSE-RIGHT") {
+            action.virtualKey = VK_RBUTTON;
+            action.downFlags = MOUSEEVENTF_RIGHTDOWN;
+            action.upFlags = MOUSEEVENTF_RIGHTUP;
+        } else {
+            action.virtualKey = VK_MBUTTON;
+            action.downFlags = MOUSEEVENTF_MIDDLEDOWN;
+            action.upFlags = MOUSEEVENTF_MIDDLEUP;
+        }
+        return true;
+    }
+
+    WORD virtualKey = 0;
+    if (upper.size() == 1 && isalnum((unsigned char)upper[0])) {
+        virtualKey = (WORD)upper[0];  // '0'-'9' and 'A'-'Z' are their own VK codes
+    } else if (upper.size() >= 2 && upper[0] == 'F' && isdigit((unsigned char)upper[1])) {
+        int n = atoi(upper.c_str() + 1);
+        if (n >= 1 && n <= 12) virtualKey = (WORD)(VK_F1 + n - 1);
+    } else {
+        for (const NamedKey& key : NAMED_KEYS) {
+            if (upper == key.name) virtualKey = key.virtualKey;
+        }
+    }
+    if (virtualKey == 0) {
+        return false;
+    }
+    action.type = SectorActionType::Key;
+    action.virtualKey = virtualKey;
+    action.scanCode = (WORD)MapVirtualKey(virtualKey, MAPVK_VK_TO_VSC);
+    return true;
+}
+
+bool ControllerMapper::compileSectorLayout(const std::string& path, SectorLayout& layout) {
+    FILE* file = nullptr;
+    if (fopen_s(&file, path.c_str(), "r") != 0 || !file) {
+        logError("Failed to open layout: " + path);
+        return false;
+    }
+
+    // Sectors the file doesn't mention keep their default key
+    SectorLayout compiled = defaultSectorLayout();
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char side[16] = {}, action[32] = {};
+        int sector = 0;
+        int fields = sscanf_s(line, "%15s %d %31s", side, (unsigned)sizeof(side), &sector,
+                              action, (unsigned)sizeof(action));
+        if (fields <= 0) continue;  // Blank or comment-only line
+
+        std::string sideName = side;
+        SectorAction* row = (sideName == "left") ? compiled.left : (sideName == "right") ? compiled.right : nullptr;
+        ok = fields == 3 && row && sector >= 1 && sector <= DIRECTION_SECTORS &&
+             parseSectorAction(action, row[sector - 1]);
+        if (!ok) {
+            logError("Invalid layout line " + std::to_string(lineNumber) + " in " + path);
+        }
+    }
+    fclose(file);
+
+    if (ok) {
+        layout = compiled;
+        logInfo("Keyboard layout loaded from " + path);
+    }
+    return ok;
+}
+
+// ========== Sector Actions ==========
+
+bool ControllerMapper::sameSectorAction(const SectorAction& a, const SectorAction& b) {
+    return a.type == b.type && a.virtualKey == b.virtualKey;
 }
 
-void ControllerMapper::sendKeyPress(const std::string& key, bool isDown) {
-    int keyCode = getKeyCode(key);
-    if (keyCode == 0) return;
-    simulateKeyPress(keyCode, isDown);
+void ControllerMapper::sendSectorAction(const SectorAction& action, bool isDown) {
+    // Queued - the whole sample's key changes go out in one SendInput (flushInputFrame)
+    INPUT input = {};
+    switch (action.type) {
+        case SectorActionType::Key:
+            input.type = INPUT_KEYBOARD;
+            input.ki.wVk = action.virtualKey;
+            input.ki.wScan = action.scanCode;
+            input.ki.dwFlags = isDown ? 0 : KEYEVENTF_KEYUP;
+            break;
+        case SectorActionType::MouseButton:
+            input.type = INPUT_MOUSE;
+            input.mi.dwFlags = isDown ? action.downFlags : action.upFlags;
+            break;
+        case SectorActionType::None:
+            return;
+    }
+    queueInput(input);
 }
 
-void ControllerMapper::handleKeyboardControl(bool l1, bool r1, double leftX, double leftY, double rightX, double rightY) {
-    // Calculate angles and directions
-    double lAngle = calculateAngle(leftX, leftY);
-    double rAngle = calculateAngle(rightX, rightY);
-    int lDirection = getDirection(lAngle);
-    int rDirection = getDirection(rAngle);
-    
+void ControllerMapper::handleKeyboardControl(ControllerSlot& slot, bool l1, bool r1, double leftX, double leftY, double rightX, double rightY) {
+    // Calculate directions
+    int lDirection = getStickDirection(leftX, leftY);
+    int rDirection = getStickDirection(rightX, rightY);
+
     // Handle L1 + left stick
-    if (l1 && lDirection != -1) {
-        std::string newKey = std::to_string(lDirection + 1);
-        
-        // Check for conflict with right stick key
-        if (newKey == currentRightKey && !currentRightKey.empty()) {
-            // Conflict - release our key if we have one
-            if (!currentLeftKey.empty()) {
-                sendKeyPress(currentLeftKey, false);
-                currentLeftKey = "";
+    if (l1 && lDirection != -1 && keyboardLayout.left[lDirection].type != SectorActionType::None) {
+        const SectorAction& newAction = keyboardLayout.left[lDirection];
+
+        // Check for conflict with the right stick's action
+        if (currentRightSector != -1 && sameSectorAction(newAction, keyboardLayout.right[currentRightSector])) {
+            // Conflict - release our action if we have one
+            if (currentLeftSector != -1) {
+                sendSectorAction(keyboardLayout.left[currentLeftSector], false);
+                currentLeftSector = -1;
             }
             return;
         }
-        
-        // Handle key change
-        if (currentLeftKey != newKey) {
-            if (!currentLeftKey.empty()) {
-                sendKeyPress(currentLeftKey, false); // Release old
+
+        // Handle action change - sectors bound to the same key keep it held
+        if (currentLeftSector == -1 || !sameSectorAction(keyboardLayout.left[currentLeftSector], newAction)) {
+            if (currentLeftSector != -1) {
+                sendSectorAction(keyboardLayout.left[currentLeftSector], false); // Release old
             }
-            currentLeftKey = newKey;
-            sendKeyPress(currentLeftKey, true); // Press new
+            sendSectorAction(newAction, true); // Press new
         }
-    } else if (!currentLeftKey.empty()) {
-        // L1 released or no direction - release key
-        sendKeyPress(currentLeftKey, false);
-        currentLeftKey = "";
+        currentLeftSector = lDirection;
+    } else if (currentLeftSector != -1) {
+        // L1 released or no direction - release action
+        sendSectorAction(keyboardLayout.left[currentLeftSector], false);
+        currentLeftSector = -1;
     }
-    
+
     // Handle R1 + right stick
-    if (r1 && rDirection != -1) {
-        std::string newKey = std::to_string(rDirection + 1);
-        
-        // Check for conflict with left stick key
-        if (newKey == currentLeftKey && !currentLeftKey.empty()) {
-            // Conflict - release our key if we have one
-            if (!currentRightKey.empty()) {
-                sendKeyPress(currentRightKey, false);
-                currentRightKey = "";
+    if (r1 && rDirection != -1 && keyboardLayout.right[rDirection].type != SectorActionType::None) {
+        const SectorAction& newAction = keyboardLayout.right[rDirection];
+
+        // Check for conflict with the left stick's action
+        if (currentLeftSector != -1 && sameSectorAction(newAction, keyboardLayout.left[currentLeftSector])) {
+            // Conflict - release our action if we have one
+            if (currentRightSector != -1) {
+                sendSectorAction(keyboardLayout.right[currentRightSector], false);
+                currentRightSector = -1;
             }
             return;
         }
-        
-        // Handle key change
-        if (currentRightKey != newKey) {
-            if (!currentRightKey.empty()) {
-                sendKeyPress(currentRightKey, false); // Release old
+
+        // Handle action change - sectors bound to the same key keep it held
+        if (currentRightSector == -1 || !sameSectorAction(keyboardLayout.right[currentRightSector], newAction)) {
+            if (currentRightSector != -1) {
+                sendSectorAction(keyboardLayout.right[currentRightSector], false); // Release old
             }
-            currentRightKey = newKey;
-            sendKeyPress(currentRightKey, true); // Press new
+            sendSectorAction(newAction, true); // Press new
         }
-    } else if (!currentRightKey.empty()) {
-        // R1 released or no direction - release key
-        sendKeyPress(currentRightKey, false);
-        currentRightKey = "";
+        currentRightSector = rDirection;
+    } else if (currentRightSector != -1) {
+        // R1 released or no direction - release action
+        sendSectorAction(keyboardLayout.right[currentRightSector], false);
+        currentRightSector = -1;
     }
 }
\ No newline at end of file
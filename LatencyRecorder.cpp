@@ -0,0 +1,41 @@
+#include "ControllerInput.h"
+
+// ========== Latency Recorder Implementation ==========
+
+LatencyStats LatencyRecorder::getStats() const {
+    LatencyStats stats;
+    uint32_t written = writeCount.load(std::memory_order_acquire);
+    uint32_t count = (written < CAPACITY) ? written : CAPACITY;
+    if (count == 0) {
+        return stats;
+    }
+    
+    // Copy the window out so the writer is never held up while we sort
+    float window[CAPACITY];
+    for (uint32_t i = 0; i < count; i++) {
+        window[i] = samples[i].load(std::memory_order_relaxed);
+    }
+    
+    stats.count = count;
+    stats.maxUs = *std::max_element(window, window + count);
+    
+    uint32_t p50Index = count / 2;
+    std::nth_element(window, window + p50Index, window + count);
+    stats.p50Us = window[p50Index];
+    
+    // p99 lies above the median, so only the upper half needs partitioning
+    uint32_t p99Index = (count * 99) / 100;
+    std::nth_element(window + p50Index, window + p99Index, window + count);
+    stats.p99Us = window[p99Index];
+    return stats;
+}
+
+uint32_t LatencyRecorder::copyRecent(float* out, uint32_t maxCount) const {
+    uint32_t written = writeCount.load(std::memory_order_acquire);
+    uint32_t count = (written < CAPACITY) ? written : CAPACITY;
+    if (count > maxCount) count = maxCount;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = samples[(written - count + i) % CAPACITY].load(std::memory_order_relaxed);
+    }
+    return count;
+}
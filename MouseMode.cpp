@@ -2,45 +2,58 @@
 
 // ========== Mouse Mode Implementation ==========
 
+// Cursor moves are queued as absolute virtual-desktop moves, so they keep their order
+// relative to the button events in the same SendInput (flushInputFrame)
+static INPUT absoluteMouseMove(const MonitorTopology& topology, LONG x, LONG y) {
+    // Normalized 0-65535 coordinates, aimed at the pixel centre so rounding lands on (x, y)
+    INPUT input = {};
+    input.type = INPUT_MOUSE;
+    input.mi.dx = (LONG)(((LONGLONG)(x - topology.virtualLeft) * 2 + 1) * 65536 / (2LL * topology.virtualWidth));
+    input.mi.dy = (LONG)(((LONGLONG)(y - topology.virtualTop) * 2 + 1) * 65536 / (2LL * topology.virtualHeight));
+    input.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    return input;
+}
+
 void ControllerMapper::moveMouseToCenter() {
     // Center cursor on the detected monitor
+    if (sharedTopology.version() != pollTopologyVersion) {
+        pollTopologyVersion = sharedTopology.read(pollTopology);
+    }
     int centerX = monitorLeft + monitorWidth / 2;
     int centerY = monitorTop + monitorHeight / 2;
-    SetCursorPos(centerX, centerY);
+    queueInput(absoluteMouseMove(pollTopology, centerX, centerY));
 }
 
 void ControllerMapper::moveMouseToStickPosition(double stickX, double stickY) {
-    RECT overlayRect;
-    GetWindowRect(overlayHwnd, &overlayRect);
-    int overlayWidth = overlayRect.right - overlayRect.left;
-    int overlayHeight = overlayRect.bottom - overlayRect.top;
-    
-    int centerX = overlayPosX + overlayWidth / 2;
-    int centerY = overlayPosY + overlayHeight / 2;
+    // Overlay centre and stick radius come from the cached topology - no window query per sample
+    if (sharedTopology.version() != pollTopologyVersion) {
+        pollTopologyVersion = sharedTopology.read(pollTopology);
+    }
+    const MonitorTopology& topology = pollTopology;
     
-    int mouseX = centerX + (int)(stickX * overlayStickRadius);
-    int mouseY = centerY - (int)(stickY * overlayStickRadius);
+    int mouseX = topology.overlayCenterX + (int)(stickX * topology.stickRadius);
+    int mouseY = topology.overlayCenterY - (int)(stickY * topology.stickRadius);
     
-    SetCursorPos(mouseX, mouseY);
+    queueInput(absoluteMouseMove(topology, mouseX, mouseY));
 }
 
 void ControllerMapper::sendMouseButton(bool down) {
     INPUT input = {};
     input.type = INPUT_MOUSE;
     input.mi.dwFlags = down ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
-    SendInput(1, &input, sizeof(INPUT));
+    queueInput(input);
 }
 
-void ControllerMapper::handleMouseControl(bool l1, bool r1, double leftX, double leftY, double rightX, double rightY) {
+void ControllerMapper::handleMouseControl(ControllerSlot& slot, bool l1, bool r1, double leftX, double leftY, double rightX, double rightY) {
     bool anyButtonPressed = l1 || r1;
     bool bothPressed = l1 && r1;
-    bool prevAnyPressed = prevL1 || prevR1;
+    bool prevAnyPressed = slot.prevL1 || slot.prevR1;
     
     // Press LMB when L1 or R1 is first pressed
     if (anyButtonPressed && !prevAnyPressed) {
         sendMouseButton(true);
         mouseButtonPressed = true;
-        std::cout << "L1/R1 pressed: LMB activated" << std::endl;
+        MAPPER_LOG(asyncLog.poll, LogLevel::Info, "L1/R1 pressed: LMB activated");
     }
     
     // Release LMB when all buttons are released
@@ -48,7 +61,7 @@ void ControllerMapper::handleMouseControl(bool l1, bool r1, double leftX, double
         sendMouseButton(false);
         mouseButtonPressed = false;
         moveMouseToCenter();
-        std::cout << "L1/R1 released: LMB released, mouse to center" << std::endl;
+        MAPPER_LOG(asyncLog.poll, LogLevel::Info, "L1/R1 released: LMB released, mouse to center");
     }
     
     // Handle mouse positioning
@@ -68,6 +81,6 @@ void ControllerMapper::handleMouseControl(bool l1, bool r1, double leftX, double
         moveMouseToStickPosition(rightX, rightY);
     }
     
-    prevL1 = l1;
-    prevR1 = r1;
+    slot.prevL1 = l1;
+    slot.prevR1 = r1;
 }
\ No newline at end of file
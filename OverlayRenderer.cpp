@@ -0,0 +1,439 @@
+#include "ControllerInput.h"
+
+// ========== Overlay Renderer Implementation ==========
+// The overlay covers most of the monitor but only a few small elements change per
+// frame. Each snapshot's element bounds are redrawn together with the previous
+// snapshot's, into a persistent back buffer:
+//  - ColorKeyGdi:  invalidated, and WM_PAINT copies the update region to the window
+//  - LayeredAlpha: drawn immediately in a color pass and an alpha (mask) pass, combined
+//                  to premultiplied ARGB and pushed with one UpdateLayeredWindowIndirect
+
+// ========== GDI Object Cache ==========
+
+GdiCache::~GdiCache() {
+    for (auto& entry : pens) {
+        DeleteObject(entry.second);
+    }
+    for (auto& entry : brushes) {
+        DeleteObject(entry.second);
+    }
+    for (auto& entry : fonts) {
+        DeleteObject(entry.second);
+    }
+}
+
+HPEN GdiCache::getPen(COLORREF color, int width) {
+    unsigned long long key = ((unsigned long long)(unsigned)width << 32) | color;
+    auto it = pens.find(key);
+    if (it != pens.end()) {
+        return it->second;
+    }
+    HPEN pen = CreatePen(PS_SOLID, width, color);
+    pens[key] = pen;
+    return pen;
+}
+
+HBRUSH GdiCache::getBrush(COLORREF color) {
+    auto it = brushes.find(color);
+    if (it != brushes.end()) {
+        return it->second;
+    }
+    HBRUSH brush = CreateSolidBrush(color);
+    brushes[color] = brush;
+    return brush;
+}
+
+HFONT GdiCache::getFont(int height, int weight, DWORD quality) {
+    unsigned long long key = ((unsigned long long)(unsigned)weight << 32) | ((unsigned long long)(quality & 0xFF) << 24) |
+                             ((unsigned)height & 0xFFFFFF);
+    auto it = fonts.find(key);
+    if (it != fonts.end()) {
+        return it->second;
+    }
+    HFONT font = CreateFont(height, 0, 0, 0, weight, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
+                            OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, quality,
+                            DEFAULT_PITCH | FF_DONTCARE, "Consolas");
+    fonts[key] = font;
+    return font;
+}
+
+// ========== DIB Surface ==========
+
+bool DibSurface::ensure(int newWidth, int newHeight) {
+    if (dc && newWidth == width && newHeight == height) {
+        return true;
+    }
+    release();
+    if (newWidth <= 0 || newHeight <= 0) {
+        return false;
+    }
+
+    // Top-down 32-bit DIB so row y starts at bits + y * width
+    BITMAPINFO bitmapInfo = {};
+    bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.bmiHeader.biWidth = newWidth;
+    bitmapInfo.bmiHeader.biHeight = -newHeight;
+    bitmapInfo.bmiHeader.biPlanes = 1;
+    bitmapInfo.bmiHeader.biBitCount = 32;
+    bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+    void* pixels = nullptr;
+    dc = CreateCompatibleDC(nullptr);
+    bitmap = CreateDIBSection(dc, &bitmapInfo, DIB_RGB_COLORS, &pixels, nullptr, 0);
+    if (!dc || !bitmap) {
+        release();
+        return false;
+    }
+    oldBitmap = SelectObject(dc, bitmap);
+    bits = (uint32_t*)pixels;
+    width = newWidth;
+    height = newHeight;
+    return true;
+}
+
+void DibSurface::release() {
+    if (dc) {
+        if (oldBitmap) {
+            SelectObject(dc, oldBitmap);
+        }
+        DeleteDC(dc);
+    }
+    if (bitmap) {
+        DeleteObject(bitmap);
+    }
+    dc = nullptr;
+    bitmap = nullptr;
+    oldBitmap = nullptr;
+    bits = nullptr;
+    width = 0;
+    height = 0;
+}
+
+// ========== Per-Pixel Alpha Backend ==========
+
+// v * a / 255, rounded, without a division
+static inline uint32_t mulDiv255(uint32_t v, uint32_t a) {
+    uint32_t t = v * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+void ControllerMapper::renderLayeredOverlay(HRGN dirtyRegion) {
+    LONGLONG paintStart = qpcNow();
+    paintingSampleTicks = paintSnapshot.sampleTicks;
+
+    RECT client;
+    GetClientRect(overlayHwnd, &client);
+    bool resized = (backBuffer.width != client.right || backBuffer.height != client.bottom);
+
+    if (!backBuffer.ensure(client.right, client.bottom) || !maskBuffer.ensure(client.right, client.bottom)) {
+        // Out of memory for two full-size DIBs - keep an overlay on screen the old way
+        logError("Failed to create layered overlay buffers - falling back to color-key overlay");
+        maskBuffer.release();
+        overlayBackend = OverlayBackend::ColorKeyGdi;
+        SetLayeredWindowAttributes(overlayHwnd, RGB(0, 0, 0), 0, LWA_COLORKEY);
+        InvalidateRect(overlayHwnd, nullptr, FALSE);
+        return;
+    }
+    if (resized) {
+        // New buffers have undefined contents
+        SetRectRgn(dirtyRegion, 0, 0, client.right, client.bottom);
+    }
+
+    RECT bounds;
+    if (GetRgnBox(dirtyRegion, &bounds) == NULLREGION) {
+        return;
+    }
+
+    // Color pass, then the same geometry with each element's alpha as gray
+    SelectClipRgn(backBuffer.dc, dirtyRegion);
+    drawOverlayScene(backBuffer.dc, client, bounds);
+    SelectClipRgn(backBuffer.dc, nullptr);
+
+    overlayMaskPass = true;
+    SelectClipRgn(maskBuffer.dc, dirtyRegion);
+    drawOverlayScene(maskBuffer.dc, client, bounds);
+    SelectClipRgn(maskBuffer.dc, nullptr);
+    overlayMaskPass = false;
+
+    GdiFlush(); // GDI batches drawing - finish it before touching the bits
+    premultiplyRegion(dirtyRegion);
+
+    // One blit of the changed area; the rest of the window keeps its content
+    POINT sourceOrigin = { 0, 0 };
+    SIZE size = { client.right, client.bottom };
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize = sizeof(UPDATELAYEREDWINDOWINFO);
+    info.psize = &size;
+    info.hdcSrc = backBuffer.dc;
+    info.pptSrc = &sourceOrigin;
+    info.pblend = &blend;
+    info.dwFlags = ULW_ALPHA;
+    info.prcDirty = resized ? nullptr : &bounds;
+    UpdateLayeredWindowIndirect(overlayHwnd, &info);
+
+    recordPaintLatency(paintStart);
+}
+
+void ControllerMapper::premultiplyRegion(HRGN region) {
+    // Walk the region's own (non-overlapping) rectangles so no pixel is converted twice
+    DWORD dataSize = GetRegionData(region, 0, nullptr);
+    if (dataSize == 0) {
+        return;
+    }
+    if (regionDataBuffer.size() < dataSize) {
+        regionDataBuffer.resize(dataSize);
+    }
+    RGNDATA* data = (RGNDATA*)regionDataBuffer.data();
+    if (!GetRegionData(region, dataSize, data)) {
+        return;
+    }
+
+    const RECT* rects = (const RECT*)data->Buffer;
+    for (DWORD i = 0; i < data->rdh.nCount; i++) {
+        int left = (std::max)((int)rects[i].left, 0);
+        int top = (std::max)((int)rects[i].top, 0);
+        int right = (std::min)((int)rects[i].right, backBuffer.width);
+        int bottom = (std::min)((int)rects[i].bottom, backBuffer.height);
+
+        for (int y = top; y < bottom; y++) {
+            uint32_t* color = backBuffer.bits + (size_t)y * backBuffer.width;
+            const uint32_t* mask = maskBuffer.bits + (size_t)y * maskBuffer.width;
+            for (int x = left; x < right; x++) {
+                uint32_t alpha = mask[x] & 0xFF;
+                if (alpha == 0) {
+                    color[x] = 0;
+                } else if (alpha == 255) {
+                    color[x] |= 0xFF000000;
+                } else {
+                    uint32_t c = color[x];
+                    color[x] = (alpha << 24) |
+                               (mulDiv255((c >> 16) & 0xFF, alpha) << 16) |
+                               (mulDiv255((c >> 8) & 0xFF, alpha) << 8) |
+                               mulDiv255(c & 0xFF, alpha);
+                }
+            }
+        }
+    }
+}
+
+// ========== Dirty Rectangles ==========
+
+void ControllerMapper::invalidateOverlayChanges() {
+    if (overlayBackend == OverlayBackend::GpuComposition) {
+        gpuFrameDirty = true; // Full GPU redraw is cheaper than tracking rectangles
+        return;
+    }
+
+    RECT client;
+    GetClientRect(overlayHwnd, &client);
+
+    RECT current[MAX_OVERLAY_DIRTY_RECTS];
+    int currentCount = collectOverlayElementRects(paintSnapshot, client, current);
+
+    // Erase where elements were, draw where they are now
+    bool layered = (overlayBackend == OverlayBackend::LayeredAlpha);
+    if (layered) {
+        SetRectRgn(paintRegion, 0, 0, 0, 0);
+    }
+    for (int i = 0; i < overlayDirtyRectCount + currentCount; i++) {
+        const RECT& dirty = (i < overlayDirtyRectCount) ? overlayDirtyRects[i] : current[i - overlayDirtyRectCount];
+        if (layered) {
+            SetRectRgn(scratchRegion, dirty.left, dirty.top, dirty.right, dirty.bottom);
+            CombineRgn(paintRegion, paintRegion, scratchRegion, RGN_OR);
+        } else {
+            InvalidateRect(overlayHwnd, &dirty, FALSE);
+        }
+    }
+    for (int i = 0; i < currentCount; i++) {
+        overlayDirtyRects[i] = current[i];
+    }
+    overlayDirtyRectCount = currentCount;
+
+    if (layered) {
+        renderLayeredOverlay(paintRegion);
+    }
+}
+
+void ControllerMapper::invalidateDebugText() {
+    if (!overlayHwnd || !paintRegion) return;
+
+    if (overlayBackend == OverlayBackend::GpuComposition) {
+        gpuFrameDirty = true; // Drawn with everything else, one Present per run() iteration
+        return;
+    }
+
+    RECT client;
+    GetClientRect(overlayHwnd, &client);
+
+    // Elements haven't moved - refresh the erase list only for the panel's new size,
+    // and repaint where the panel was and now is
+    RECT previous = debugTextRect;
+    overlayDirtyRectCount = collectOverlayElementRects(paintSnapshot, client, overlayDirtyRects);
+    RECT dirty;
+    if (!UnionRect(&dirty, &previous, &debugTextRect)) {
+        return;
+    }
+
+    if (overlayBackend == OverlayBackend::LayeredAlpha) {
+        SetRectRgn(paintRegion, dirty.left, dirty.top, dirty.right, dirty.bottom);
+        renderLayeredOverlay(paintRegion);
+    } else {
+        InvalidateRect(overlayHwnd, &dirty, FALSE);
+    }
+}
+
+void ControllerMapper::invalidatePerfHud(const RECT& previous) {
+    if (!overlayHwnd || !paintRegion) return;
+
+    if (overlayBackend == OverlayBackend::GpuComposition) {
+        gpuFrameDirty = true; // Drawn with everything else, one Present per run() iteration
+        return;
+    }
+
+    // Same as a debug text refresh: where the HUD was and now is, nothing else
+    RECT dirty;
+    if (!UnionRect(&dirty, &previous, &perfHudRect)) {
+        return;
+    }
+    if (overlayBackend == OverlayBackend::LayeredAlpha) {
+        SetRectRgn(paintRegion, dirty.left, dirty.top, dirty.right, dirty.bottom);
+        renderLayeredOverlay(paintRegion);
+    } else {
+        InvalidateRect(overlayHwnd, &dirty, FALSE);
+    }
+}
+
+void ControllerMapper::redrawOverlay() {
+    if (!overlayHwnd || !paintRegion) return;
+
+    if (overlayBackend == OverlayBackend::GpuComposition) {
+        gpuFrameDirty = true;
+    } else if (overlayBackend == OverlayBackend::LayeredAlpha) {
+        RECT client;
+        GetClientRect(overlayHwnd, &client);
+        SetRectRgn(paintRegion, 0, 0, client.right, client.bottom);
+        renderLayeredOverlay(paintRegion);
+    } else {
+        RedrawWindow(overlayHwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW | RDW_NOFRAME);
+    }
+}
+
+int ControllerMapper::collectOverlayElementRects(const OverlaySnapshot& snapshot, const RECT& client, RECT* rects) {
+    // Bounds are padded for pen widths and touch ID labels - a slightly larger
+    // rectangle costs a few pixels, a short one leaves trails
+    const int RING_MARGIN = 8;          // Direction arcs are up to 10px wide, centred on the ring
+    const int STICK_MARGIN = 6;         // Stick indicator pen is up to 6px wide
+    const int MARKER_RADIUS = OVERLAY_LOCKED_INDICATOR_RADIUS + 4;  // Touch circle + border + ID label
+
+    int count = 0;
+
+    auto addCircle = [&](int x, int y, int radius) {
+        rects[count++] = { x - radius, y - radius, x + radius + 1, y + radius + 1 };
+    };
+
+    for (int r = 0; r < snapshot.ringCount; r++) {
+        const RingSnapshot& ring = snapshot.rings[r];
+        int centerX, centerY;
+        getRingCenter(r, snapshot.ringCount, client, centerX, centerY);
+
+        // Boundary ring and direction arcs
+        int maxAlpha = (ring.leftAlpha > ring.rightAlpha) ? ring.leftAlpha : ring.rightAlpha;
+        if (maxAlpha >= 10) {
+            addCircle(centerX, centerY, overlayStickRadius + RING_MARGIN);
+        }
+
+        // Stick indicators and locked pointers
+        int x, y;
+        if (ring.leftAlpha >= 10) {
+            convertStickToOverlayCoords(ring.leftX, ring.leftY, centerX, centerY, x, y);
+            addCircle(x, y, OVERLAY_STICK_INDICATOR_RADIUS + STICK_MARGIN);
+        }
+        if (ring.rightAlpha >= 10) {
+            convertStickToOverlayCoords(ring.rightX, ring.rightY, centerX, centerY, x, y);
+            addCircle(x, y, OVERLAY_STICK_INDICATOR_RADIUS + STICK_MARGIN);
+        }
+        if (ring.leftLockedAlpha > 0) {
+            convertStickToOverlayCoords(ring.leftLockedX, ring.leftLockedY, centerX, centerY, x, y);
+            addCircle(x, y, OVERLAY_LOCKED_INDICATOR_RADIUS + 2);
+        }
+        if (ring.rightLockedAlpha > 0) {
+            convertStickToOverlayCoords(ring.rightLockedX, ring.rightLockedY, centerX, centerY, x, y);
+            addCircle(x, y, OVERLAY_LOCKED_INDICATOR_RADIUS + 2);
+        }
+
+        // Touches 0-1
+        for (int i = 0; i < 2; i++) {
+            if (ring.touchActive[i]) {
+                convertStickToOverlayCoords(ring.touchX[i], ring.touchY[i], centerX, centerY, x, y);
+                addCircle(x, y, MARKER_RADIUS);
+            }
+        }
+
+        // Each palm as one box - covers its 9 contacts and the centroid marker between them
+        for (int palm = 0; palm < 2; palm++) {
+            int centerId = palm;
+            int cornerStartId = (palm == 0) ? 2 : 10;
+            RECT bounds = {};
+            bool any = false;
+            for (int i = -1; i < 8; i++) {
+                int touchId = (i < 0) ? centerId : cornerStartId + i;
+                if (!ring.touchActive[touchId]) {
+                    continue;
+                }
+                convertStickToOverlayCoords(ring.touchX[touchId], ring.touchY[touchId], centerX, centerY, x, y);
+                RECT marker = { x - MARKER_RADIUS, y - MARKER_RADIUS, x + MARKER_RADIUS + 1, y + MARKER_RADIUS + 1 };
+                if (!any) {
+                    bounds = marker;
+                    any = true;
+                } else {
+                    UnionRect(&bounds, &bounds, &marker);
+                }
+            }
+            if (any) {
+                rects[count++] = bounds;
+            }
+        }
+    }
+
+    // Debug panel - its latency block is appended at paint time
+    debugTextRect = {};
+    if (showDebugInfo && !paintDebugText.empty()) {
+        debugTextRect = getDebugTextRect(client, paintDebugText.c_str(), (int)paintDebugText.size(),
+                                         LATENCY_STATS_LINES, LATENCY_STATS_CHARS);
+        rects[count++] = debugTextRect;
+    }
+
+    return count;
+}
+
+RECT ControllerMapper::getDebugTextRect(const RECT& client, const char* text, int length, int extraLines, int minLineChars) {
+    int lineCount = extraLines;
+    int maxLineChars = minLineChars;
+    int lineStart = 0;
+    for (;;) {
+        int lineEnd = lineStart;
+        while (lineEnd < length && !(text[lineEnd] == '\r' && lineEnd + 1 < length && text[lineEnd + 1] == '\n')) {
+            lineEnd++;
+        }
+        bool lastLine = (lineEnd == length);
+        if (!lastLine || lineEnd > lineStart) {
+            lineCount++;
+        }
+        if (lineEnd - lineStart > maxLineChars) {
+            maxLineChars = lineEnd - lineStart;
+        }
+        if (lastLine) {
+            break;
+        }
+        lineStart = lineEnd + 2;
+    }
+
+    // Bottom-left, DEBUG_TEXT_BOTTOM_MARGIN above the bottom edge
+    int textHeight = lineCount * DEBUG_TEXT_LINE_HEIGHT;
+    int textY = client.bottom - textHeight - DEBUG_TEXT_BOTTOM_MARGIN;
+    if (textY < 30) textY = 30; // Don't go too high
+
+    RECT textRect = { DEBUG_TEXT_X, textY, DEBUG_TEXT_X + maxLineChars * DEBUG_TEXT_CHAR_WIDTH, textY + textHeight };
+    return textRect;
+}
@@ -0,0 +1,131 @@
+#include "ControllerInput.h"
+#include <cstdio>
+
+// ========== Performance HUD Implementation ==========
+// Second state of Ctrl+Shift+~: a top-right panel with the poll loop's period graph,
+// event rates and the latency percentiles, for checking a machine holds its target
+// timing before a session. The content is rebuilt on the overlay thread at
+// PERF_HUD_REFRESH_HZ; repaints in between draw that same content, so a rectangle
+// painted for another element never mixes two refreshes.
+
+void ControllerMapper::refreshPerfHud() {
+    LONGLONG now = qpcNow();
+    if (perfHudRefreshTicks != 0 && now - perfHudRefreshTicks < qpcFrequency() / PERF_HUD_REFRESH_HZ) {
+        return;
+    }
+
+    PerfCounterValues counters = perfCounters.read();
+    if (perfHudRefreshTicks == 0) {
+        // Just switched on - rates need a full interval
+        perfHudRefreshTicks = now;
+        perfHudBaseline = counters;
+        return;
+    }
+    double seconds = (double)(now - perfHudRefreshTicks) / qpcFrequency();
+    const PerfCounterValues& last = perfHudBaseline;
+    perfHudRefreshTicks = now;
+
+    LatencyStats period = pollPeriodRecorder.getStats();
+    LatencyStats paint = overlayPaintTime.getStats();
+    perfHudTargetUs = pollPacer.getTargetPeriodMs() * 1000.0;
+    perfHudPeriodCount = pollPeriodRecorder.copyRecent(perfHudPeriods, PERF_GRAPH_POINTS);
+
+    perfHudText.clear();
+    perfHudText.appendf(
+        "PERFORMANCE\r\n"
+        "Poll period (us) p50 %.0f  p99 %.0f  max %.0f | target %.0f%s\r\n"
+        "Polls: %.0f/s | Samples: %.0f/s\r\n"
+        "InjectTouchInput: %.0f calls/s, %.0f contacts/s\r\n"
+        "Edges: %llu dropped reports, %llu overflows, %llu coalesced\r\n"
+        "Overlay paint (us) p50 %.0f  p99 %.0f  max %.0f\r\n",
+        period.p50Us, period.p99Us, period.maxUs, perfHudTargetUs, pollIdle ? " [idle]" : "",
+        (counters.loopWakes - last.loopWakes) / seconds, (counters.samples - last.samples) / seconds,
+        (counters.injectCalls - last.injectCalls) / seconds, (counters.injectContacts - last.injectContacts) / seconds,
+        (unsigned long long)counters.droppedReports, (unsigned long long)counters.bufferOverflows,
+        (unsigned long long)counters.coalescedEdges,
+        paint.p50Us, paint.p99Us, paint.maxUs);
+    appendLatencyStats(perfHudText);
+    perfHudBaseline = counters;
+
+    RECT client;
+    GetClientRect(overlayHwnd, &client);
+    RECT previous = perfHudRect;
+    perfHudRect = getPerfHudRect(client);
+    invalidatePerfHud(previous);
+}
+
+RECT ControllerMapper::getPerfHudRect(const RECT& client) {
+    // Sized like the debug panel's text, with the graph below it, anchored top-right
+    RECT text = getDebugTextRect(client, perfHudText.text, perfHudText.length, 0, 0);
+    int width = (std::max)((int)(text.right - text.left), PERF_GRAPH_POINTS * PERF_GRAPH_STEP);
+    int height = (text.bottom - text.top) + DEBUG_TEXT_LINE_HEIGHT / 2 + PERF_GRAPH_HEIGHT;
+    RECT hud = { client.right - DEBUG_TEXT_X - width, PERF_HUD_TOP, client.right - DEBUG_TEXT_X, PERF_HUD_TOP + height };
+    return hud;
+}
+
+void ControllerMapper::getPerfGraphPoint(const RECT& hud, uint32_t index, float& x, float& y) const {
+    // Centre line is the target period, the edges are 0 and twice the target
+    float graphMiddle = (float)hud.bottom - PERF_GRAPH_HEIGHT / 2.0f;
+    float deviation = perfHudTargetUs > 0.0 ? (float)((perfHudPeriods[index] - perfHudTargetUs) / perfHudTargetUs) : 0.0f;
+    if (deviation > 1.0f) deviation = 1.0f;
+    if (deviation < -1.0f) deviation = -1.0f;
+    x = (float)(hud.right - (int)(perfHudPeriodCount - index) * PERF_GRAPH_STEP);
+    y = graphMiddle - deviation * (PERF_GRAPH_HEIGHT / 2.0f);
+}
+
+void ControllerMapper::drawPerfHud(HDC hdc, const RECT& client) {
+    if (perfHudText.length == 0) return;
+    RECT hud = getPerfHudRect(client);
+
+    DWORD quality = (overlayBackend == OverlayBackend::LayeredAlpha) ? ANTIALIASED_QUALITY : CLEARTYPE_QUALITY;
+    HFONT oldFont = (HFONT)SelectObject(hdc, gdiCache.getFont(20, FW_BOLD, quality));
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, overlayColor(RGB(255, 255, 255), 255));
+
+    drawTextLines(hdc, hud.left, hud.top, perfHudText.text, perfHudText.length);
+    SelectObject(hdc, oldFont);
+
+    // Target line, then the periods as one polyline (newest on the right)
+    int graphLeft = hud.right - PERF_GRAPH_POINTS * PERF_GRAPH_STEP;
+    int graphMiddle = hud.bottom - PERF_GRAPH_HEIGHT / 2;
+    HPEN oldPen = (HPEN)SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(120, 120, 120), 160), 1));
+    MoveToEx(hdc, graphLeft, graphMiddle, nullptr);
+    LineTo(hdc, hud.right, graphMiddle);
+
+    if (perfHudPeriodCount > 1) {
+        POINT points[PERF_GRAPH_POINTS];
+        for (uint32_t i = 0; i < perfHudPeriodCount; i++) {
+            float x, py;
+            getPerfGraphPoint(hud, i, x, py);
+            points[i] = { (LONG)x, (LONG)py };
+        }
+        SelectObject(hdc, gdiCache.getPen(overlayColor(RGB(80, 220, 120), 255), 1));
+        Polyline(hdc, points, (int)perfHudPeriodCount);
+    }
+    SelectObject(hdc, oldPen);
+}
+
+void ControllerMapper::renderGpuPerfHud(const RECT& client) {
+    if (perfHudText.length == 0) return;
+    RECT hud = getPerfHudRect(client);
+
+    int length = MultiByteToWideChar(CP_ACP, 0, perfHudText.text, perfHudText.length, nullptr, 0);
+    gpuTextBuffer.resize(length);
+    MultiByteToWideChar(CP_ACP, 0, perfHudText.text, perfHudText.length, &gpuTextBuffer[0], length);
+    setGpuBrush(RGB(255, 255, 255), 255);
+    d2dContext->DrawText(gpuTextBuffer.c_str(), (UINT32)gpuTextBuffer.size(), debugTextFormat,
+                         D2D1::RectF((float)hud.left, (float)hud.top, (float)client.right, (float)hud.bottom), d2dBrush);
+
+    float graphLeft = (float)(hud.right - PERF_GRAPH_POINTS * PERF_GRAPH_STEP);
+    float graphMiddle = (float)hud.bottom - PERF_GRAPH_HEIGHT / 2.0f;
+    setGpuBrush(RGB(120, 120, 120), 160);
+    d2dContext->DrawLine(D2D1::Point2F(graphLeft, graphMiddle), D2D1::Point2F((float)hud.right, graphMiddle), d2dBrush, 1.0f);
+
+    setGpuBrush(RGB(80, 220, 120), 255);
+    for (uint32_t i = 1; i < perfHudPeriodCount; i++) {
+        float x0, y0, x1, y1;
+        getPerfGraphPoint(hud, i - 1, x0, y0);
+        getPerfGraphPoint(hud, i, x1, y1);
+        d2dContext->DrawLine(D2D1::Point2F(x0, y0), D2D1::Point2F(x1, y1), d2dBrush, 1.0f);
+    }
+}
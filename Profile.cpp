@@ -0,0 +1,168 @@
+#include "ControllerInput.h"
+#include <cstdio>
+
+// ========== Session Profile Implementation ==========
+// The menus' answers and the controllers they picked, saved once a menu-driven session
+// is up. Later starts (and Ctrl+Alt+Shift+~ restarts) load it and open the controllers
+// by path/GUID/index directly - no mode menus, no enumeration, no selection prompt.
+
+static const char PROFILE_MAGIC[4] = { 'C', 'I', 'M', 'P' };
+static const uint16_t PROFILE_VERSION = 3;
+
+std::string ControllerMapper::defaultProfilePath() {
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) {
+        return "ControllerInput.profile";
+    }
+    std::string directory(path, length);
+    size_t slash = directory.find_last_of("\\/");
+    directory = (slash == std::string::npos) ? std::string() : directory.substr(0, slash + 1);
+    return directory + "ControllerInput.profile";
+}
+
+bool ControllerMapper::loadProfile(const std::string& path, MapperSettings& settings) {
+    FILE* file = nullptr;
+    if (fopen_s(&file, path.c_str(), "rb") != 0 || !file) {
+        return false;  // No profile yet - the menus run and write one
+    }
+
+    ProfileHeader header = {};
+    ProfileController saved[MAX_CONTROLLERS] = {};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, PROFILE_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == PROFILE_VERSION &&
+              header.mode <= (uint8_t)InputMode::Keyboard &&
+              header.palmMode <= (uint8_t)PalmInjectionMode::Serialized &&
+              header.overlayBackend <= (uint8_t)OverlayBackend::GpuComposition &&
+              header.controllerCount >= 1 && header.controllerCount <= MAX_CONTROLLERS;
+    if (ok) {
+        ok = fread(saved, sizeof(ProfileController), header.controllerCount, file) == header.controllerCount;
+    }
+    fclose(file);
+
+    if (!ok) {
+        logError("Ignoring invalid profile: " + path);
+        return false;
+    }
+
+    settings.mode = (InputMode)header.mode;
+    settings.pollRateHz = header.pollRateHz;
+    settings.bufferedDirectInput = header.bufferedDirectInput != 0;
+    settings.palmMode = (PalmInjectionMode)header.palmMode;
+    settings.palmStaggerUs = header.palmStaggerUs;
+    settings.predictionMs = header.predictionMs;
+    settings.touchUpsampleHz = header.touchUpsampleHz;
+    settings.idleMs = header.idleMs;
+    settings.overlayBackend = (OverlayBackend)header.overlayBackend;
+    settings.conditioning.radialDeadzone = header.radialDeadzone;
+    settings.conditioning.axialDeadzone = header.axialDeadzone;
+    settings.conditioning.antiDeadzone = header.antiDeadzone;
+    settings.conditioning.outerDeadzone = header.outerDeadzone;
+    settings.conditioning.curve = header.curve;
+    settings.conditioning.triggerThreshold = header.triggerThreshold;
+    settings.diButtons.l1 = header.diButtons[0];
+    settings.diButtons.r1 = header.diButtons[1];
+    settings.diButtons.l2 = header.diButtons[2];
+    settings.diButtons.r2 = header.diButtons[3];
+    settings.diButtons.l3 = header.diButtons[4];
+    settings.diButtons.r3 = header.diButtons[5];
+    header.layoutPath[MAX_PATH - 1] = '\0';
+    settings.layoutPath = header.layoutPath;
+
+    settings.profileControllers.clear();
+    for (int i = 0; i < header.controllerCount; i++) {
+        ControllerInfo info;
+        info.type = (ControllerType)saved[i].type;
+        info.index = saved[i].xInputIndex;
+        info.guid = saved[i].guid;
+        saved[i].devicePath[MAX_PATH - 1] = '\0';
+        saved[i].name[sizeof(saved[i].name) - 1] = '\0';
+        info.devicePath = saved[i].devicePath;
+        info.name = saved[i].name;
+        settings.profileControllers.push_back(info);
+    }
+    return true;
+}
+
+bool ControllerMapper::saveProfile() {
+    ProfileHeader header = {};
+    memcpy(header.magic, PROFILE_MAGIC, sizeof(header.magic));
+    header.version = PROFILE_VERSION;
+    header.mode = (uint8_t)currentMode;
+    header.palmMode = (uint8_t)palmInjectionMode;
+    header.overlayBackend = (uint8_t)overlayBackend;
+    header.controllerCount = (uint8_t)controllerCount;
+    header.bufferedDirectInput = useBufferedDirectInput ? 1 : 0;
+    header.diButtons[0] = diButtonMap.l1;
+    header.diButtons[1] = diButtonMap.r1;
+    header.diButtons[2] = diButtonMap.l2;
+    header.diButtons[3] = diButtonMap.r2;
+    header.diButtons[4] = diButtonMap.l3;
+    header.diButtons[5] = diButtonMap.r3;
+    header.pollRateHz = pollRateHz;
+    header.palmStaggerUs = palmStaggerUs;
+    header.predictionMs = predictionMs;
+    header.touchUpsampleHz = touchUpsampleHz;
+    header.idleMs = idleMs;
+    const StickConditioning& conditioning = stickConditioner.settings();
+    header.radialDeadzone = conditioning.radialDeadzone;
+    header.axialDeadzone = conditioning.axialDeadzone;
+    header.antiDeadzone = conditioning.antiDeadzone;
+    header.outerDeadzone = conditioning.outerDeadzone;
+    header.curve = conditioning.curve;
+    header.triggerThreshold = conditioning.triggerThreshold;
+    strncpy_s(header.layoutPath, layoutPath.c_str(), _TRUNCATE);
+
+    ProfileController saved[MAX_CONTROLLERS] = {};
+    for (int i = 0; i < controllerCount; i++) {
+        const ControllerInfo& info = controllers[i].source;
+        saved[i].type = (uint8_t)info.type;
+        saved[i].xInputIndex = (uint8_t)info.index;
+        saved[i].guid = info.guid;
+        strncpy_s(saved[i].devicePath, info.devicePath.c_str(), _TRUNCATE);
+        strncpy_s(saved[i].name, info.name.c_str(), _TRUNCATE);
+    }
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, profilePath.c_str(), "wb") != 0 || !file) {
+        logError("Failed to create profile: " + profilePath);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(saved, sizeof(ProfileController), controllerCount, file) == (size_t)controllerCount;
+    fclose(file);
+
+    if (!ok) {
+        logError("Failed to write profile: " + profilePath);
+        return false;
+    }
+    logInfo("Saved this setup to " + profilePath + " (start with --setup to choose again)");
+    return true;
+}
+
+bool ControllerMapper::openProfileControllers() {
+    int opened = 0;
+    for (const ControllerInfo& info : profileControllers) {
+        if (opened == MAX_CONTROLLERS) break;
+        ControllerSlot& slot = controllers[opened];
+
+        // XInput slots open without a handle - make sure a pad is actually in that slot
+        XINPUT_STATE state;
+        bool ok = (info.type == ControllerType::XInput) ? (XInputGetState(info.index, &state) == ERROR_SUCCESS)
+                                                        : openController(slot, info);
+        if (ok && info.type == ControllerType::XInput) {
+            ok = openController(slot, info);
+        }
+        if (!ok) {
+            for (int i = 0; i <= opened; i++) {
+                releaseController(controllers[i]);
+            }
+            controllerCount = 1;
+            return false;
+        }
+        opened++;
+    }
+    controllerCount = opened;
+    return opened > 0;
+}
@@ -0,0 +1,72 @@
+#include "ControllerInput.h"
+
+// ========== Stick Conditioner Implementation ==========
+
+static double clampSetting(double value, double minValue, double maxValue) {
+    return value < minValue ? minValue : (value > maxValue ? maxValue : value);
+}
+
+// Per-axis deadzone, rescaled so the axis still reaches full deflection
+static double applyAxialDeadzone(double value, double deadzone) {
+    double magnitude = std::fabs(value);
+    if (magnitude <= deadzone) return 0.0;
+    double scaled = (magnitude - deadzone) / (1.0 - deadzone);
+    return value < 0.0 ? -scaled : scaled;
+}
+
+static int16_t toFixed(double value) {
+    value = clampSetting(value, -1.0, 1.0);
+    return (int16_t)std::lround(value * StickConditioner::FIXED_ONE);
+}
+
+void StickConditioner::build(const StickConditioning& settings) {
+    // Keep every setting inside the range the curve below is defined for
+    config = settings;
+    config.radialDeadzone = clampSetting(config.radialDeadzone, 0.0, 0.9);
+    config.axialDeadzone = clampSetting(config.axialDeadzone, 0.0, 0.9);
+    config.antiDeadzone = clampSetting(config.antiDeadzone, 0.0, 0.9);
+    if (config.outerDeadzone > 0.0) {
+        config.outerDeadzone = clampSetting(config.outerDeadzone, config.radialDeadzone + 0.05, 1.5);
+    } else {
+        config.outerDeadzone = 0.0;
+    }
+    config.curve = clampSetting(config.curve, 0.2, 5.0);
+    if (config.triggerThreshold < 0) config.triggerThreshold = 0;
+    if (config.triggerThreshold > 254) config.triggerThreshold = 254;
+
+    axialActive = config.axialDeadzone > 0.0;
+    radialActive = config.radialDeadzone > 0.0 || config.antiDeadzone > 0.0 ||
+                   config.outerDeadzone > 0.0 || config.curve != 1.0;
+
+    // Same normalization the backends always used, with the axial deadzone folded in
+    xInputTable.resize(65536);
+    for (int raw = -32768; raw <= 32767; raw++) {
+        xInputTable[raw + 32768] = toFixed(applyAxialDeadzone(raw / 32767.0, config.axialDeadzone));
+    }
+    directInputTable.resize(65536);
+    for (int raw = 0; raw <= 65535; raw++) {
+        directInputTable[raw] = toFixed(applyAxialDeadzone(raw / 32767.5 - 1.0, config.axialDeadzone));
+    }
+    for (int raw = 0; raw <= 255; raw++) {
+        ds4Table[raw] = toFixed(applyAxialDeadzone(raw / 127.5 - 1.0, config.axialDeadzone));
+    }
+
+    radialScale.resize(RADIAL_TABLE_SIZE);
+    for (int i = 0; i < RADIAL_TABLE_SIZE; i++) {
+        double radius = std::sqrt(i * (MAX_RADIUS_SQUARED / (RADIAL_TABLE_SIZE - 1)));
+        radialScale[i] = radius > 0.0 ? (float)(conditionRadius(radius) / radius) : 0.0f;
+    }
+}
+
+double StickConditioner::conditionRadius(double radius) const {
+    if (radius <= config.radialDeadzone) return 0.0;
+
+    // Live range: deadzone edge -> full deflection (the outer deadzone, or the gate)
+    double fullRadius = config.outerDeadzone > 0.0 ? config.outerDeadzone : 1.0;
+    double t = (radius - config.radialDeadzone) / (fullRadius - config.radialDeadzone);
+    if (config.outerDeadzone > 0.0 && t > 1.0) t = 1.0;
+
+    // Square gate corners past full deflection stay linear when there's no clamp
+    double shaped = t <= 1.0 ? std::pow(t, config.curve) : t;
+    return config.antiDeadzone + (1.0 - config.antiDeadzone) * shaped;
+}
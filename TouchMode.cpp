@@ -5,17 +5,47 @@
 void ControllerMapper::initializeTouchInjection() {
     if (!inputInjectorInitialized) {
         try {
-            // Create UWP InputInjector - this should work WITHOUT touch hardware!
-            inputInjector = InputInjector::TryCreate();
-            
-            if (inputInjector) {
-                // Initialize for touch input with NO visualization (prevents on-screen keyboard)
-                inputInjector.InitializeTouchInjection(InjectedInputVisualizationMode::None);
+            if (replaying) {
+                // Replay runs the whole touch path but never injects - no injector needed
                 inputInjectorInitialized = true;
+            } else {
+                // Create UWP InputInjector - this should work WITHOUT touch hardware!
+                inputInjector = InputInjector::TryCreate();
+                
+                if (inputInjector) {
+                    // Initialize for touch input with NO visualization (prevents on-screen keyboard)
+                    inputInjector.InitializeTouchInjection(InjectedInputVisualizationMode::None);
+                    inputInjectorInitialized = true;
+                } else {
+                    std::cout << "Failed to create InputInjector - system may not support UWP input injection" << std::endl;
+                    return;
+                }
+            }
+            
+            // Build the contact pool now so frames never construct WinRT objects.
+            // Pressure/parameters/contact area never change, so they're set once here.
+            touchInfoPool.clear();
+            touchInfoPool.reserve(MAX_TOUCH_IDS);
+            for (int i = 0; i < MAX_TOUCH_IDS; i++) {
+                InjectedInputTouchInfo touchInfo;
+                touchInfo.Pressure(1.0);  // Full pressure
+                touchInfo.TouchParameters(
+                    InjectedInputTouchParameters::Pressure |
+                    InjectedInputTouchParameters::Contact
+                );
+                InjectedInputRectangle contactArea{};
+                contactArea.Left = DEFAULT_CONTACT_RADIUS;
+                contactArea.Top = DEFAULT_CONTACT_RADIUS;
+                contactArea.Bottom = DEFAULT_CONTACT_RADIUS;
+                contactArea.Right = DEFAULT_CONTACT_RADIUS;
+                touchInfo.Contact(contactArea);
+                touchInfoPool.push_back(touchInfo);
+                touchInfoPoolRadius[i] = DEFAULT_CONTACT_RADIUS;
+            }
+            
+            if (!replaying) {
                 std::cout << "UWP InputInjector initialized successfully!" << std::endl;
                 std::cout << "Touch injection enabled (no on-screen keyboard)" << std::endl;
-            } else {
-                std::cout << "Failed to create InputInjector - system may not support UWP input injection" << std::endl;
             }
         } catch (hresult_error const& ex) {
             std::wcout << L"Exception creating InputInjector: " << ex.message().c_str() << std::endl;
@@ -24,223 +54,21 @@ void ControllerMapper::initializeTouchInjection() {
     }
 }
 
-void ControllerMapper::getTouchCoordinates(double stickX, double stickY, LONG& touchX, LONG& touchY) {
+void ControllerMapper::getTouchCoordinates(double stickX, double stickY, LONG& touchX, LONG& touchY, int ring) {
     // Note: Button state is passed through static variables from handleTouchControl
-    // Get the actual overlay window position and size from Windows
-    RECT overlayRect;
-    GetWindowRect(overlayHwnd, &overlayRect);
-    int overlayWidth = overlayRect.right - overlayRect.left;
-    int overlayHeight = overlayRect.bottom - overlayRect.top;
-    
-    // Get actual overlay position in virtual screen coordinates
-    LONG overlayX = overlayRect.left;
-    LONG overlayY = overlayRect.top;
-    
-    // Detect which monitor the overlay is actually on (more reliable than cursor-based detection)
-    HMONITOR overlayMonitor = MonitorFromWindow(overlayHwnd, MONITOR_DEFAULTTONEAREST);
-    MONITORINFOEX overlayMonitorInfo = {};
-    overlayMonitorInfo.cbSize = sizeof(MONITORINFOEX);
-    LONG actualMonitorLeft = 0;
-    LONG actualMonitorTop = 0;
-    
-    if (GetMonitorInfo(overlayMonitor, (MONITORINFO*)&overlayMonitorInfo)) {
-        actualMonitorLeft = overlayMonitorInfo.rcMonitor.left;
-        actualMonitorTop = overlayMonitorInfo.rcMonitor.top;
-    } else {
-        // Fallback to detected monitor
-        actualMonitorLeft = monitorLeft;
-        actualMonitorTop = monitorTop;
-    }
-    
-    // Calculate center of overlay relative to the overlay window
-    int overlayCenterXRelative = overlayWidth / 2;
-    int overlayCenterYRelative = overlayHeight / 2;
-    
-    // Calculate touch position relative to overlay center
-    int touchXRelative = overlayCenterXRelative + (int)(stickX * overlayStickRadius);
-    int touchYRelative = overlayCenterYRelative - (int)(stickY * overlayStickRadius); // Invert Y
-    
-    // Calculate coordinates in virtual screen space using actual window position
-    LONG virtualX = overlayX + touchXRelative;
-    LONG virtualY = overlayY + touchYRelative;
-    
-    // Calculate position relative to the overlay's monitor
-    LONG relativeX = virtualX - actualMonitorLeft;
-    LONG relativeY = virtualY - actualMonitorTop;
-    
-    // Enumerate all monitors and calculate proper coordinate mapping
-    // InputInjector has "opposite monitor" behavior: send coordinates for "other" monitor,
-    // and InputInjector routes them back to current monitor
-    
-    // Structure to collect all monitor information
-    struct MonitorInfo {
-        HMONITOR handle;
-        RECT rect;
-        LONG left, top, right, bottom;
-        LONG width, height;
-        bool isPrimary;
-    };
-    
-    std::vector<MonitorInfo> allMonitors;
-    HMONITOR currentMonitor = overlayMonitor;
-    MonitorInfo currentMonitorInfo = {};
-    
-    // Enumerate all monitors and collect their information
-    struct MonitorEnumHelper {
-        static BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
-            std::vector<MonitorInfo>* monitors = reinterpret_cast<std::vector<MonitorInfo>*>(dwData);
-            
-            MONITORINFOEX monitorInfo = {};
-            monitorInfo.cbSize = sizeof(MONITORINFOEX);
-            
-            if (GetMonitorInfo(hMonitor, (MONITORINFO*)&monitorInfo)) {
-                MonitorInfo info;
-                info.handle = hMonitor;
-                info.rect = monitorInfo.rcMonitor;
-                info.left = monitorInfo.rcMonitor.left;
-                info.top = monitorInfo.rcMonitor.top;
-                info.right = monitorInfo.rcMonitor.right;
-                info.bottom = monitorInfo.rcMonitor.bottom;
-                info.width = info.right - info.left;
-                info.height = info.bottom - info.top;
-                
-                // Check if this is the primary monitor
-                HMONITOR primaryMonitor = MonitorFromPoint(POINT{0, 0}, MONITOR_DEFAULTTOPRIMARY);
-                info.isPrimary = (hMonitor == primaryMonitor);
-                
-                monitors->push_back(info);
-            }
-            return TRUE; // Continue enumeration
-        }
-    };
-    
-    EnumDisplayMonitors(nullptr, nullptr, MonitorEnumHelper::MonitorEnumProc, (LPARAM)&allMonitors);
-    
-    // Find the current monitor's info
-    MonitorInfo* currentInfo = nullptr;
-    MonitorInfo* otherInfo = nullptr;
-    
-    for (auto& monitor : allMonitors) {
-        if (monitor.handle == currentMonitor) {
-            currentInfo = &monitor;
-            break;
-        }
-    }
-    
-    // If we couldn't find current monitor, fall back
-    if (!currentInfo) {
-        touchX = virtualX;
-        touchY = virtualY;
-        return;
-    }
-    
-    // Find the "other" monitor (first monitor that's not the current one)
-    for (auto& monitor : allMonitors) {
-        if (monitor.handle != currentMonitor) {
-            otherInfo = &monitor;
-            break;
-        }
-    }
-    
-    // If only one monitor, use virtual coordinates directly
-    if (!otherInfo || allMonitors.size() <= 1) {
-        touchX = virtualX;
-        touchY = virtualY;
-        return;
-    }
-    
-    // Calculate mapping based on actual monitor layout
-    // Use currentInfo dimensions instead of overlayWidth/Height to avoid redeclaration
-    
-    // Scale relative position from current monitor to other monitor's coordinate space
-    double scaleX = (otherInfo->width == currentInfo->width) ? 1.0 : ((double)otherInfo->width / currentInfo->width);
-    double scaleY = (otherInfo->height == currentInfo->height) ? 1.0 : ((double)otherInfo->height / currentInfo->height);
-    
-    // Map relative position (within current monitor) to equivalent position in other monitor
-    LONG mappedRelativeX = (LONG)(relativeX * scaleX);
-    LONG mappedRelativeY = (LONG)(relativeY * scaleY);
-    
-    // Clamp mapped coordinates to other monitor's bounds
-    if (mappedRelativeX < 0) mappedRelativeX = 0;
-    if (mappedRelativeX >= otherInfo->width) mappedRelativeX = otherInfo->width - 1;
-    if (mappedRelativeY < 0) mappedRelativeY = 0;
-    if (mappedRelativeY >= otherInfo->height) mappedRelativeY = otherInfo->height - 1;
-    
-    // Calculate virtual screen coordinates for this position on the other monitor
-    LONG mappedX = otherInfo->left + mappedRelativeX;
-    LONG mappedY = otherInfo->top + mappedRelativeY;
-    
-    // Unified coordinate transformation for any monitor arrangement
-    // Strategy: Handle InputInjector's "opposite monitor" routing behavior
-    // InputInjector routes coordinates to the "opposite" monitor in certain arrangements
-    // We need to send coordinates that InputInjector will route back to the current monitor
-    
-    bool currentIsPrimary = currentInfo->isPrimary;
-    
-    // Find primary and secondary monitor info
-    MonitorInfo* primaryMonitorInfo = nullptr;
-    MonitorInfo* secondaryMonitorInfo = nullptr;
-    for (auto& monitor : allMonitors) {
-        if (monitor.isPrimary) {
-            primaryMonitorInfo = &monitor;
-        } else {
-            secondaryMonitorInfo = &monitor;
-        }
-    }
-    
-    if (!primaryMonitorInfo || !secondaryMonitorInfo) {
-        // Shouldn't happen with 2 monitors, but fallback
-        touchX = virtualX;
-        touchY = virtualY;
-        return;
+    // Refresh our copy of the monitor topology only when the main thread has rebuilt it
+    if (sharedTopology.version() != pollTopologyVersion) {
+        pollTopologyVersion = sharedTopology.read(pollTopology);
     }
+    const MonitorTopology& topology = pollTopology;
     
-    // Calculate relative positions of primary and secondary
-    bool primaryIsLeft = (primaryMonitorInfo->left < secondaryMonitorInfo->left);
-    bool primaryIsRight = (primaryMonitorInfo->left > secondaryMonitorInfo->left);
-    bool primaryIsAbove = (primaryMonitorInfo->top < secondaryMonitorInfo->top);
-    bool primaryIsBelow = (primaryMonitorInfo->top > secondaryMonitorInfo->top);
-    
-    // Calculate horizontal offset (absolute distance between monitors horizontally)
-    // Used for diagonal detection and coordinate calculations
-    LONG horizontalOffset = (secondaryMonitorInfo->left > primaryMonitorInfo->left) 
-        ? (secondaryMonitorInfo->left - primaryMonitorInfo->left)
-        : (primaryMonitorInfo->left - secondaryMonitorInfo->left);
-    bool isDiagonal = (horizontalOffset > 0); // Any horizontal offset = diagonal arrangement
-    
-    // InputInjector's "opposite monitor" routing behavior:
-    // - When primary is RIGHT of secondary: coordinates on primary route to secondary (wrong)
-    // - When primary is LEFT of secondary: virtual coordinates work correctly
-    // - When primary is BELOW secondary: coordinates may route wrong
-    // - When primary is ABOVE secondary: virtual coordinates work correctly on secondary, wrong on primary
-    
-    // X coordinate transformation
-    if (primaryIsRight && currentIsPrimary) {
-        // Primary RIGHT, on primary: use offset approach
-        // Send coordinate past current monitor (relativeX + width) that InputInjector will route back
-        touchX = relativeX + currentInfo->width;
-    } else if (primaryIsRight && !currentIsPrimary) {
-        // Primary RIGHT, on secondary: use mappedX (InputInjector routes back to current)
-        touchX = mappedX;
-    } else {
-        // Primary LEFT: virtual coordinates work correctly
-        touchX = virtualX;
-    }
-    
-    // Y coordinate transformation
-    if (primaryIsBelow && currentIsPrimary) {
-        // Primary BELOW, on primary: always use offset approach (works for both vertical and diagonal)
-        touchY = relativeY + currentInfo->height;
-    } else if (primaryIsBelow && !currentIsPrimary) {
-        // Primary BELOW, on secondary: use mappedY
-        touchY = mappedY;
-    } else if (primaryIsAbove && currentIsPrimary) {
-        // Primary ABOVE, on primary: virtualY works correctly
-        touchY = virtualY;
-    } else {
-        // Primary ABOVE and on secondary: virtualY works correctly
-        touchY = virtualY;
-    }
+    // Touch position relative to overlay center in pixels (Y inverted), shifted to the
+    // controller's ring, then the precomputed per-axis mapping handles InputInjector's
+    // "opposite monitor" routing
+    LONG stickPixelsX = (int)(stickX * topology.stickRadius) + topology.ringOffsetX[ring];
+    LONG stickPixelsY = -(int)(stickY * topology.stickRadius);
+    touchX = topology.touchXTransform.apply(stickPixelsX);
+    touchY = topology.touchYTransform.apply(stickPixelsY);
     
     // Debug: Log all monitor positions for troubleshooting
     // Print immediately when button is pressed (to catch wrong screen mapping quickly)
@@ -262,30 +90,22 @@ void ControllerMapper::getTouchCoordinates(double stickX, double stickY, LONG& t
     
     // Print monitor info only on button press (not at intervals)
     // This helps catch wrong screen mapping immediately when it happens
-    if (shouldPrintNow) {
-        std::cout << "=== ALL MONITORS ===" << std::endl;
-        for (size_t i = 0; i < allMonitors.size(); i++) {
-            const auto& m = allMonitors[i];
-            std::cout << "Monitor " << i << ": " << m.width << "x" << m.height 
-                      << " at (" << m.left << ", " << m.top << ")"
-                      << (m.isPrimary ? " [PRIMARY]" : " [SECONDARY]")
-                      << (m.handle == currentMonitor ? " [CURRENT]" : "")
-                      << (m.handle == otherInfo->handle ? " [OTHER]" : "") << std::endl;
-        }
-        std::cout << "Current: relative=(" << relativeX << "," << relativeY 
-                  << ") mappedRelative=(" << mappedRelativeX << "," << mappedRelativeY
-                  << ") mappedVirtual=(" << mappedX << "," << mappedY
-                  << ") virtualX/Y=(" << virtualX << "," << virtualY
-                  << ") final=(" << touchX << "," << touchY << ")" << std::endl;
-        std::cout << "Primary status: Current=" << (currentIsPrimary ? "PRIMARY" : "SECONDARY")
-                  << " Other=" << (otherInfo->isPrimary ? "PRIMARY" : "SECONDARY") << std::endl;
-        std::cout << "Arrangement: primaryIsLeft=" << primaryIsLeft
-                  << " primaryIsRight=" << primaryIsRight
-                  << " primaryIsAbove=" << primaryIsAbove
-                  << " primaryIsBelow=" << primaryIsBelow << std::endl;
-        std::cout << "Routing: useOppositeX=" << primaryIsRight
-                  << " useOppositeY=" << ((primaryIsBelow && !currentIsPrimary) || (primaryIsAbove && currentIsPrimary)) << std::endl;
-        std::cout << "----------------------------------------" << std::endl;
+    // Debug level - compiled out of release builds
+    if (logLevelEnabled(LogLevel::Debug) && shouldPrintNow) {
+        MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "=== ALL MONITORS ===");
+        for (int i = 0; i < topology.monitorCount; i++) {
+            const auto& m = topology.monitors[i];
+            MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "Monitor %d: %ldx%ld at (%ld, %ld)%s%s%s", i, m.width, m.height, m.left, m.top,
+                       m.isPrimary ? " [PRIMARY]" : " [SECONDARY]",
+                       i == topology.currentIndex ? " [CURRENT]" : "",
+                       i == topology.otherIndex ? " [OTHER]" : "");
+        }
+        MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "Current: virtualX/Y=(%ld,%ld) final=(%ld,%ld)",
+                   topology.overlayCenterX + stickPixelsX, topology.overlayCenterY + stickPixelsY, touchX, touchY);
+        MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "Routing: mappedX=%d offsetX=%ld mappedY=%d offsetY=%ld",
+                   (int)topology.touchXTransform.mapped, topology.touchXTransform.offset,
+                   (int)topology.touchYTransform.mapped, topology.touchYTransform.offset);
+        MAPPER_LOG(asyncLog.poll, LogLevel::Debug, "----------------------------------------");
     }
     
     // Don't clamp - let InputInjector handle it, clamping might interfere
@@ -293,19 +113,15 @@ void ControllerMapper::getTouchCoordinates(double stickX, double stickY, LONG& t
 
 void ControllerMapper::pixelToHimetric(LONG pixelX, LONG pixelY, LONG& himetricX, LONG& himetricY) {
     // Convert pixel coordinates to HIMETRIC (hundredths of a millimeter)
-    // Use DPI from the detected monitor
-    MONITORINFOEX monitorInfoEx = {};
-    monitorInfoEx.cbSize = sizeof(MONITORINFOEX);
+    // Use cached DPI of the overlay's monitor (the overlay follows the detected monitor)
+    if (sharedTopology.version() != pollTopologyVersion) {
+        pollTopologyVersion = sharedTopology.read(pollTopology);
+    }
     int dpiX = 96; // Default DPI fallback
     int dpiY = 96;
-    
-    if (GetMonitorInfo(monitorHandle, (MONITORINFO*)&monitorInfoEx)) {
-        HDC monitorDC = CreateDC(TEXT("DISPLAY"), monitorInfoEx.szDevice, nullptr, nullptr);
-        if (monitorDC) {
-            dpiX = GetDeviceCaps(monitorDC, LOGPIXELSX);
-            dpiY = GetDeviceCaps(monitorDC, LOGPIXELSY);
-            DeleteDC(monitorDC);
-        }
+    if (pollTopology.currentIndex >= 0) {
+        dpiX = pollTopology.monitors[pollTopology.currentIndex].dpiX;
+        dpiY = pollTopology.monitors[pollTopology.currentIndex].dpiY;
     }
     
     // HIMETRIC calculation: (pixels * 2540) / DPI
@@ -314,15 +130,19 @@ void ControllerMapper::pixelToHimetric(LONG pixelX, LONG pixelY, LONG& himetricX
 }
 
 InjectedInputTouchInfo ControllerMapper::createTouchInfo(int touchId, double stickX, double stickY, bool isDown, bool isUp) {
-    return createTouchInfo(touchId, stickX, stickY, isDown, isUp, 15); // Default 30x30px (15px radius)
+    return createTouchInfo(touchId, stickX, stickY, isDown, isUp, DEFAULT_CONTACT_RADIUS);
 }
 
 InjectedInputTouchInfo ControllerMapper::createTouchInfo(int touchId, double stickX, double stickY, bool isDown, bool isUp, int contactRadius) {
-    InjectedInputTouchInfo touchInfo{};
+    // Pooled record for this ID (the returned copy only shares the reference), or a
+    // fresh one if the pool isn't built / the ID is out of range
+    bool pooled = (touchId >= 0 && touchId < (int)touchInfoPool.size());
+    InjectedInputTouchInfo touchInfo = pooled ? touchInfoPool[touchId] : InjectedInputTouchInfo();
     
-    // Get screen coordinates (in pixels)
+    // Get screen coordinates (in pixels) - the ID block says which controller's ring this is on
     LONG touchX, touchY;
-    getTouchCoordinates(stickX, stickY, touchX, touchY);
+    int ring = (touchId >= 0 && touchId < MAX_TOUCH_IDS) ? touchId / TOUCHES_PER_CONTROLLER : 0;
+    getTouchCoordinates(stickX, stickY, touchX, touchY, ring);
     
     // Create pixel location structure
     InjectedInputPoint pixelLocation{};
@@ -353,140 +173,198 @@ InjectedInputTouchInfo ControllerMapper::createTouchInfo(int touchId, double sti
     // InjectedInputTouchInfo uses setter methods (not direct assignment)
     touchInfo.PointerInfo(pointerInfo);
     
-    // Set touch parameters (using setter methods)
-    touchInfo.Pressure(1.0);  // Full pressure
-    touchInfo.TouchParameters(
-        InjectedInputTouchParameters::Pressure |
-        InjectedInputTouchParameters::Contact
-    );
-    
-    // Set contact area (contactRadius pixels on each side from center)
-    InjectedInputRectangle contactArea{};
-    contactArea.Left = contactRadius;
-    contactArea.Top = contactRadius;
-    contactArea.Bottom = contactRadius;
-    contactArea.Right = contactRadius;
-    touchInfo.Contact(contactArea);
+    // Pooled records already carry pressure/parameters; only touch the contact area if it changed
+    if (!pooled || touchInfoPoolRadius[touchId] != contactRadius) {
+        if (!pooled) {
+            touchInfo.Pressure(1.0);  // Full pressure
+            touchInfo.TouchParameters(
+                InjectedInputTouchParameters::Pressure |
+                InjectedInputTouchParameters::Contact
+            );
+        } else {
+            touchInfoPoolRadius[touchId] = contactRadius;
+        }
+        
+        // Set contact area (contactRadius pixels on each side from center)
+        InjectedInputRectangle contactArea{};
+        contactArea.Left = contactRadius;
+        contactArea.Top = contactRadius;
+        contactArea.Bottom = contactRadius;
+        contactArea.Right = contactRadius;
+        touchInfo.Contact(contactArea);
+    }
     
     return touchInfo;
 }
 
 void ControllerMapper::sendMultipleTouches(const std::vector<InjectedInputTouchInfo>& touches) {
-    if (!inputInjectorInitialized || !inputInjector || touches.empty()) return;
+    if (!inputInjectorInitialized || touches.empty()) return;
+    
+    perfCounters.add(perfCounters.injectCalls);
+    perfCounters.add(perfCounters.injectContacts, touches.size());
+    
+    // Replay measures everything up to the injection itself
+    if (replaying) {
+        if (currentSampleTicks != 0) {
+            sampleToInjectLatency.record(currentSampleTicks, qpcNow());
+        }
+        return;
+    }
     
     try {
         inputInjector.InjectTouchInput(touches);
+        if (currentSampleTicks != 0) {
+            sampleToInjectLatency.record(currentSampleTicks, qpcNow());
+        }
     } catch (hresult_error const& ex) {
         static int errorCount = 0;
         if (errorCount < 3) {
-            std::wcout << L"[Touch] Failed: " << ex.message().c_str() << std::endl;
-            std::cout << "Error: 0x" << std::hex << ex.code() << std::dec << std::endl;
+            MAPPER_LOG(asyncLog.poll, LogLevel::Error, "[Touch] Failed: %ls (0x%08X)", ex.message().c_str(), (unsigned)ex.code().value);
             errorCount++;
             if (errorCount >= 3) {
-                std::cout << "(Further errors suppressed)" << std::endl;
+                MAPPER_LOG(asyncLog.poll, LogLevel::Error, "(Further errors suppressed)");
             }
         }
     }
 }
 
-void ControllerMapper::sendPalmTouch(double centerX, double centerY, int centerTouchId, int cornerStartId, bool isDown, bool isUp) {
-    if (!inputInjectorInitialized || !inputInjector) return;
+void ControllerMapper::queueTouch(int touchId, double stickX, double stickY, TouchPhase phase) {
+    if (!inputInjectorInitialized) return;
+    if (touchId < 0 || touchId >= MAX_TOUCH_IDS) return;
+    
+    TouchFrameEntry& entry = touchFrame[touchId];
+    if (entry.pending) {
+        if (entry.phase == TouchPhase::Down && phase == TouchPhase::Update) {
+            // Down + Update -> Down at the newer position
+            entry.x = stickX;
+            entry.y = stickY;
+            return;
+        }
+        if (entry.phase == TouchPhase::Up && phase == TouchPhase::Update) {
+            return;  // Contact is already lifting this frame
+        }
+        if ((entry.phase == TouchPhase::Down && phase == TouchPhase::Up) ||
+            (entry.phase == TouchPhase::Up && phase == TouchPhase::Down)) {
+            // A pointer can't go down and up in the same frame - send what we have first
+            flushTouchFrame();
+        }
+        // Update + Update / Update + Up -> the later transition wins
+    }
     
-    // Get center screen coordinates
-    LONG centerScreenX, centerScreenY;
-    getTouchCoordinates(centerX, centerY, centerScreenX, centerScreenY);
+    entry.pending = true;
+    entry.phase = phase;
+    entry.x = stickX;
+    entry.y = stickY;
+    touchFramePending = true;
+}
+
+void ControllerMapper::flushTouchFrame() {
+    if (!touchFramePending) return;
+    touchFramePending = false;
+    
+    // One frame = every pending transition plus an update for every other contact still
+    // down, across all controllers
+    touchFrameBuffer.clear();
+    int touchIdCount = controllerCount * TOUCHES_PER_CONTROLLER;
+    for (int touchId = 0; touchId < touchIdCount; touchId++) {
+        TouchFrameEntry& entry = touchFrame[touchId];
+        if (entry.pending) {
+            entry.pending = false;
+            touchFrameBuffer.push_back(createTouchInfo(touchId, entry.x, entry.y,
+                                                       entry.phase == TouchPhase::Down, entry.phase == TouchPhase::Up));
+            injectedTouchActive[touchId] = (entry.phase != TouchPhase::Up);
+            injectedTouchX[touchId] = entry.x;
+            injectedTouchY[touchId] = entry.y;
+        } else if (injectedTouchActive[touchId]) {
+            touchFrameBuffer.push_back(createTouchInfo(touchId, injectedTouchX[touchId], injectedTouchY[touchId], false, false));
+        }
+    }
+    
+    sendMultipleTouches(touchFrameBuffer);
+}
+
+void ControllerMapper::sendPalmTouch(double centerX, double centerY, int centerTouchId, int cornerStartId, bool isDown, bool isUp) {
+    if (!inputInjectorInitialized) return;
     
     // Calculate offsets for 9-touch pattern (center + 8 around at 45° intervals)
     const int radius = X_PATTERN_RADIUS_PIXELS;
     
-    std::vector<InjectedInputTouchInfo> touches;
-    
     // Convert pixel radius to stick coordinate offsets (use double division to avoid integer division)
     double offsetStick = ((double)radius / (double)overlayStickRadius);
     
-    // Create center touch
-    touches.push_back(createTouchInfo(centerTouchId, centerX, centerY, isDown, isUp));
-    
-    // Create 8 touches around the center at 0°, 45°, 90°, 135°, 180°, 225°, 270°, 315°
-    const double angles[8] = {0.0, 45.0, 90.0, 135.0, 180.0, 225.0, 270.0, 315.0};
-    const double angleRad[8] = {0.0, PI/4, PI/2, 3*PI/4, PI, 5*PI/4, 3*PI/2, 7*PI/4};
-    
+    // Center touch first, then 8 touches around it at 0°, 45°, 90°, 135°, 180°, 225°, 270°, 315°
+    int ids[9];
+    double xs[9], ys[9];
+    ids[0] = centerTouchId;
+    xs[0] = centerX;
+    ys[0] = centerY;
     for (int i = 0; i < 8; i++) {
-        double offsetX = offsetStick * std::cos(angleRad[i]);
-        double offsetY = offsetStick * std::sin(angleRad[i]);
-        double cornerX = centerX + offsetX;
-        double cornerY = centerY + offsetY;
-        touches.push_back(createTouchInfo(cornerStartId + i, cornerX, cornerY, isDown, isUp));
+        ids[i + 1] = cornerStartId + i;
+        xs[i + 1] = centerX + offsetStick * PALM_OFFSET_X[i];
+        ys[i + 1] = centerY + offsetStick * PALM_OFFSET_Y[i];
     }
     
     // Update touch tracking for overlay (center + 8 touches = 9 total)
-    // Helper lambda to update touch position
-    auto updateTouchPosition = [&](int touchId, double x, double y) {
-        if (touchId >= 0 && touchId < 20) {
+    for (int i = 0; i < 9; i++) {
+        int touchId = ids[i];
+        if (touchId >= 0 && touchId < MAX_TOUCH_IDS) {
             if (isDown) {
                 touchActive[touchId] = true;
-                touchX[touchId] = x;
-                touchY[touchId] = y;
+                touchX[touchId] = xs[i];
+                touchY[touchId] = ys[i];
             } else if (isUp) {
                 touchActive[touchId] = false;
             } else {
-                touchX[touchId] = x;
-                touchY[touchId] = y;
+                touchX[touchId] = xs[i];
+                touchY[touchId] = ys[i];
             }
         }
-    };
-    
-    updateTouchPosition(centerTouchId, centerX, centerY);
-    
-    for (int i = 0; i < 8; i++) {
-        int touchId = cornerStartId + i;
-        double offsetX = offsetStick * std::cos(angleRad[i]);
-        double offsetY = offsetStick * std::sin(angleRad[i]);
-        double cornerX = centerX + offsetX;
-        double cornerY = centerY + offsetY;
-        updateTouchPosition(touchId, cornerX, cornerY);
     }
     
-    try {
-        if (isDown) {
-            // On DOWN: Send individually with small delay to ensure registration
-            // Send center first, then around touches
-            for (size_t i = 0; i < touches.size(); i++) {
-                std::vector<InjectedInputTouchInfo> singleTouch;
-                singleTouch.push_back(touches[i]);
-                inputInjector.InjectTouchInput(singleTouch);
-                if (i < touches.size() - 1) { // Don't sleep after last touch
-                    Sleep(0); // Small delay to ensure each touch is registered
-                }
-            }
-        } else if (isUp) {
-            // On UP: Send individually to ensure all are released
-            for (const auto& touch : touches) {
-                std::vector<InjectedInputTouchInfo> singleTouch;
-                singleTouch.push_back(touch);
-                inputInjector.InjectTouchInput(singleTouch);
-                Sleep(0); // Small delay
+    if (isDown || isUp) {
+        // Anything already queued goes out first so order is preserved
+        TouchPhase phase = isDown ? TouchPhase::Down : TouchPhase::Up;
+        flushTouchFrame();
+        LONGLONG firstContactTicks = qpcNow();
+        
+        if (palmInjectionMode == PalmInjectionMode::Atomic) {
+            // Whole pattern in one pointer frame
+            for (int i = 0; i < 9; i++) {
+                queueTouch(ids[i], xs[i], ys[i], phase);
             }
+            flushTouchFrame();
         } else {
-            // On UPDATE: Send all together to maintain held state efficiently
-            inputInjector.InjectTouchInput(touches);
+            // One contact per frame, center first, for receivers that drop simultaneous contacts
+            for (int i = 0; i < 9; i++) {
+                queueTouch(ids[i], xs[i], ys[i], phase);
+                flushTouchFrame();
+                if (i < 8) { // Don't wait after last touch
+                    if (palmInjectionMode == PalmInjectionMode::Staggered) {
+                        spinWaitMicroseconds(palmStaggerUs);
+                    } else {
+                        Sleep(0);
+                    }
+                }
+            }
         }
-    } catch (hresult_error const& ex) {
-        static int errorCount = 0;
-        if (errorCount < 3) {
-            std::wcout << L"[L3/R3] Injection failed: " << ex.message().c_str() << std::endl;
-            std::cout << "Error: 0x" << std::hex << ex.code() << std::dec << std::endl;
-            errorCount++;
-            if (errorCount >= 3) std::cout << "[L3/R3] (Further errors suppressed)" << std::endl;
+        
+        if (isDown) {
+            // Measured up to the return of the last injection, so atomic mode shows the call cost
+            lastPalmSpreadUs = (qpcNow() - firstContactTicks) * 1000000.0 / qpcFrequency();
+        }
+    } else {
+        // On UPDATE: joins the rest of this sample's frame
+        for (int i = 0; i < 9; i++) {
+            queueTouch(ids[i], xs[i], ys[i], TouchPhase::Update);
         }
     }
 }
 
 void ControllerMapper::sendTouch(int touchId, double stickX, double stickY, bool isDown, bool isUp) {
-    if (!inputInjectorInitialized || !inputInjector) return;
+    if (!inputInjectorInitialized) return;
     
     // Update touch tracking for overlay
-    if (touchId >= 0 && touchId < 20) {
+    if (touchId >= 0 && touchId < MAX_TOUCH_IDS) {
         if (isDown) {
             touchActive[touchId] = true;
             touchX[touchId] = stickX;
@@ -499,45 +377,173 @@ void ControllerMapper::sendTouch(int touchId, double stickX, double stickY, bool
         }
     }
     
-    // Use the helper function to create touch info
-    InjectedInputTouchInfo touchInfo = createTouchInfo(touchId, stickX, stickY, isDown, isUp);
+    // Queued - goes out with every other contact when the frame is flushed
+    queueTouch(touchId, stickX, stickY,
+               isDown ? TouchPhase::Down : isUp ? TouchPhase::Up : TouchPhase::Update);
     
-    try {
-        // Get coordinates for debug output
+    static bool firstSuccess = true;
+    if (firstSuccess && isDown) {
         LONG touchX, touchY;
-        getTouchCoordinates(stickX, stickY, touchX, touchY);
-        
-        // Create collection and inject
-        std::vector<InjectedInputTouchInfo> touchData;
-        touchData.push_back(touchInfo);
-        
-        inputInjector.InjectTouchInput(touchData);
-        
-        static bool firstSuccess = true;
-        if (firstSuccess && isDown) {
-            std::cout << "[Touch] Enabled: Touch " << touchId << " at (" << touchX << "," << touchY << ")" << std::endl;
-            firstSuccess = false;
+        getTouchCoordinates(stickX, stickY, touchX, touchY, touchId / TOUCHES_PER_CONTROLLER);
+        MAPPER_LOG(asyncLog.poll, LogLevel::Info, "[Touch] Enabled: Touch %d at (%ld,%ld)", touchId, touchX, touchY);
+        firstSuccess = false;
+    }
+}
+
+// ========== Slide Prediction ==========
+
+void StickPredictor::add(double x, double y, LONGLONG ticks) {
+    int last = (next + HISTORY - 1) % HISTORY;
+    if (count > 0 && (ticks - times[last]) * 1000.0 / qpcFrequency() > MAX_GAP_MS) {
+        count = 0;  // Stale history would predict from motion that already ended
+    }
+    xs[next] = x;
+    ys[next] = y;
+    times[next] = ticks;
+    next = (next + 1) % HISTORY;
+    if (count < HISTORY) count++;
+}
+
+void StickPredictor::predict(double lookaheadMs, double& x, double& y) const {
+    if (count < 3) return;  // Not enough samples for a velocity
+    
+    // Least-squares velocity over the samples inside the window, times relative to the latest
+    int last = (next + HISTORY - 1) % HISTORY;
+    double msPerTick = 1000.0 / qpcFrequency();
+    double t[HISTORY];
+    int used = 0;
+    double sumT = 0.0, sumX = 0.0, sumY = 0.0;
+    for (int i = 0; i < count; i++) {
+        int index = (last - i + HISTORY) % HISTORY;
+        double age = (times[index] - times[last]) * msPerTick;  // <= 0
+        if (-age > WINDOW_MS) break;
+        t[used] = age;
+        sumT += age;
+        sumX += xs[index];
+        sumY += ys[index];
+        used++;
+    }
+    if (used < 3) return;
+    
+    double meanT = sumT / used, meanX = sumX / used, meanY = sumY / used;
+    double varT = 0.0, covX = 0.0, covY = 0.0;
+    for (int i = 0; i < used; i++) {
+        int index = (last - i + HISTORY) % HISTORY;
+        double dt = t[i] - meanT;
+        varT += dt * dt;
+        covX += dt * (xs[index] - meanX);
+        covY += dt * (ys[index] - meanY);
+    }
+    if (varT < 1e-6) return;  // All samples at the same instant (buffered edges)
+    
+    // Extrapolate from the latest sample, capped so a flick can't throw the touch across the ring
+    double offsetX = covX / varT * lookaheadMs;
+    double offsetY = covY / varT * lookaheadMs;
+    double offset = std::sqrt(offsetX * offsetX + offsetY * offsetY);
+    if (offset > MAX_OFFSET) {
+        offsetX *= MAX_OFFSET / offset;
+        offsetY *= MAX_OFFSET / offset;
+    }
+    double predictedX = xs[last] + offsetX;
+    double predictedY = ys[last] + offsetY;
+    
+    // The stick can't leave its gate, so neither can the prediction
+    double radius = std::sqrt(predictedX * predictedX + predictedY * predictedY);
+    double maxRadius = std::sqrt(xs[last] * xs[last] + ys[last] * ys[last]);
+    if (maxRadius < 1.0) maxRadius = 1.0;
+    if (radius > maxRadius) {
+        predictedX *= maxRadius / radius;
+        predictedY *= maxRadius / radius;
+    }
+    x = predictedX;
+    y = predictedY;
+}
+
+void ControllerMapper::predictTouchPositions(ControllerSlot& slot, const ControllerSample& sample,
+                                             double& leftX, double& leftY, double& rightX, double& rightY) {
+    slot.leftPredictor.add(sample.leftX, sample.leftY, sample.timestamp);
+    slot.rightPredictor.add(sample.rightX, sample.rightY, sample.timestamp);
+    
+    // Locked paths (L2/R2) are already exact straight lines between arcs - leave them alone
+    if (!sample.l2 && !slot.leftPointerLocked) {
+        slot.leftPredictor.predict(predictionMs, leftX, leftY);
+    }
+    if (!sample.r2 && !slot.rightPointerLocked) {
+        slot.rightPredictor.predict(predictionMs, rightX, rightY);
+    }
+}
+
+// ========== Touch Upsampling ==========
+// Controllers report at 250Hz, the poll deadlines run at up to touchUpsampleHz and every
+// deadline re-sends the latest state. Instead of holding a touch still until the next
+// report and then jumping, each report starts a segment from where the touch is towards
+// the report, and the deadlines in between walk it there over one report interval.
+
+static bool sameButtons(const ControllerSample& a, const ControllerSample& b) {
+    return a.l1 == b.l1 && a.r1 == b.r1 && a.l2 == b.l2 && a.r2 == b.r2 && a.l3 == b.l3 && a.r3 == b.r3;
+}
+
+static bool sameSticks(const ControllerSample& a, const ControllerSample& b) {
+    return a.leftX == b.leftX && a.leftY == b.leftY && a.rightX == b.rightX && a.rightY == b.rightY;
+}
+
+void ControllerMapper::upsampleTouchPositions(ControllerSlot& slot, const ControllerSample& sample,
+                                              double& leftX, double& leftY, double& rightX, double& rightY) {
+    double target[4] = { leftX, leftY, rightX, rightY };
+    
+    if (!slot.upsampleValid || !sameButtons(sample, slot.upsampleLastSample)) {
+        // Presses and releases land exactly where the report put the stick
+        for (int i = 0; i < 4; i++) {
+            slot.upsampleFrom[i] = slot.upsampleTo[i] = slot.upsampleCurrent[i] = target[i];
         }
-        
-    } catch (hresult_error const& ex) {
-        static int errorCount = 0;
-        if (errorCount < 3) {
-            std::wcout << L"[Touch] Failed: " << ex.message().c_str() << std::endl;
-            std::cout << "Error: 0x" << std::hex << ex.code() << std::dec << std::endl;
-            errorCount++;
-            if (errorCount >= 3) {
-                std::cout << "(Further errors suppressed)" << std::endl;
+        slot.upsampleSegmentStart = sample.timestamp;
+        slot.upsampleLastSample = sample;
+        slot.upsampleValid = true;
+        return;
+    }
+    
+    if (!sameSticks(sample, slot.upsampleLastSample)) {
+        // A new report - the DS4 path measures the report rate itself, other backends are
+        // timed here from the reports that moved a stick
+        if (slot.ds4Handle && slot.ds4ReportIntervalMs > 0.0) {
+            slot.upsampleIntervalMs = slot.ds4ReportIntervalMs;
+        } else {
+            double intervalMs = (sample.timestamp - slot.upsampleSegmentStart) * 1000.0 / qpcFrequency();
+            if (intervalMs > 0.0 && intervalMs < MAX_UPSAMPLE_INTERVAL_MS) {
+                slot.upsampleIntervalMs += (intervalMs - slot.upsampleIntervalMs) * 0.1;
             }
         }
+        for (int i = 0; i < 4; i++) {
+            slot.upsampleFrom[i] = slot.upsampleCurrent[i];
+        }
+        slot.upsampleSegmentStart = sample.timestamp;
+        slot.upsampleLastSample = sample;
     }
+    
+    // The end point follows the target even on repeats, so a predicted target keeps moving
+    for (int i = 0; i < 4; i++) {
+        slot.upsampleTo[i] = target[i];
+    }
+    
+    double progress = (sample.timestamp - slot.upsampleSegmentStart) * 1000.0 / qpcFrequency() / slot.upsampleIntervalMs;
+    if (progress < 0.0) progress = 0.0;
+    if (progress > 1.0) progress = 1.0;
+    for (int i = 0; i < 4; i++) {
+        slot.upsampleCurrent[i] = slot.upsampleFrom[i] + (slot.upsampleTo[i] - slot.upsampleFrom[i]) * progress;
+    }
+    
+    leftX = slot.upsampleCurrent[0];
+    leftY = slot.upsampleCurrent[1];
+    rightX = slot.upsampleCurrent[2];
+    rightY = slot.upsampleCurrent[3];
 }
 
-void ControllerMapper::sendBothTouchesIfActive(double leftX, double leftY, double rightX, double rightY,
+void ControllerMapper::sendBothTouchesIfActive(const ControllerSlot& slot, double leftX, double leftY, double rightX, double rightY,
                              double leftLockedX, double leftLockedY, bool leftLocked,
                              double rightLockedX, double rightLockedY, bool rightLocked) {
     // Only send both touches if both are active
-    if (!leftTouchActive || !rightTouchActive) return;
-    if (!inputInjectorInitialized || !inputInjector) return;
+    if (!slot.leftTouchActive || !slot.rightTouchActive) return;
+    if (!inputInjectorInitialized) return;
     
     // Calculate final send positions (locked or unlocked)
     double leftSendX = leftLocked ? leftLockedX : leftX;
@@ -546,42 +552,21 @@ void ControllerMapper::sendBothTouchesIfActive(double leftX, double leftY, doubl
     double rightSendY = rightLocked ? rightLockedY : rightY;
     
     // Update touch tracking for overlay (same as sendTouch does)
-    if (0 >= 0 && 0 < 20) {
-        touchX[0] = leftSendX;
-        touchY[0] = leftSendY;
-    }
-    if (1 >= 0 && 1 < 20) {
-        touchX[1] = rightSendX;
-        touchY[1] = rightSendY;
-    }
-    
-    try {
-        std::vector<InjectedInputTouchInfo> touchData;
-        
-        // Add left touch
-        touchData.push_back(createTouchInfo(0, leftSendX, leftSendY, false, false));
-        
-        // Add right touch
-        touchData.push_back(createTouchInfo(1, rightSendX, rightSendY, false, false));
-        
-        // Send both touches together
-        sendMultipleTouches(touchData);
-    } catch (hresult_error const& ex) {
-        static int errorCount = 0;
-        if (errorCount < 3) {
-            std::wcout << L"[Touch] Multi-touch failed: " << ex.message().c_str() << std::endl;
-            std::cout << "Error: 0x" << std::hex << ex.code() << std::dec << std::endl;
-            errorCount++;
-            if (errorCount >= 3) {
-                std::cout << "(Further errors suppressed)" << std::endl;
-            }
-        }
-    }
+    int leftId = slot.touchIdBase + 0;
+    int rightId = slot.touchIdBase + 1;
+    touchX[leftId] = leftSendX;
+    touchY[leftId] = leftSendY;
+    touchX[rightId] = rightSendX;
+    touchY[rightId] = rightSendY;
+    
+    // Both land in the same frame
+    queueTouch(leftId, leftSendX, leftSendY, TouchPhase::Update);
+    queueTouch(rightId, rightSendX, rightSendY, TouchPhase::Update);
 }
 
 void ControllerMapper::handleTouchMovementUpdate(int touchId, bool& touchActive, bool bumperPressed, bool stickPressPressed,
                                   int& heldDirection, bool& lockedState, int& lockedDirection,
-                                  double currentX, double currentY, double currentAngle, int currentDirection,
+                                  double currentX, double currentY, int currentDirection,
                                   bool skipIfOtherActive) {
     // Early return if touch is not active or neither L1/R1 nor stick press is pressed
     if (!touchActive || (!bumperPressed && !stickPressPressed)) return;
@@ -595,7 +580,7 @@ void ControllerMapper::handleTouchMovementUpdate(int touchId, bool& touchActive,
     
     if (shouldCheckLocking) {
         int newLockedDirection;
-        if (checkPointerLock(heldDirection, currentDirection, currentAngle, newLockedDirection)) {
+        if (checkPointerLock(heldDirection, currentDirection, currentX, currentY, newLockedDirection)) {
             // Update locked direction if it changed
             if (!lockedState || lockedDirection != newLockedDirection) {
                 lockedState = true;
@@ -625,7 +610,7 @@ void ControllerMapper::handleTouchMovementUpdate(int touchId, bool& touchActive,
         if (lockedState) {
             lockedState = false;
             lockedDirection = -1;
-            std::cout << (touchId == 0 ? "Left" : "Right") << " pointer UNLOCKED" << std::endl;
+            MAPPER_LOG(asyncLog.poll, LogLevel::Info, "%s pointer UNLOCKED", touchId % TOUCHES_PER_CONTROLLER == 0 ? "Left" : "Right");
         }
         // Skip individual send if both touches are active (will send both together at end)
         if (!skipIfOtherActive) {
@@ -634,7 +619,7 @@ void ControllerMapper::handleTouchMovementUpdate(int touchId, bool& touchActive,
     }
 }
 
-void ControllerMapper::handleTouchControl(bool l1, bool r1, bool l2, bool r2, bool l3, bool r3, double leftX, double leftY, double rightX, double rightY) {
+void ControllerMapper::handleTouchControl(ControllerSlot& slot, bool l1, bool r1, bool l2, bool r2, bool l3, bool r3, double leftX, double leftY, double rightX, double rightY) {
     // Update static button state for debug output in getTouchCoordinates
     bool newButtonState = (l1 || r1 || l2 || r2 || l3 || r3);
     
@@ -645,179 +630,180 @@ void ControllerMapper::handleTouchControl(bool l1, bool r1, bool l2, bool r2, bo
     
     g_prevAnyButtonPressed = g_anyButtonPressed;
     g_anyButtonPressed = newButtonState;
-    // Calculate angles and directions (like in keyboard mode) - for future use
-    double lAngle = calculateAngle(leftX, leftY);
-    double rAngle = calculateAngle(rightX, rightY);
-    int lDirection = getDirection(lAngle);
-    int rDirection = getDirection(rAngle);
+    // This controller's block of touch IDs: 0/1 = L/R touch, 2-9 and 10-17 = palm corners
+    const int idBase = slot.touchIdBase;
+    
+    // Calculate directions (like in keyboard mode)
+    int lDirection = getStickDirection(leftX, leftY);
+    int rDirection = getStickDirection(rightX, rightY);
     
     // Detect L2/R2 press edges for pointer locking
-    bool l2Pressed = l2 && !prevL2;
-    bool r2Pressed = r2 && !prevR2;
-    bool l2Released = !l2 && prevL2;
-    bool r2Released = !r2 && prevR2;
+    bool l2Pressed = l2 && !slot.prevL2;
+    bool r2Pressed = r2 && !slot.prevR2;
+    bool l2Released = !l2 && slot.prevL2;
+    bool r2Released = !r2 && slot.prevR2;
     
     // Detect L3/R3 press edges (kept for future use)
-    bool l3Pressed = l3 && !prevL3;
-    bool r3Pressed = r3 && !prevR3;
-    bool l3Released = !l3 && prevL3;
-    bool r3Released = !r3 && prevR3;
+    bool l3Pressed = l3 && !slot.prevL3;
+    bool r3Pressed = r3 && !slot.prevR3;
+    bool l3Released = !l3 && slot.prevL3;
+    bool r3Released = !r3 && slot.prevR3;
     
     // Detect L1/R1 press edges for touch input
-    bool l1Pressed = l1 && !prevL1;
-    bool r1Pressed = r1 && !prevR1;
-    bool l1Released = !l1 && prevL1;
-    bool r1Released = !r1 && prevR1;
+    bool l1Pressed = l1 && !slot.prevL1;
+    bool r1Pressed = r1 && !slot.prevR1;
+    bool l1Released = !l1 && slot.prevL1;
+    bool r1Released = !r1 && slot.prevR1;
     
     // Handle L2/R2 based pointer locking and touch events
     // L2 controls left touch locking
     if (l2Pressed) {
-        currentLHeldDirection = lDirection; // Capture current direction when L2 pressed
-        currentLHeldX = leftX; // Capture actual stick position
-        currentLHeldY = leftY;
-        leftTouchActive = true; // Start touch event
-        sendTouch(0, leftX, leftY, true, false); // Touch down
+        slot.currentLHeldDirection = lDirection; // Capture current direction when L2 pressed
+        slot.currentLHeldX = leftX; // Capture actual stick position
+        slot.currentLHeldY = leftY;
+        slot.leftTouchActive = true; // Start touch event
+        sendTouch(idBase + 0, leftX, leftY, true, false); // Touch down
     }
     
     if (l2Released) {
-        leftPointerLocked = false; // Release lock when L2 released
-        leftLockedDirection = -1;
-        currentLHeldDirection = -1;
-        if (leftTouchActive) {
-            sendTouch(0, leftX, leftY, false, true); // Touch up
-            leftTouchActive = false;
+        slot.leftPointerLocked = false; // Release lock when L2 released
+        slot.leftLockedDirection = -1;
+        slot.currentLHeldDirection = -1;
+        if (slot.leftTouchActive) {
+            sendTouch(idBase + 0, leftX, leftY, false, true); // Touch up
+            slot.leftTouchActive = false;
         }
     }
     
     // R2 controls right touch locking
     if (r2Pressed) {
-        currentRHeldDirection = rDirection; // Capture current direction when R2 pressed
-        currentRHeldX = rightX; // Capture actual stick position
-        currentRHeldY = rightY;
-        rightTouchActive = true; // Start touch event
-        sendTouch(1, rightX, rightY, true, false); // Touch down
+        slot.currentRHeldDirection = rDirection; // Capture current direction when R2 pressed
+        slot.currentRHeldX = rightX; // Capture actual stick position
+        slot.currentRHeldY = rightY;
+        slot.rightTouchActive = true; // Start touch event
+        sendTouch(idBase + 1, rightX, rightY, true, false); // Touch down
     }
     
     if (r2Released) {
-        rightPointerLocked = false; // Release lock when R2 released
-        rightLockedDirection = -1;
-        currentRHeldDirection = -1;
-        if (rightTouchActive) {
-            sendTouch(1, rightX, rightY, false, true); // Touch up
-            rightTouchActive = false;
+        slot.rightPointerLocked = false; // Release lock when R2 released
+        slot.rightLockedDirection = -1;
+        slot.currentRHeldDirection = -1;
+        if (slot.rightTouchActive) {
+            sendTouch(idBase + 1, rightX, rightY, false, true); // Touch up
+            slot.rightTouchActive = false;
         }
     }
     
     // Handle L1 - touch ID 0 (disabled when L3 is active)
-    if (!l3TouchActive) {
-        if (l1Pressed && !leftTouchActive) {
-            leftTouchActive = true;
-            sendTouch(0, leftX, leftY, true, false); // Touch down - only send once on press
-        } else if (leftTouchActive && l1) {
+    if (!slot.l3TouchActive) {
+        if (l1Pressed && !slot.leftTouchActive) {
+            slot.leftTouchActive = true;
+            sendTouch(idBase + 0, leftX, leftY, true, false); // Touch down - only send once on press
+        } else if (slot.leftTouchActive && l1) {
             // Use helper function to handle movement updates with locking logic
-            handleTouchMovementUpdate(0, leftTouchActive, l1, l2,
-                                     currentLHeldDirection, leftPointerLocked, leftLockedDirection,
-                                     leftX, leftY, lAngle, lDirection,
-                                     rightTouchActive); // Skip if right is also active
+            handleTouchMovementUpdate(idBase + 0, slot.leftTouchActive, l1, l2,
+                                     slot.currentLHeldDirection, slot.leftPointerLocked, slot.leftLockedDirection,
+                                     leftX, leftY, lDirection,
+                                     slot.rightTouchActive); // Skip if right is also active
         }
         
-        if (l1Released && leftTouchActive) {
-            sendTouch(0, leftX, leftY, false, true); // Touch up
-            leftTouchActive = false;
+        if (l1Released && slot.leftTouchActive) {
+            sendTouch(idBase + 0, leftX, leftY, false, true); // Touch up
+            slot.leftTouchActive = false;
         }
         
         // Handle L2 movement while held
-        if (leftTouchActive && l2) {
+        if (slot.leftTouchActive && l2) {
             // Use helper function to handle movement updates with locking logic
-            handleTouchMovementUpdate(0, leftTouchActive, l1 || l2, l2,
-                                     currentLHeldDirection, leftPointerLocked, leftLockedDirection,
-                                     leftX, leftY, lAngle, lDirection,
-                                     rightTouchActive); // Skip if right is also active
+            handleTouchMovementUpdate(idBase + 0, slot.leftTouchActive, l1 || l2, l2,
+                                     slot.currentLHeldDirection, slot.leftPointerLocked, slot.leftLockedDirection,
+                                     leftX, leftY, lDirection,
+                                     slot.rightTouchActive); // Skip if right is also active
         }
     }
     
     // Handle R1 - touch ID 1 (disabled when R3 is active)
-    if (!r3TouchActive) {
-        if (r1Pressed && !rightTouchActive) {
-            rightTouchActive = true;
-            sendTouch(1, rightX, rightY, true, false); // Touch down - only send once on press
-        } else if (rightTouchActive && r1) {
+    if (!slot.r3TouchActive) {
+        if (r1Pressed && !slot.rightTouchActive) {
+            slot.rightTouchActive = true;
+            sendTouch(idBase + 1, rightX, rightY, true, false); // Touch down - only send once on press
+        } else if (slot.rightTouchActive && r1) {
             // Use helper function to handle movement updates with locking logic
-            handleTouchMovementUpdate(1, rightTouchActive, r1, r2,
-                                     currentRHeldDirection, rightPointerLocked, rightLockedDirection,
-                                     rightX, rightY, rAngle, rDirection,
-                                     leftTouchActive); // Skip if left is also active
+            handleTouchMovementUpdate(idBase + 1, slot.rightTouchActive, r1, r2,
+                                     slot.currentRHeldDirection, slot.rightPointerLocked, slot.rightLockedDirection,
+                                     rightX, rightY, rDirection,
+                                     slot.leftTouchActive); // Skip if left is also active
         }
         
-        if (r1Released && rightTouchActive) {
-            sendTouch(1, rightX, rightY, false, true); // Touch up
-            rightTouchActive = false;
+        if (r1Released && slot.rightTouchActive) {
+            sendTouch(idBase + 1, rightX, rightY, false, true); // Touch up
+            slot.rightTouchActive = false;
         }
         
         // Handle R2 movement while held
-        if (rightTouchActive && r2) {
+        if (slot.rightTouchActive && r2) {
             // Use helper function to handle movement updates with locking logic
-            handleTouchMovementUpdate(1, rightTouchActive, r1 || r2, r2,
-                                     currentRHeldDirection, rightPointerLocked, rightLockedDirection,
-                                     rightX, rightY, rAngle, rDirection,
-                                     leftTouchActive); // Skip if left is also active
+            handleTouchMovementUpdate(idBase + 1, slot.rightTouchActive, r1 || r2, r2,
+                                     slot.currentRHeldDirection, slot.rightPointerLocked, slot.rightLockedDirection,
+                                     rightX, rightY, rDirection,
+                                     slot.leftTouchActive); // Skip if left is also active
         }
     }
     
     // Send both touches together if both are active (for true multi-touch support)
     // This ensures both touches can be held independently
-    if (leftTouchActive && rightTouchActive) {
+    if (slot.leftTouchActive && slot.rightTouchActive) {
         // Calculate positions for both touches, taking locks into account
         double leftSendX = leftX, leftSendY = leftY;
         double rightSendX = rightX, rightSendY = rightY;
         
         // Check if left touch is locked
-        if (leftPointerLocked && currentLHeldDirection >= 0) {
+        if (slot.leftPointerLocked && slot.currentLHeldDirection >= 0) {
             // Use helper function to calculate locked position
-            calculateLockedPosition(currentLHeldDirection, leftLockedDirection, leftX, leftY, 
+            calculateLockedPosition(slot.currentLHeldDirection, slot.leftLockedDirection, leftX, leftY, 
                                    leftSendX, leftSendY);
         }
         
         // Check if right touch is locked
-        if (rightPointerLocked && currentRHeldDirection >= 0) {
+        if (slot.rightPointerLocked && slot.currentRHeldDirection >= 0) {
             // Use helper function to calculate locked position
-            calculateLockedPosition(currentRHeldDirection, rightLockedDirection, rightX, rightY, 
+            calculateLockedPosition(slot.currentRHeldDirection, slot.rightLockedDirection, rightX, rightY, 
                                    rightSendX, rightSendY);
         }
         
         // Send both touches together
-        sendBothTouchesIfActive(leftSendX, leftSendY, rightSendX, rightSendY,
-                                leftSendX, leftSendY, leftPointerLocked,
-                                rightSendX, rightSendY, rightPointerLocked);
+        sendBothTouchesIfActive(slot, leftSendX, leftSendY, rightSendX, rightSendY,
+                                leftSendX, leftSendY, slot.leftPointerLocked,
+                                rightSendX, rightSendY, slot.rightPointerLocked);
     }
     
     // Handle L3 - 9-touch pattern: center=0, around=2-9 (8 touches)
     // Lock out L1/L2 when L3 is active to prevent conflicts
-    if (l3Pressed && !l3TouchActive) {
-        l3TouchActive = true;
+    if (l3Pressed && !slot.l3TouchActive) {
+        slot.l3TouchActive = true;
         // Release L1/L2 if they're active (L3 takes priority)
-        if (leftTouchActive) {
-            sendTouch(0, leftX, leftY, false, true); // Touch up for L1/L2
-            leftTouchActive = false;
-            leftPointerLocked = false;
-            leftLockedDirection = -1;
-            currentLHeldDirection = -1;
+        if (slot.leftTouchActive) {
+            sendTouch(idBase + 0, leftX, leftY, false, true); // Touch up for L1/L2
+            slot.leftTouchActive = false;
+            slot.leftPointerLocked = false;
+            slot.leftLockedDirection = -1;
+            slot.currentLHeldDirection = -1;
         }
-        sendPalmTouch(leftX, leftY, 0, 2, true, false); // Use touch 0 for center, 2-9 for around
+        sendPalmTouch(leftX, leftY, idBase + 0, idBase + 2, true, false); // Use touch 0 for center, 2-9 for around
     }
     
     // Send updates every frame while L3 is held
-    if (l3TouchActive && l3) {
-        sendPalmTouch(leftX, leftY, 0, 2, false, false);
+    if (slot.l3TouchActive && l3) {
+        sendPalmTouch(leftX, leftY, idBase + 0, idBase + 2, false, false);
     }
     
-    if (l3Released && l3TouchActive) {
-        sendPalmTouch(leftX, leftY, 0, 2, false, true);
-        l3TouchActive = false;
+    if (l3Released && slot.l3TouchActive) {
+        sendPalmTouch(leftX, leftY, idBase + 0, idBase + 2, false, true);
+        slot.l3TouchActive = false;
     }
     
     // Disable L1/L2 when L3 is active
-    if (l3TouchActive) {
+    if (slot.l3TouchActive) {
         // L1/L2 are locked out when L3 is active
     } else {
         // Normal L1/L2 handling (already done above)
@@ -825,42 +811,45 @@ void ControllerMapper::handleTouchControl(bool l1, bool r1, bool l2, bool r2, bo
     
     // Handle R3 - 9-touch pattern: center=1, around=10-17 (8 touches)
     // Lock out R1/R2 when R3 is active to prevent conflicts
-    if (r3Pressed && !r3TouchActive) {
-        r3TouchActive = true;
+    if (r3Pressed && !slot.r3TouchActive) {
+        slot.r3TouchActive = true;
         // Release R1/R2 if they're active (R3 takes priority)
-        if (rightTouchActive) {
-            sendTouch(1, rightX, rightY, false, true); // Touch up for R1/R2
-            rightTouchActive = false;
-            rightPointerLocked = false;
-            rightLockedDirection = -1;
-            currentRHeldDirection = -1;
+        if (slot.rightTouchActive) {
+            sendTouch(idBase + 1, rightX, rightY, false, true); // Touch up for R1/R2
+            slot.rightTouchActive = false;
+            slot.rightPointerLocked = false;
+            slot.rightLockedDirection = -1;
+            slot.currentRHeldDirection = -1;
         }
-        sendPalmTouch(rightX, rightY, 1, 10, true, false); // Use touch 1 for center, 10-17 for around
+        sendPalmTouch(rightX, rightY, idBase + 1, idBase + 10, true, false); // Use touch 1 for center, 10-17 for around
     }
     
     // Send updates every frame while R3 is held
-    if (r3TouchActive && r3) {
-        sendPalmTouch(rightX, rightY, 1, 10, false, false);
+    if (slot.r3TouchActive && r3) {
+        sendPalmTouch(rightX, rightY, idBase + 1, idBase + 10, false, false);
     }
     
-    if (r3Released && r3TouchActive) {
-        sendPalmTouch(rightX, rightY, 1, 10, false, true);
-        r3TouchActive = false;
+    if (r3Released && slot.r3TouchActive) {
+        sendPalmTouch(rightX, rightY, idBase + 1, idBase + 10, false, true);
+        slot.r3TouchActive = false;
     }
     
     // Disable R1/R2 when R3 is active
-    if (r3TouchActive) {
+    if (slot.r3TouchActive) {
         // R1/R2 are locked out when R3 is active
     } else {
         // Normal R1/R2 handling (already done above)
     }
     
+    // Submit everything this sample produced as a single pointer frame
+    flushTouchFrame();
+    
     // Update previous button states
-    prevL1 = l1;
-    prevR1 = r1;
-    prevL2 = l2;
-    prevR2 = r2;
-    prevL3 = l3;
-    prevR3 = r3;
+    slot.prevL1 = l1;
+    slot.prevR1 = r1;
+    slot.prevL2 = l2;
+    slot.prevR2 = r2;
+    slot.prevL3 = l3;
+    slot.prevR3 = r3;
 }
 
@@ -1,6 +1,26 @@
 @echo off
-echo Building ControllerInput.exe...
-taskkill /F /IM ControllerInput.exe >nul 2>&1
+setlocal
+
+rem Targets: release (default) - /O2 + whole-program optimization (/GL, /LTCG)
+rem          pgo [trace]       - release, instrumented, trained, then relinked with the profile.
+rem                              Trains by replaying the trace (default pgo_trace.cimr, made with
+rem                              --record) through the touch path, or interactively without one
+rem          debug             - unoptimized with symbols
+rem          bench             - release flags, ControllerBench.exe (Benchmark.cpp instead of main.cpp)
+set TARGET=%~1
+if "%TARGET%"=="" set TARGET=release
+set PGO_TRACE=%~2
+if "%PGO_TRACE%"=="" set PGO_TRACE=pgo_trace.cimr
+if /I not "%TARGET%"=="release" if /I not "%TARGET%"=="pgo" if /I not "%TARGET%"=="debug" if /I not "%TARGET%"=="bench" (
+    echo Usage: build.bat [release ^| pgo [trace] ^| debug ^| bench]
+    exit /b 1
+)
+
+set OUTPUT=ControllerInput.exe
+if /I "%TARGET%"=="bench" set OUTPUT=ControllerBench.exe
+
+echo Building %OUTPUT% (%TARGET%)...
+taskkill /F /IM %OUTPUT% >nul 2>&1
 call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvars64.bat" >nul
 
 if %ERRORLEVEL% NEQ 0 (
@@ -10,9 +30,25 @@ if %ERRORLEVEL% NEQ 0 (
     exit /b 1
 )
 
+set SOURCES=main.cpp ControllerMapper.cpp TouchMode.cpp MouseMode.cpp KeyboardMode.cpp FramePacer.cpp DS4HidInput.cpp LatencyRecorder.cpp OverlayRenderer.cpp GpuOverlay.cpp DebugPanel.cpp InputReplay.cpp AsyncLog.cpp StickConditioner.cpp Profile.cpp PerfHud.cpp
+set OBJECTS=main.obj ControllerMapper.obj TouchMode.obj MouseMode.obj KeyboardMode.obj FramePacer.obj DS4HidInput.obj LatencyRecorder.obj OverlayRenderer.obj GpuOverlay.obj DebugPanel.obj InputReplay.obj AsyncLog.obj StickConditioner.obj Profile.obj PerfHud.obj
+if /I "%TARGET%"=="bench" (
+    set SOURCES=%SOURCES:main.cpp=Benchmark.cpp%
+    set OBJECTS=%OBJECTS:main.obj=Benchmark.obj%
+)
+set LIBS=dinput8.lib dxguid.lib xinput.lib user32.lib gdi32.lib msimg32.lib winmm.lib avrt.lib hid.lib setupapi.lib d3d11.lib dxgi.lib d2d1.lib dwrite.lib dcomp.lib dwmapi.lib windowsapp.lib
+
+if /I "%TARGET%"=="debug" (
+    set CFLAGS=/Od /Zi
+    set LFLAGS=/DEBUG
+) else (
+    set CFLAGS=/O2 /Oi /GL /DNDEBUG
+    set LFLAGS=/LTCG /OPT:REF /OPT:ICF
+)
+
 echo.
 echo Compiling source files...
-cl /EHsc /std:c++17 /await /nologo /MP /c main.cpp ControllerMapper.cpp TouchMode.cpp MouseMode.cpp KeyboardMode.cpp 2>&1
+cl /EHsc /std:c++17 /await /nologo /MP %CFLAGS% /c %SOURCES% 2>&1
 set COMPILE_ERROR=%ERRORLEVEL%
 if %COMPILE_ERROR% NEQ 0 (
     echo.
@@ -25,24 +61,61 @@ if %COMPILE_ERROR% NEQ 0 (
     exit /b 1
 )
 
+if /I not "%TARGET%"=="pgo" goto link
+
+rem ---- PGO: instrumented link, training run, then the optimized link below ----
 echo.
-echo Linking...
-link /nologo main.obj ControllerMapper.obj TouchMode.obj MouseMode.obj KeyboardMode.obj dinput8.lib dxguid.lib xinput.lib user32.lib gdi32.lib msimg32.lib windowsapp.lib /out:ControllerInput.exe 2>&1
-set LINK_ERROR=%ERRORLEVEL%
-if %LINK_ERROR% EQU 0 (
-    del main.obj ControllerMapper.obj TouchMode.obj MouseMode.obj KeyboardMode.obj >nul 2>&1
-    mt.exe -manifest ControllerInput.manifest -outputresource:ControllerInput.exe;1 >nul 2>&1
-    echo.
-    echo ========================================
-    echo [SUCCESS] ControllerInput.exe built!
-    echo ========================================
-) else (
-    echo.
-    echo ========================================
-    echo [FAILED] Linking errors detected
-    echo ========================================
+echo Linking instrumented build...
+del ControllerInput*.pgc ControllerInput.pgd >nul 2>&1
+link /nologo %OBJECTS% %LIBS% %LFLAGS% /GENPROFILE /out:ControllerInput.exe 2>&1
+if %ERRORLEVEL% NEQ 0 goto linkfailed
+mt.exe -manifest ControllerInput.manifest -outputresource:ControllerInput.exe;1 >nul 2>&1
+
+echo.
+echo ========================================
+echo PGO training run
+echo ========================================
+if exist "%PGO_TRACE%" goto replaytrace
+echo No trace at %PGO_TRACE% - training interactively.
+echo Use the instrumented build as you normally would (touch mode, sticks, L1/R1,
+echo L2 locks, L3/R3 palms) for a minute, then close it with Ctrl+C.
+echo Record a trace once with "ControllerInput.exe --record %PGO_TRACE%" to automate this.
+echo.
+ControllerInput.exe
+goto trained
+:replaytrace
+echo Replaying %PGO_TRACE%...
+ControllerInput.exe --replay "%PGO_TRACE%" --replay-fast
+:trained
+if not exist ControllerInput*.pgc (
     echo.
-    echo Check the error messages above for details.
+    echo [FAILED] The training run produced no profile data
     pause
     exit /b 1
 )
+set LFLAGS=%LFLAGS% /USEPROFILE
+
+:link
+echo.
+echo Linking...
+link /nologo %OBJECTS% %LIBS% %LFLAGS% /out:%OUTPUT% 2>&1
+if %ERRORLEVEL% NEQ 0 goto linkfailed
+
+del %OBJECTS% >nul 2>&1
+if /I "%TARGET%"=="pgo" del ControllerInput*.pgc >nul 2>&1
+mt.exe -manifest ControllerInput.manifest -outputresource:%OUTPUT%;1 >nul 2>&1
+echo.
+echo ========================================
+echo [SUCCESS] %OUTPUT% built! (%TARGET%)
+echo ========================================
+exit /b 0
+
+:linkfailed
+echo.
+echo ========================================
+echo [FAILED] Linking errors detected
+echo ========================================
+echo.
+echo Check the error messages above for details.
+pause
+exit /b 1
@@ -1,54 +1,235 @@
 #include "ControllerInput.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     // Allocate console for debug output
     AllocConsole();
     freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
     freopen_s((FILE**)stderr, "CONOUT$", "w", stderr);
     
+    // ========== Command Line ==========
+    // --record <file>   Record every controller sample of the first session
+    // --replay <file>   Replay a recording with injection disabled, then exit
+    // --replay-fast     Replay as fast as possible instead of at the recorded timing
+    // --log <file>      Also append the polling/overlay thread log to a file
+    // --predict <ms>    Default touch mode slide look-ahead (0 = off)
+    // --upsample <hz>   Interpolate touch updates between controller reports at this rate
+    // --idle <ms>       Neutral input this long lowers the poll rate until the next input (0 = never;
+    //                   event-driven controllers only)
+    // --deadzone <r>, --axial-deadzone <v>, --anti-deadzone <r>, --outer-deadzone <r>,
+    // --curve <exponent>, --trigger-threshold <0-255>   Stick conditioning (see README)
+    // --di-buttons <l1,r1,l2,r2,l3,r3>   DirectInput button numbers of the mapped buttons
+    // --layout <file>   Keyboard mode sector layout (see README)
+    // --profile <file>  Session profile (default: ControllerInput.profile next to the exe)
+    // --setup           Ignore the profile: show the menus and save the answers as the profile
+    std::string profilePath = ControllerMapper::defaultProfilePath();
+    bool runSetup = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (arg == "--setup") {
+            runSetup = true;
+        }
+    }
+    
+    // Applied on top of the profile every time it's loaded, so the command line always wins
+    auto applyArguments = [&](MapperSettings& settings) -> bool {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--record" && i + 1 < argc) {
+                settings.recordPath = argv[++i];
+            } else if (arg == "--replay" && i + 1 < argc) {
+                settings.replayPath = argv[++i];
+            } else if (arg == "--replay-fast") {
+                settings.replayFullSpeed = true;
+            } else if (arg == "--log" && i + 1 < argc) {
+                settings.logPath = argv[++i];
+            } else if (arg == "--predict" && i + 1 < argc) {
+                settings.predictionMs = atoi(argv[++i]);
+            } else if (arg == "--upsample" && i + 1 < argc) {
+                settings.touchUpsampleHz = atoi(argv[++i]);
+            } else if (arg == "--idle" && i + 1 < argc) {
+                settings.idleMs = atoi(argv[++i]);
+            } else if (arg == "--deadzone" && i + 1 < argc) {
+                settings.conditioning.radialDeadzone = atof(argv[++i]);
+            } else if (arg == "--axial-deadzone" && i + 1 < argc) {
+                settings.conditioning.axialDeadzone = atof(argv[++i]);
+            } else if (arg == "--anti-deadzone" && i + 1 < argc) {
+                settings.conditioning.antiDeadzone = atof(argv[++i]);
+            } else if (arg == "--outer-deadzone" && i + 1 < argc) {
+                settings.conditioning.outerDeadzone = atof(argv[++i]);
+            } else if (arg == "--curve" && i + 1 < argc) {
+                settings.conditioning.curve = atof(argv[++i]);
+            } else if (arg == "--trigger-threshold" && i + 1 < argc) {
+                settings.conditioning.triggerThreshold = atoi(argv[++i]);
+            } else if (arg == "--di-buttons" && i + 1 < argc) {
+                int b[6];
+                if (sscanf_s(argv[++i], "%d,%d,%d,%d,%d,%d", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+                    return false;
+                }
+                for (int& button : b) {
+                    if (button < 0 || button > 127) return false;
+                }
+                settings.diButtons = { (BYTE)b[0], (BYTE)b[1], (BYTE)b[2], (BYTE)b[3], (BYTE)b[4], (BYTE)b[5] };
+            } else if (arg == "--layout" && i + 1 < argc) {
+                settings.layoutPath = argv[++i];
+            } else if (arg == "--profile" && i + 1 < argc) {
+                i++;  // Read above
+            } else if (arg == "--setup") {
+                // Read above
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+    
+    MapperSettings arguments;
+    if (!applyArguments(arguments)) {
+        std::cerr << "Usage: ControllerInput.exe [--record <file>] [--replay <file> [--replay-fast]] [--log <file>] [--predict <ms>] [--upsample <hz>] [--idle <ms>]"
+                  << " [--deadzone <r>] [--axial-deadzone <v>] [--anti-deadzone <r>] [--outer-deadzone <r>]"
+                  << " [--curve <exponent>] [--trigger-threshold <0-255>] [--di-buttons <l1,r1,l2,r2,l3,r3>] [--layout <file>]"
+                  << " [--profile <file>] [--setup]" << std::endl;
+        return 1;
+    }
+    
+    // Replay needs no menus or profile - mode comes from the recording, the rest from the command line
+    if (!arguments.replayPath.empty()) {
+        ControllerMapper app(arguments);
+        if (!app.initialize()) {
+            std::cerr << "[ERROR] Failed to initialize replay!" << std::endl;
+            return 1;
+        }
+        app.run();
+        return 0;
+    }
+    
     // Main loop: Show mode selection → Run app → On restart, loop back
+    bool firstSession = true;
     while (true) {
-        // ========== Mode Selection Menu ==========
-        std::cout << "========================================" << std::endl;
-        std::cout << "    CONTROLLER INPUT MAPPER" << std::endl;
-        std::cout << "========================================" << std::endl;
-        std::cout << std::endl;
-        std::cout << "Choose input mode:" << std::endl;
-        std::cout << std::endl;
-        std::cout << "  [1] Touch Mode (Simulate Windows Touch Input)" << std::endl;
-        std::cout << std::endl;
-        std::cout << "  [2] Mouse Mode (Control Mouse Cursor)" << std::endl;
-        std::cout << std::endl;
-        std::cout << "  [3] Keyboard Mode (Control Keyboard Keys)" << std::endl;
-        std::cout << std::endl;
-        std::cout << "Select mode (1-3): ";
+        // ========== Session Profile ==========
+        // A saved profile answers every menu below and names the controllers to open
+        MapperSettings settings;
+        bool haveProfile = !runSetup && ControllerMapper::loadProfile(profilePath, settings);
+        applyArguments(settings);
+        settings.profilePath = profilePath;
+        if (!firstSession) {
+            settings.recordPath.clear(); // Only the first session is recorded - a restart would overwrite it
+        }
+        if (haveProfile) {
+            std::cout << "Using profile " << profilePath << " (start with --setup to choose again)" << std::endl << std::endl;
+        } else {
+            // ========== Mode Selection Menu ==========
+            std::cout << "========================================" << std::endl;
+            std::cout << "    CONTROLLER INPUT MAPPER" << std::endl;
+            std::cout << "========================================" << std::endl;
+            std::cout << std::endl;
+            std::cout << "Choose input mode:" << std::endl;
+            std::cout << std::endl;
+            std::cout << "  [1] Touch Mode (Simulate Windows Touch Input)" << std::endl;
+            std::cout << std::endl;
+            std::cout << "  [2] Mouse Mode (Control Mouse Cursor)" << std::endl;
+            std::cout << std::endl;
+            std::cout << "  [3] Keyboard Mode (Control Keyboard Keys)" << std::endl;
+            std::cout << std::endl;
+            std::cout << "Select mode (1-3): ";
         
-        InputMode selectedMode = InputMode::Touch; // Default
-        char choice = _getch();
-        std::cout << choice << std::endl << std::endl;
+            InputMode selectedMode = InputMode::Touch; // Default
+            char choice = _getch();
+            std::cout << choice << std::endl << std::endl;
         
-        switch (choice) {
-            case '1':
-                selectedMode = InputMode::Touch;
-                std::cout << "Starting in TOUCH mode..." << std::endl;
-                break;
-            case '2':
-                selectedMode = InputMode::Mouse;
-                std::cout << "Starting in MOUSE mode..." << std::endl;
-                break;
-            case '3':
-                selectedMode = InputMode::Keyboard;
-                std::cout << "Starting in KEYBOARD mode..." << std::endl;
-                break;
-            default:
-                std::cout << "Invalid choice. Please select 1, 2, or 3." << std::endl;
+            switch (choice) {
+                case '1':
+                    selectedMode = InputMode::Touch;
+                    std::cout << "Starting in TOUCH mode..." << std::endl;
+                    break;
+                case '2':
+                    selectedMode = InputMode::Mouse;
+                    std::cout << "Starting in MOUSE mode..." << std::endl;
+                    break;
+                case '3':
+                    selectedMode = InputMode::Keyboard;
+                    std::cout << "Starting in KEYBOARD mode..." << std::endl;
+                    break;
+                default:
+                    std::cout << "Invalid choice. Please select 1, 2, or 3." << std::endl;
+                    std::cout << std::endl;
+                    continue; // Go back to mode selection
+            }
+            std::cout << std::endl;
+        
+            // ========== Polling Rate Selection ==========
+            settings.mode = selectedMode;
+        
+            std::cout << "Choose controller polling rate:" << std::endl;
+            std::cout << "  [1] 250 Hz    [2] 500 Hz    [3] 1000 Hz (default)" << std::endl;
+            std::cout << "Select rate (1-3, any other key for default): ";
+        
+            char rateChoice = _getch();
+            std::cout << rateChoice << std::endl;
+            switch (rateChoice) {
+                case '1': settings.pollRateHz = 250; break;
+                case '2': settings.pollRateHz = 500; break;
+                default:  settings.pollRateHz = 1000; break;
+            }
+            std::cout << "Polling at " << settings.pollRateHz << " Hz" << std::endl << std::endl;
+        
+            // ========== Palm Injection Selection (Touch mode only) ==========
+            if (selectedMode == InputMode::Touch) {
+                std::cout << "Choose L3/R3 palm injection:" << std::endl;
+                std::cout << "  [1] Atomic (default)    [2] Staggered (" << settings.palmStaggerUs << "us)    [3] Serialized (legacy)" << std::endl;
+                std::cout << "Select palm mode (1-3, any other key for default): ";
+            
+                char palmChoice = _getch();
+                std::cout << palmChoice << std::endl;
+                switch (palmChoice) {
+                    case '2': settings.palmMode = PalmInjectionMode::Staggered; break;
+                    case '3': settings.palmMode = PalmInjectionMode::Serialized; break;
+                    default:  settings.palmMode = PalmInjectionMode::Atomic; break;
+                }
                 std::cout << std::endl;
-                continue; // Go back to mode selection
+            
+                int predictionMs = settings.predictionMs;  // --predict, or off
+                std::cout << "Choose slide prediction (touches lead the stick, off on L2/R2 locked paths):" << std::endl;
+                std::cout << "  [1] Off    [2] 4ms    [3] 8ms    [4] 12ms    (default: ";
+                if (predictionMs > 0) {
+                    std::cout << predictionMs << "ms)" << std::endl;
+                } else {
+                    std::cout << "off)" << std::endl;
+                }
+                std::cout << "Select prediction (1-4, any other key for default): ";
+            
+                char predictChoice = _getch();
+                std::cout << predictChoice << std::endl;
+                switch (predictChoice) {
+                    case '1': settings.predictionMs = 0; break;
+                    case '2': settings.predictionMs = 4; break;
+                    case '3': settings.predictionMs = 8; break;
+                    case '4': settings.predictionMs = 12; break;
+                    default:  settings.predictionMs = predictionMs; break;
+                }
+                std::cout << std::endl;
+            }
+        
+            // ========== Overlay Backend Selection ==========
+            std::cout << "Choose overlay renderer:" << std::endl;
+            std::cout << "  [1] Per-pixel alpha (default)    [2] Color-key GDI (legacy)    [3] GPU (Direct2D, vblank-synced)" << std::endl;
+            std::cout << "Select renderer (1-3, any other key for default): ";
+        
+            char overlayChoice = _getch();
+            std::cout << overlayChoice << std::endl << std::endl;
+            switch (overlayChoice) {
+                case '2': settings.overlayBackend = OverlayBackend::ColorKeyGdi; break;
+                case '3': settings.overlayBackend = OverlayBackend::GpuComposition; break;
+                default:  settings.overlayBackend = OverlayBackend::LayeredAlpha; break;
+            }
         }
-        std::cout << std::endl;
-
+        firstSession = false;
+        runSetup = false;  // --setup asks once; restarts use what it saved
+        
         try {
-            ControllerMapper app(selectedMode);
+            ControllerMapper app(settings);
             if (!app.initialize()) {
                 std::cerr << "[ERROR] Failed to initialize application!" << std::endl;
                 continue;